@@ -5,18 +5,24 @@
 #include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
 #include "driver/driver.h"
 #include "driver/env.h"
 #include "driver/events.h"
 #include "driver/window.h"
 #include "utils/config.h"
+#include "utils/log_sinks.h"
+#include "utils/metrics.h"
+#include "utils/spans.h"
 #include "utils/tracing.h"
 
 using std::cout;
 using std::endl;
 
+using absl::InvalidArgumentError;
 using absl::OkStatus;
 using absl::Status;
+using absl::StatusOr;
 using fmt::format;
 using sf::Color;
 using sf::Event;
@@ -25,11 +31,104 @@ using sf::RenderWindow;
 using sf::VideoMode;
 using std::unique_ptr;
 
-auto Main() -> Status {
+/// @brief The command line options.
+struct Options {
+  /// @brief How (and whether) frames are exported.
+  driver::ExportOptions export_options;
+  /// @brief Where recorded spans are written on exit (spans are recorded from
+  /// startup when set).
+  std::string trace_output;
+  /// @brief Where metrics are written on exit (Prometheus text format).
+  std::string metrics_output;
+  /// @brief Where log messages are written, besides the console (rotated
+  /// like `config::LOG_FILE_MAX_BYTES` says).
+  std::string log_output;
+  /// @brief Whether log files are appended to through a memory mapping.
+  bool log_mmap = false;
+};
+
+/// @brief Parses the command line.
+///
+/// ```sh
+/// main [--export <dir|file|->] [--format png|raw] [--frames <n>]
+///      [--threads <n>] [--headless] [--trace <file>] [--metrics <file>]
+///      [--log <file>] [--log-mmap]
+/// ```
+auto ParseOptions(int argc, char** argv) -> StatusOr<Options> {
+  Options parsed;
+  auto& options = parsed.export_options;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg = argv[i];
+    if (arg == "--headless") {
+      options.headless = true;
+      continue;
+    }
+    if (arg == "--log-mmap") {
+      parsed.log_mmap = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return InvalidArgumentError(format("Missing value for {}", arg));
+    }
+    const char* value = argv[++i];
+    if (arg == "--export") {
+      options.output = value;
+    } else if (arg == "--trace") {
+      parsed.trace_output = value;
+    } else if (arg == "--metrics") {
+      parsed.metrics_output = value;
+    } else if (arg == "--log") {
+      parsed.log_output = value;
+    } else if (arg == "--format" && std::string_view(value) == "png") {
+      options.format = driver::FrameFormat::Png;
+    } else if (arg == "--format" && std::string_view(value) == "raw") {
+      options.format = driver::FrameFormat::Raw;
+    } else if (arg == "--frames") {
+      if (!absl::SimpleAtoi(value, &options.frames)) {
+        return InvalidArgumentError(format("Invalid frame count: {}", value));
+      }
+    } else if (arg == "--threads") {
+      if (!absl::SimpleAtoi(value, &options.threads) || options.threads == 0) {
+        return InvalidArgumentError(format("Invalid thread count: {}", value));
+      }
+    } else {
+      return InvalidArgumentError(
+          format("Unknown argument: {} {}", arg, value));
+    }
+  }
+  if (options.headless && !options.enabled()) {
+    return InvalidArgumentError("--headless requires --export");
+  }
+  return parsed;
+}
+
+/// @brief The log sinks selected on the command line.
+auto LogSinks(const Options& options)
+    -> std::vector<unique_ptr<tracing::LogSink>> {
+  std::vector<unique_ptr<tracing::LogSink>> sinks;
+  // Keep stdout clean when raw frames are piped through it
+  const auto to_stdout = options.export_options.output == "-";
+  sinks.push_back(
+      std::make_unique<tracing::ConsoleSink>(to_stdout ? stderr : stdout));
+  if (!options.log_output.empty()) {
+    tracing::FileSinkOptions file{.path = options.log_output,
+                                  .mmap = options.log_mmap};
+    sinks.push_back(std::make_unique<tracing::FileSink>(std::move(file)));
+  }
+  return sinks;
+}
+
+auto Main(int argc, char** argv) -> Status {
   // unique_ptr<RenderWindow> window;
   // driver::init_window(window);
 
-  tracing::init();
+  auto options = ParseOptions(argc, argv);
+  if (!options.ok()) {
+    tracing::error(options.status().ToString());
+    return options.status();
+  }
+  tracing::init(LogSinks(*options));
+  if (!options->trace_output.empty()) tracing::start_span_recording();
 
   // -- OLD START --
 
@@ -72,10 +171,21 @@ auto Main() -> Status {
   // Initialize the driver (e.g. create the game state - nodes, edges, etc.)
   // auto driver2 = make_unique<driver2::GameState>(window);
   // auto driver2 = driver::GameState::build();
-  auto simulation_driver = driver::init();
+  auto simulation_driver = driver::init(std::move(options->export_options));
 
   simulation_driver->main_loop();
 
+  if (!options->trace_output.empty()) {
+    tracing::stop_span_recording();
+    if (!tracing::write_chrome_trace(options->trace_output)) {
+      tracing::error("Failed to write {}", options->trace_output);
+    }
+  }
+  if (!options->metrics_output.empty() &&
+      !tracing::metrics().write_prometheus(options->metrics_output)) {
+    tracing::error("Failed to write {}", options->metrics_output);
+  }
+
   // -- OLD MAIN LOOP --
   // Process events
   // driver::process_events(window);
@@ -94,4 +204,4 @@ auto Main() -> Status {
   return OkStatus();
 }
 
-auto main() -> int { return Main().raw_code(); }
+auto main(int argc, char** argv) -> int { return Main(argc, argv).raw_code(); }
@@ -0,0 +1,402 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/config.h"
+#include "utils/data_structures/intern.h"
+#include "utils/data_structures/string.h"
+#include "utils/metrics.h"
+#include "utils/spans.h"
+#include "utils/tracing.h"
+
+using sf::Font;
+using sf::Image;
+using sf::IntRect;
+using sf::Texture;
+using std::optional;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace driver {
+
+/// @brief Identifies an asset requested from an `AssetManager`.
+using AssetId = uint32_t;
+
+/// @brief The state of a requested asset.
+enum class AssetState {
+  /// @brief The asset is being loaded on the background thread.
+  Loading,
+  /// @brief The asset is loaded and can be used.
+  Ready,
+  /// @brief The asset could not be loaded.
+  Failed,
+};
+
+/// @brief Packs rectangles into a fixed-size area, row by row ("shelves").
+/// Good enough for a handful of similarly sized sprites.
+class ShelfPacker {
+ public:
+  ShelfPacker(unsigned width, unsigned height)
+      : width_(width), height_(height) {}
+
+  /// @brief Reserves a `width` x `height` area.
+  /// @return The top-left corner of the area, or `nullopt` if it doesn't fit.
+  auto pack(unsigned width, unsigned height) -> optional<sf::Vector2u> {
+    const auto padded_width = width + config::ATLAS_PADDING;
+    const auto padded_height = height + config::ATLAS_PADDING;
+    if (padded_width > width_) return std::nullopt;
+    if (x_ + padded_width > width_) {
+      // Start a new shelf below the current one
+      x_ = 0;
+      y_ += shelf_height_;
+      shelf_height_ = 0;
+    }
+    if (y_ + padded_height > height_) return std::nullopt;
+
+    const auto position = sf::Vector2u(x_, y_);
+    x_ += padded_width;
+    shelf_height_ = std::max(shelf_height_, padded_height);
+    return position;
+  }
+
+ private:
+  unsigned width_;
+  unsigned height_;
+  /// @brief The next free position on the current shelf.
+  unsigned x_ = 0;
+  unsigned y_ = 0;
+  /// @brief The height of the tallest rectangle on the current shelf.
+  unsigned shelf_height_ = 0;
+};
+
+/// @brief Downscales an image by an integer factor (box filter).
+/// @param image The image to downscale.
+/// @param factor The factor to shrink both dimensions by.
+/// @return The downscaled image.
+inline auto downscale(const Image& image, unsigned factor) -> Image {
+  const auto size = image.getSize();
+  const auto width = std::max(1u, size.x / factor);
+  const auto height = std::max(1u, size.y / factor);
+  const auto pixels = image.getPixelsPtr();
+
+  vector<sf::Uint8> scaled(size_t{width} * height * 4);
+  for (unsigned y = 0; y < height; y++) {
+    for (unsigned x = 0; x < width; x++) {
+      unsigned sum[4] = {0, 0, 0, 0};
+      unsigned count = 0;
+      for (unsigned dy = 0; dy < factor && y * factor + dy < size.y; dy++) {
+        for (unsigned dx = 0; dx < factor && x * factor + dx < size.x; dx++) {
+          const auto src =
+              pixels + (size_t{y * factor + dy} * size.x + x * factor + dx) * 4;
+          for (int c = 0; c < 4; c++) sum[c] += src[c];
+          count++;
+        }
+      }
+      auto dst = &scaled[(size_t{y} * width + x) * 4];
+      for (int c = 0; c < 4; c++) {
+        dst[c] = static_cast<sf::Uint8>(sum[c] / count);
+      }
+    }
+  }
+
+  Image result;
+  result.create(width, height, scaled.data());
+  return result;
+}
+
+/// @brief Loads textures and fonts on a background thread.
+///
+/// Requests return an `AssetId` immediately (the same id for the same path,
+/// so every asset is only loaded once) and never touch the disk on the
+/// calling thread. The render thread calls `poll()` once per frame to pick up
+/// finished loads.
+///
+/// Small images (up to `config::ATLAS_MAX_ENTRY_SIZE`, optionally after
+/// downscaling) are packed into a single shared atlas texture, so nodes using
+/// different images can still be drawn in a single batch. Larger images get a
+/// texture of their own.
+class AssetManager {
+ public:
+  AssetManager() : packer_(config::ATLAS_SIZE, config::ATLAS_SIZE) {
+    if (!atlas_.create(config::ATLAS_SIZE, config::ATLAS_SIZE)) {
+      tracing::error("Failed to create texture atlas");
+    }
+    // Untextured sprites sample the top-left texel, so keeping it white lets
+    // them share the atlas (and a draw call) with textured ones
+    Image white;
+    white.create(2, 2, sf::Color::White);
+    packer_.pack(2, 2);
+    atlas_.update(white, 0, 0);
+    loader_ = std::thread([this] { load_assets(); });
+  }
+
+  AssetManager(const AssetManager&) = delete;
+  auto operator=(const AssetManager&) -> AssetManager& = delete;
+
+  ~AssetManager() {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    requested_.notify_one();
+    loader_.join();
+  }
+
+  /// @brief Requests a texture.
+  /// @param path The path of the image to load.
+  /// @param max_size Images larger than this (in either dimension) are
+  ///                 downscaled on the loader thread so they fit the atlas.
+  /// @return The id of the texture (see `rect()` and `texture()`).
+  auto request_texture(const string& path,
+                       unsigned max_size = config::ATLAS_MAX_ENTRY_SIZE)
+      -> AssetId {
+    return request(path, Kind::Texture, max_size);
+  }
+
+  /// @brief Requests a font.
+  /// @param path The path of the font to load.
+  /// @return The id of the font (see `font()`).
+  auto request_font(const string& path) -> AssetId {
+    return request(path, Kind::Font, 0);
+  }
+
+  /// @brief Picks up assets loaded since the last call, packing textures into
+  /// the atlas (render thread, once per frame).
+  /// @return The number of assets that became ready or failed.
+  auto poll() -> size_t {
+    std::deque<Loaded> loaded;
+    {
+      std::lock_guard lock(mutex_);
+      loaded.swap(loaded_);
+    }
+
+    for (auto& result : loaded) {
+      auto& entry = entries_[result.id];
+      if (result.font) {
+        entry.font = std::move(result.font);
+        entry.state = AssetState::Ready;
+      } else if (result.image) {
+        upload(entry, *result.image);
+      } else {
+        entry.state = AssetState::Failed;
+        failed_.add();
+        tracing::error("Failed to load asset {}", entry.path.view());
+      }
+    }
+    return loaded.size();
+  }
+
+  /// @brief The state of the given asset.
+  auto state(AssetId id) const { return entries_[id].state; }
+
+  /// @brief Whether the given asset is loaded.
+  auto ready(AssetId id) const { return state(id) == AssetState::Ready; }
+
+  /// @brief Whether every requested asset is either loaded or failed.
+  auto idle() const {
+    return std::none_of(entries_.begin(), entries_.end(), [](const auto& e) {
+      return e.state == AssetState::Loading;
+    });
+  }
+
+  /// @brief The texture holding the given (ready) texture asset: the shared
+  /// atlas for small images, a standalone texture for large ones.
+  auto texture(AssetId id) const -> const Texture* {
+    const auto& entry = entries_[id];
+    if (entry.state != AssetState::Ready) return nullptr;
+    return entry.standalone ? entry.standalone.get() : &atlas_;
+  }
+
+  /// @brief The area of `texture(id)` holding the given texture asset.
+  auto rect(AssetId id) const { return entries_[id].rect; }
+
+  /// @brief The given (ready) font asset, or `nullptr`.
+  auto font(AssetId id) const -> const Font* {
+    return entries_[id].font.get();
+  }
+
+  /// @brief The shared texture atlas.
+  auto atlas() const -> const Texture& { return atlas_; }
+
+ private:
+  /// @brief The kind of asset.
+  enum class Kind { Texture, Font };
+
+  /// @brief A requested asset (render thread only).
+  struct Entry {
+    data_structures::string::String path;
+    Kind kind;
+    AssetState state = AssetState::Loading;
+    /// @brief The area of the texture holding the image.
+    IntRect rect;
+    /// @brief The texture of an image too large for the atlas.
+    unique_ptr<Texture> standalone;
+    /// @brief The loaded font.
+    unique_ptr<Font> font;
+  };
+
+  /// @brief What a request asked for. Requests for the same path as a
+  /// different kind or size are different assets.
+  struct RequestKey {
+    data_structures::string::Symbol path;
+    Kind kind;
+    unsigned max_size;
+
+    auto operator==(const RequestKey&) const -> bool = default;
+  };
+
+  /// @brief Hashes a `RequestKey`.
+  struct RequestKeyHash {
+    auto operator()(const RequestKey& key) const -> size_t {
+      const auto path = std::hash<data_structures::string::Symbol>()(key.path);
+      const auto rest = static_cast<uint64_t>(key.kind) << 32 | key.max_size;
+      return static_cast<size_t>(path * 0x9E3779B97F4A7C15ull ^ rest);
+    }
+  };
+
+  /// @brief An asset waiting to be loaded (render thread -> loader thread).
+  struct Pending {
+    AssetId id;
+    string path;
+    Kind kind;
+    unsigned max_size;
+  };
+
+  /// @brief A loaded asset (loader thread -> render thread). Both pointers are
+  /// empty if loading failed.
+  struct Loaded {
+    AssetId id;
+    optional<Image> image;
+    unique_ptr<Font> font;
+  };
+
+  auto request(const string& path, Kind kind, unsigned max_size) -> AssetId {
+    const RequestKey key{data_structures::string::intern(path), kind,
+                         max_size};
+    if (auto it = ids_.find(key); it != ids_.end()) return it->second;
+
+    const auto id = static_cast<AssetId>(entries_.size());
+    entries_.push_back(Entry{path, kind, AssetState::Loading, IntRect(),
+                             nullptr, nullptr});
+    ids_.emplace(key, id);
+    {
+      std::lock_guard lock(mutex_);
+      pending_.push_back(Pending{id, path, kind, max_size});
+    }
+    requested_.notify_one();
+    tracing::debug("Requested asset {}", path);
+    return id;
+  }
+
+  /// @brief Copies a loaded image into the atlas (or its own texture).
+  auto upload(Entry& entry, const Image& image) -> void {
+    const auto size = image.getSize();
+    const auto position = size.x <= config::ATLAS_MAX_ENTRY_SIZE &&
+                                  size.y <= config::ATLAS_MAX_ENTRY_SIZE
+                              ? packer_.pack(size.x, size.y)
+                              : std::nullopt;
+    if (position) {
+      atlas_.update(image, position->x, position->y);
+      entry.rect = IntRect(position->x, position->y, size.x, size.y);
+      atlas_bytes_.add(size.x * size.y * 4.0);
+    } else {
+      tracing::warn("{} does not fit the texture atlas", entry.path.view());
+      entry.standalone = std::make_unique<Texture>();
+      entry.standalone->loadFromImage(image);
+      entry.rect = IntRect(0, 0, size.x, size.y);
+      texture_bytes_.add(size.x * size.y * 4.0);
+    }
+    entry.state = AssetState::Ready;
+    loaded_count_.add();
+    tracing::info("Loaded {} ({}x{})", entry.path.view(), size.x, size.y);
+  }
+
+  /// @brief Loader thread body: loads pending assets until destruction.
+  auto load_assets() -> void {
+    tracing::set_thread_name("asset loader");
+    while (true) {
+      std::unique_lock lock(mutex_);
+      requested_.wait(lock, [this] { return !pending_.empty() || stopping_; });
+      if (stopping_) return;
+      auto pending = std::move(pending_.front());
+      pending_.pop_front();
+      lock.unlock();
+
+      auto loaded = load(pending);
+
+      lock.lock();
+      loaded_.push_back(std::move(loaded));
+    }
+  }
+
+  /// @brief Reads a single asset from disk (loader thread).
+  static auto load(const Pending& pending) -> Loaded {
+    tracing::Span span("load_asset", "assets");
+    Loaded loaded{pending.id, std::nullopt, nullptr};
+    if (pending.kind == Kind::Font) {
+      auto font = std::make_unique<Font>();
+      if (font->loadFromFile(pending.path)) loaded.font = std::move(font);
+      return loaded;
+    }
+
+    Image image;
+    if (!image.loadFromFile(pending.path)) return loaded;
+    const auto size = image.getSize();
+    const auto largest = std::max(size.x, size.y);
+    if (pending.max_size > 0 && largest > pending.max_size) {
+      const auto factor = (largest + pending.max_size - 1) / pending.max_size;
+      image = downscale(image, factor);
+    }
+    loaded.image = std::move(image);
+    return loaded;
+  }
+
+  /// @brief Every requested asset, indexed by `AssetId` (render thread only).
+  vector<Entry> entries_;
+  /// @brief Deduplicates requests by path, kind and size (render thread
+  /// only).
+  std::unordered_map<RequestKey, AssetId, RequestKeyHash> ids_;
+
+  /// @brief The shared texture small images are packed into.
+  Texture atlas_;
+  /// @brief Allocates space in `atlas_`.
+  ShelfPacker packer_;
+
+  /// @brief Guards `pending_`, `loaded_` and `stopping_`.
+  std::mutex mutex_;
+  /// @brief Signalled when an asset is requested (or on destruction).
+  std::condition_variable requested_;
+  /// @brief Assets waiting to be loaded.
+  std::deque<Pending> pending_;
+  /// @brief Assets loaded but not yet picked up by `poll()`.
+  std::deque<Loaded> loaded_;
+  /// @brief Set on destruction to stop the loader thread.
+  bool stopping_ = false;
+
+  /// @brief Loads assets in the background.
+  std::thread loader_;
+
+  tracing::Counter& loaded_count_ =
+      tracing::metrics().counter("assets_loaded_total", "Textures loaded");
+  tracing::Counter& failed_ = tracing::metrics().counter(
+      "assets_failed_total", "Assets that failed to load");
+  tracing::Gauge& atlas_bytes_ = tracing::metrics().gauge(
+      "assets_atlas_bytes_used", "Bytes of the texture atlas in use");
+  tracing::Gauge& texture_bytes_ = tracing::metrics().gauge(
+      "assets_standalone_texture_bytes", "Bytes of standalone textures");
+};
+
+}  // namespace driver
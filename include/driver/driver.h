@@ -3,10 +3,22 @@
 #include <SFML/Graphics.hpp>
 #include <algorithm>
 #include <iostream>
+#include <atomic>
+#include <optional>
 #include <ranges>
+#include <thread>
 
+#include "driver/assets.h"
 #include "driver/events.h"
+#include "driver/frame_export.h"
+#include "driver/profiler.h"
+#include "driver/replay.h"
 #include "graph/graph.h"
+#include "graph/search.h"
+#include "graph/spanning_tree.h"
+#include "utils/log_sampling.h"
+#include "utils/metrics.h"
+#include "utils/spans.h"
 
 using fmt::format;
 using sf::Color;
@@ -27,32 +39,43 @@ using tracing::warn;
 namespace driver {
 
 const static auto TEXTURE_PATH = "assets/ball0.png";
-// const static auto TEXTURE_PATH = "assets/high_res_boid.png";
+/// @brief The texture of the source and target nodes.
+const static auto ENDPOINT_TEXTURE_PATH = "assets/high_res_boid.png";
 
 class GameState {
  public:
-  GameState() {
-    tracing::trace("Initializing window...");
-    if (config::DEBUG_MODE) {
-      tracing::info("Debug mode enabled");
-      window_ = std::make_unique<RenderWindow>(
-          VideoMode(config::DEBUG_WINDOW_WIDTH, config::DEBUG_WINDOW_HEIGHT),
-          config::WINDOW_TITLE);
-      window_->setFramerateLimit(config::MAX_FPS);
-    } else {
-      window_ = std::make_unique<RenderWindow>(
-          VideoMode(config::PROD_WINDOW_WIDTH, config::PROD_WINDOW_HEIGHT),
-          config::WINDOW_TITLE);
+  explicit GameState(ExportOptions export_options = {})
+      : export_options_(std::move(export_options)) {
+    tracing::set_thread_name("main");
+    const auto video_mode =
+        config::DEBUG_MODE
+            ? VideoMode(config::DEBUG_WINDOW_WIDTH, config::DEBUG_WINDOW_HEIGHT)
+            : VideoMode(config::PROD_WINDOW_WIDTH, config::PROD_WINDOW_HEIGHT);
+    if (config::DEBUG_MODE) tracing::info("Debug mode enabled");
+
+    if (!export_options_.headless) {
+      tracing::trace("Initializing window...");
+      window_ =
+          std::make_unique<RenderWindow>(video_mode, config::WINDOW_TITLE);
       window_->setFramerateLimit(config::MAX_FPS);
     }
-    // digraph_ = std::make_unique<graph::DirectedAcyclicGraph>();
-    texture_ = std::make_unique<sf::Texture>();
 
-    if (!texture_->loadFromFile(TEXTURE_PATH)) {
-      tracing::error("Failed to load node texture from file");
-    } else {
-      tracing::info("Loaded node texture from file");
+    // When exporting, frames are rendered offscreen so their pixels can be
+    // read back and handed to the encoder threads.
+    if (export_options_.enabled()) {
+      tracing::trace("Initializing offscreen canvas...");
+      canvas_ = std::make_unique<sf::RenderTexture>();
+      if (!canvas_->create(video_mode.width, video_mode.height)) {
+        tracing::error("Failed to create offscreen canvas");
+      }
+      exporter_ = std::make_unique<FrameExporter>(export_options_);
     }
+    // Textures load in the background; nodes are drawn as plain squares
+    // until theirs arrive (see `apply_node_textures()`).
+    assets_ = std::make_unique<AssetManager>();
+    node_texture_ = assets_->request_texture(TEXTURE_PATH);
+    endpoint_texture_ = assets_->request_texture(ENDPOINT_TEXTURE_PATH);
+    font_ = assets_->request_font(config::FONT_PATH);
 
     // Initialize the digraph...
     // if (generate_random_graph) {
@@ -63,31 +86,40 @@ class GameState {
     //     digraph_->empty_graph();
     // }
 
-    // under the hood... we're just creating a bunch of nodes and edges
-    nodes_ = std::vector<std::unique_ptr<graph::Node>>();
-
-    for (int i = 0; i < 10; i++) {
-      nodes_.push_back(make_unique<graph::Node>(
-          *(window_.get()), *(texture_.get()), graph::random_position()));
-      //   nodes_.push_back(make_unique<graph::Node>(
-      //       *(window_.get()), *(texture_.get()), Vector2f(i * 100, i *
-      //       100)));
-    }
+    build_graph();
 
     debug("Initialized game state");
-    debug(format("Created {} nodes", nodes_.size()));
+    debug("Created {} nodes and {} edges", digraph_->num_nodes(),
+          digraph_->num_edges());
+
+    // The search runs at full speed on its own thread, recording its steps
+    // for the replay to animate on the render thread.
+    search_thread_ = std::thread([this] {
+      tracing::set_thread_name("search");
+      auto path =
+          graph::a_star(*digraph_, digraph_->source(), digraph_->target(),
+                        graph::euclidean_heuristic, replay_.recorder());
+      info("Search finished (path of {} nodes)", path.size());
+      search_done_.store(true, std::memory_order_release);
+    });
+  }
+
+  ~GameState() {
+    if (search_thread_.joinable()) search_thread_.join();
   }
 
   /// @brief Process events from the user (e.g. keyboard, mouse, window
   /// events)
-  auto process_events() {
-    // Only log events processing header every 1000 events
-    static int eventCount = 0;
-    if (eventCount++ % 1000 == 0) trace("Processing events");
-    eventCount++;
+  /// @return Whether any event was handled.
+  auto process_events() -> bool {
+    // Only log events processing header every 1000 frames
+    static tracing::EveryN polls(1000);
+    trace(polls, "Processing events");
 
+    auto handled = false;
     Event event;
     while (window_->pollEvent(event)) {
+      handled = true;
       switch (event.type) {
         case Event::Closed:
           trace("Closing window");
@@ -95,8 +127,7 @@ class GameState {
           break;
 
         case Event::Resized:
-          debug(format("Window resized to {}x{}", event.size.width,
-                       event.size.height));
+          debug("Window resized to {}x{}", event.size.width, event.size.height);
           break;
 
         case Event::LostFocus:
@@ -109,30 +140,33 @@ class GameState {
 
         case Event::TextEntered:
           if (event.text.unicode < 128) {
-            debug(format("ASCII character typed: {}",
-                         static_cast<char>(event.text.unicode)));
+            debug("ASCII character typed: {}",
+                  static_cast<char>(event.text.unicode));
           }
           break;
 
         // Window movement
-        case Event::MouseMoved:
-          if (eventCount % 10 == 0)
-            trace(format("Mouse moved to ({}, {})", event.mouseMove.x,
-                         event.mouseMove.y));
+        case Event::MouseMoved: {
+          static tracing::PerSecond mouse_moves(config::MOUSE_LOG_RATE);
+          trace(mouse_moves, "Mouse moved to ({}, {})", event.mouseMove.x,
+                event.mouseMove.y);
           break;
+        }
 
         case Event::MouseButtonPressed:
-          debug(format("Mouse button pressed: {}", event.mouseButton.button));
+          debug("Mouse button pressed: {}", event.mouseButton.button);
           break;
 
         case Event::MouseButtonReleased:
-          debug(format("Mouse button released: {}", event.mouseButton.button));
+          debug("Mouse button released: {}", event.mouseButton.button);
           break;
 
-        case Event::MouseWheelScrolled:
-          trace(
-              format("Mouse wheel scrolled: {}", event.mouseWheelScroll.delta));
+        case Event::MouseWheelScrolled: {
+          static tracing::PerSecond wheel_scrolls(config::MOUSE_LOG_RATE);
+          trace(wheel_scrolls, "Mouse wheel scrolled: {}",
+                event.mouseWheelScroll.delta);
           break;
+        }
 
           // Keyboard events
         case Event::KeyPressed:
@@ -176,6 +210,97 @@ class GameState {
                 "LVL_ERROR");
           }
 
+          // Profiler controls
+          if (event.key.code == Keyboard::F6) {
+            profiler_.toggle_overlay();
+            debug("F6 pressed - toggling profiler overlay");
+          }
+
+          if (event.key.code == Keyboard::F7) {
+            if (profiler_.write_csv(config::PROFILE_CSV_PATH)) {
+              info("F7 pressed - wrote frame profile to {}",
+                   config::PROFILE_CSV_PATH);
+            } else {
+              error("Failed to write {}", config::PROFILE_CSV_PATH);
+            }
+          }
+
+          if (event.key.code == Keyboard::F8) {
+            if (profiler_.write_json(config::PROFILE_JSON_PATH)) {
+              info("F8 pressed - wrote frame profile to {}",
+                   config::PROFILE_JSON_PATH);
+            } else {
+              error("Failed to write {}", config::PROFILE_JSON_PATH);
+            }
+          }
+
+          // Span recording (open the trace in Perfetto / chrome://tracing)
+          if (event.key.code == Keyboard::F9) {
+            if (!tracing::spans().recording()) {
+              tracing::start_span_recording();
+              info("F9 pressed - recording spans");
+            } else {
+              tracing::stop_span_recording();
+              if (tracing::write_chrome_trace(config::TRACE_JSON_PATH)) {
+                info("F9 pressed - wrote spans to {}",
+                     config::TRACE_JSON_PATH);
+              } else {
+                error("Failed to write {}", config::TRACE_JSON_PATH);
+              }
+            }
+          }
+
+          if (event.key.code == Keyboard::F10) {
+            auto& registry = tracing::metrics();
+            if (registry.write_prometheus(config::METRICS_PATH)) {
+              info("F10 pressed - wrote metrics to {}", config::METRICS_PATH);
+            } else {
+              error("Failed to write {}", config::METRICS_PATH);
+            }
+            debug("Metrics:\n{}", registry.dump_text());
+          }
+
+          // Minimum spanning forest overlay
+          if (event.key.code == Keyboard::F11) {
+            spanning_tree_shown_ = !spanning_tree_shown_;
+            if (spanning_tree_shown_) {
+              const auto forest = graph::kruskal(*digraph_);
+              graph::show_spanning_forest(*digraph_, forest);
+              info("F11 pressed - showing a spanning forest of {} trees "
+                   "(cost {:.1f})",
+                   forest.num_trees, forest.cost);
+            } else {
+              graph::hide_spanning_forest(*digraph_);
+              debug("F11 pressed - hiding the spanning forest");
+            }
+          }
+
+          // Search replay controls
+          if (event.key.code == Keyboard::Space) {
+            replay_.toggle_pause();
+            debug(replay_.paused() ? "Replay paused" : "Replay resumed");
+          }
+
+          if (event.key.code == Keyboard::Right) {
+            replay_.scrub(event.key.shift ? 100 : 1);
+          }
+
+          if (event.key.code == Keyboard::Left) {
+            replay_.scrub(event.key.shift ? -100 : -1);
+          }
+
+          if (event.key.code == Keyboard::Up) {
+            replay_.set_speed(replay_.speed() * 2.0f);
+          }
+
+          if (event.key.code == Keyboard::Down) {
+            replay_.set_speed(replay_.speed() / 2.0f);
+          }
+
+          if (event.key.code == Keyboard::Home) replay_.seek(0);
+
+          if (event.key.code == Keyboard::End) replay_.seek(replay_.size());
+
           // Fullscreen TODO: Fix this
           // if (event.key.code == Keyboard::F) {
           //     // Toggle fullscreen mode
@@ -200,58 +325,243 @@ class GameState {
           break;
       }
     }
+    return handled;
   }
 
-  auto tick() {
+  /// @brief Advances the game state by one frame.
+  /// @return Whether a frame was drawn (frames in which nothing changed are
+  /// skipped).
+  auto tick() -> bool {
+    auto frame = profiler_.measure(Phase::Frame);
+    tracing::Span frame_span("frame", "frame");
+
     // auto update(unique_ptr<RenderWindow>& window) -> void {
     // process_events(window);
-    process_events();
+    // Phase samples are held back until we know whether the frame is drawn,
+    // so that every phase records the same frames
+    auto handled_events = false;
+    std::optional<FrameProfiler::Scope> events;
+    if (window_) {
+      events.emplace(profiler_, Phase::Events);
+      tracing::Span span("events", "frame");
+      handled_events = process_events();
+      events->stop();
+    }
 
-    // Update the game state...
-    // update();
+    // Update the game state... (exported videos advance by a fixed step so
+    // they play back at the same speed regardless of encoding throughput)
+    const auto dt = exporter_ ? 1.0f / config::MAX_FPS
+                              : frame_clock_.restart().asSeconds();
+    auto simulation = profiler_.measure(Phase::Simulation);
+    {
+      tracing::Span span("simulation", "frame");
+      update(dt);
+    }
+    simulation.stop();
+
+    // Nothing on screen changed (no input, no replay steps, no textures
+    // arrived): keep the previous frame instead of drawing an identical one
+    if (!handled_events && !exporter_ && !digraph_->dirty() &&
+        !profiler_.overlay()) {
+      // Skipped frames are counted by `frames_skipped_total`, their samples
+      // would only drag the percentiles down (and misalign the phases)
+      frame.discard();
+      if (events) events->discard();
+      simulation.discard();
+      frames_skipped_.add();
+      return false;
+    }
+    frames_drawn_.add();
 
     // Render the game state
-    render();
+    {
+      auto rendering = profiler_.measure(Phase::Render);
+      tracing::Span span("render", "frame");
+      render();
+    }
+
+    auto presenting = profiler_.measure(Phase::Display);
+    tracing::Span span("display", "frame");
+    display();
+    return true;
   }
 
   /// @brief The main game loop
   auto main_loop() -> void {
-    // continuously update the game state until the window is closed
-    while (window_->isOpen()) {
-      tick();
+    // continuously update the game state until the window is closed (or, when
+    // exporting, until all requested frames have been rendered)
+    while (window_ ? window_->isOpen() : !export_finished()) {
+      // Skipped frames don't reach the frame limiter in `display()`
+      if (!tick()) sf::sleep(sf::seconds(1.0f / config::MAX_FPS));
+      if (window_ && exporter_ && export_finished()) window_->close();
     }
+    if (exporter_) exporter_->finish();
   }
 
-  auto render() -> void {
-    window_->clear(Color::Black);
-    // window_->clear(Color::White); // Light mode
+  /// @brief Advances the simulation (i.e. the search replay).
+  /// @param dt The time since the last frame (in seconds).
+  auto update(float dt) -> void {
+    if (assets_->poll() > 0) apply_node_textures();
 
-    // for (auto& node : nodes_) {
-    //   window_->draw(*node->sprite());
-    // }
+    replay_.poll();
+    replay_.update(dt);
+    replay_.apply(*digraph_);
+  }
+
+  /// @brief Submits the draw calls for the current frame.
+  auto render() -> void {
+    auto& target = render_target();
+    target.clear(Color::Black);
+    // target.clear(Color::White); // Light mode
 
     // Render the nodes
-    for (auto& node : nodes_) {
-      node->render();
+    digraph_->render();
+
+    // The overlay is drawn straight to the window so it never ends up in
+    // exported frames
+    if (!canvas_) profiler_.render(*window_, assets_->font(font_));
+  }
+
+  /// @brief Presents the current frame (and hands it to the exporter).
+  auto display() -> void {
+    if (canvas_) {
+      canvas_->display();
+      exporter_->submit(canvas_->getTexture().copyToImage());
+      if (!window_) return;
+
+      // Mirror the offscreen frame to the window
+      window_->clear(Color::Black);
+      window_->draw(Sprite(canvas_->getTexture()));
+      profiler_.render(*window_, assets_->font(font_));
     }
 
     window_->display();
   }
 
-  static auto build() { return make_unique<GameState>(); }
+  static auto build(ExportOptions export_options = {}) {
+    return make_unique<GameState>(std::move(export_options));
+  }
 
  private:
+  /// @brief The target frames are rendered to: the offscreen canvas when
+  /// exporting, the window otherwise.
+  auto render_target() -> sf::RenderTarget& {
+    if (canvas_) return *canvas_;
+    return *window_;
+  }
+
+  /// @brief Whether all frames requested for export have been rendered.
+  auto export_finished() const -> bool {
+    if (!exporter_) return false;
+    if (export_options_.frames > 0) {
+      return exporter_->frames_submitted() >= export_options_.frames;
+    }
+    return search_done_.load(std::memory_order_acquire) && replay_.finished();
+  }
+
+  /// @brief How (and whether) frames are exported.
+  ExportOptions export_options_;
+  /// @brief The window (null when running headless).
   unique_ptr<RenderWindow> window_;
-  unique_ptr<Texture> texture_;
-  vector<unique_ptr<graph::Node>> nodes_;
+  /// @brief The offscreen canvas frames are rendered to when exporting.
+  unique_ptr<sf::RenderTexture> canvas_;
+  /// @brief Encodes and writes exported frames.
+  unique_ptr<FrameExporter> exporter_;
+
+  /// @brief Loads textures (and fonts) in the background.
+  unique_ptr<AssetManager> assets_;
+  /// @brief The texture of regular nodes.
+  AssetId node_texture_;
+  /// @brief The texture of the source and target nodes.
+  AssetId endpoint_texture_;
+  /// @brief The font used for overlays.
+  AssetId font_;
+
+  /// @brief Measures the phases of each frame (toggle the overlay with F6).
+  FrameProfiler profiler_;
+
+  unique_ptr<graph::DirectedAcyclicGraph> digraph_;
+
+  /// @brief Whether the minimum spanning forest is highlighted (F11).
+  bool spanning_tree_shown_ = false;
+
+  /// @brief Animates the steps recorded by the search thread.
+  SearchReplay replay_;
+
+  /// @brief Runs the search (joined on destruction).
+  std::thread search_thread_;
+
+  /// @brief Set by the search thread once the search has finished.
+  std::atomic<bool> search_done_{false};
+
+  /// @brief Measures the time between frames.
+  sf::Clock frame_clock_;
+
+  tracing::Counter& frames_drawn_ =
+      tracing::metrics().counter("frames_drawn_total", "Frames drawn");
+  tracing::Counter& frames_skipped_ = tracing::metrics().counter(
+      "frames_skipped_total", "Frames skipped because nothing changed");
+
+  /// @brief Builds a random graph: a source, a target and
+  /// `config::NUM_NODES` nodes in between, each connected to its
+  /// `config::NUM_NEIGHBOURS` nearest neighbours.
+  auto build_graph() -> void {
+    tracing::Span span("build_graph", "graph");
+    auto& target = render_target();
+    digraph_ = std::make_unique<graph::DirectedAcyclicGraph>(
+        &target, &assets_->atlas(),
+        make_unique<graph::Node>(target, graph::random_position()),
+        make_unique<graph::Node>(target, graph::random_position()));
+
+    for (int i = 0; i < config::NUM_NODES; i++) {
+      digraph_->add_node(graph::random_position());
+    }
 
-  //   unique_ptr<graph::DirectedAcyclicGraph> digraph_;
+    const auto num_nodes = digraph_->num_nodes();
+    vector<graph::Node*> nearest;
+    for (const auto& node : digraph_->nodes()) {
+      nearest.clear();
+      for (const auto& other : digraph_->nodes()) {
+        if (other != node) nearest.push_back(other.get());
+      }
+      const auto k = std::min<size_t>(config::NUM_NEIGHBOURS, num_nodes - 1);
+      std::partial_sort(nearest.begin(), nearest.begin() + k, nearest.end(),
+                        [&](graph::Node* a, graph::Node* b) {
+                          return node->distance_from(a) <
+                                 node->distance_from(b);
+                        });
+      for (size_t i = 0; i < k; i++) {
+        // Edges default to geometric (cached) costs
+        digraph_->add_edge(node.get(), nearest[i]);
+      }
+    }
+    span.arg("nodes", digraph_->num_nodes());
+    span.arg("edges", digraph_->num_edges());
+  }
+
+  /// @brief Gives every node whose texture has finished loading its sprite.
+  /// The graph draws all nodes with the shared atlas, so images that didn't
+  /// fit the atlas are not applied (those nodes stay plain squares).
+  auto apply_node_textures() -> void {
+    for (const auto& node : digraph_->nodes()) {
+      const auto endpoint = node.get() == digraph_->source() ||
+                            node.get() == digraph_->target();
+      const auto id = endpoint ? endpoint_texture_ : node_texture_;
+      if (!assets_->ready(id) || node->texture() != nullptr) continue;
+      if (assets_->texture(id) != &assets_->atlas()) continue;
+
+      node->set_texture(assets_->texture(id));
+      node->set_texture_rect(assets_->rect(id));
+      node->set_size(config::NODE_SIZE);
+    }
+  }
 };
 
-auto init() -> unique_ptr<driver::GameState> {
+auto init(ExportOptions export_options = {})
+    -> unique_ptr<driver::GameState> {
   srand(time(NULL));
   trace("Initializing game state...");
-  return GameState::build();
+  return GameState::build(std::move(export_options));
 }
 
 }  // namespace driver
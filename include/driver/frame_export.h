@@ -0,0 +1,201 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "utils/config.h"
+#include "utils/spans.h"
+#include "utils/tracing.h"
+
+using std::string;
+using std::vector;
+
+namespace driver {
+
+/// @brief The format exported frames are written in.
+enum class FrameFormat {
+  /// @brief One PNG file per frame (`<output>/frame_000000.png`, ...).
+  /// Encoded in parallel by a pool of encoder threads.
+  Png,
+  /// @brief Raw RGBA8 frames appended, in order, to a single file (or to
+  /// stdout when the output is `-`), e.g. for piping into
+  /// `ffmpeg -f rawvideo -pixel_format rgba -video_size WxH -i -`.
+  Raw,
+};
+
+/// @brief Options controlling offscreen rendering and frame export.
+struct ExportOptions {
+  /// @brief Where frames are written (a directory for `FrameFormat::Png`, a
+  /// file or `-` for `FrameFormat::Raw`). Export is disabled when empty.
+  string output;
+  /// @brief The format frames are written in.
+  FrameFormat format = FrameFormat::Png;
+  /// @brief The number of frames to export (`0` exports until the search
+  /// replay has finished).
+  uint64_t frames = 0;
+  /// @brief The number of encoder threads (PNG only, raw frames are written
+  /// by a single thread to keep them in order).
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  /// @brief Render without creating a window (e.g. for batch jobs).
+  bool headless = false;
+
+  /// @brief Whether frames should be exported at all.
+  auto enabled() const { return !output.empty(); }
+};
+
+/// @brief Writes rendered frames to disk on a pool of encoder threads.
+///
+/// The render thread hands over each frame's pixels with `submit()` and goes
+/// straight back to rendering the next frame while earlier frames are being
+/// encoded. At most `config::EXPORT_QUEUE_DEPTH` frames are buffered; if the
+/// encoders fall further behind than that, `submit()` waits for a free slot
+/// so memory use stays bounded.
+class FrameExporter {
+ public:
+  explicit FrameExporter(ExportOptions options)
+      : options_(std::move(options)) {
+    auto num_workers = options_.threads;
+    if (options_.format == FrameFormat::Png) {
+      std::filesystem::create_directories(options_.output);
+    } else {
+      num_workers = 1;
+      if (options_.output == "-") {
+        // stdout outlives the exporter (and may have been written to
+        // already), so it keeps the buffer libc gave it
+        raw_ = stdout;
+      } else {
+        raw_ = std::fopen(options_.output.c_str(), "wb");
+        if (raw_ == nullptr) {
+          tracing::error("Failed to open {} for writing", options_.output);
+        } else {
+          raw_buffer_.resize(config::EXPORT_WRITE_BUFFER_SIZE);
+          std::setvbuf(raw_, raw_buffer_.data(), _IOFBF, raw_buffer_.size());
+        }
+      }
+    }
+
+    tracing::info("Exporting frames to {} ({} encoder threads)",
+                  options_.output, num_workers);
+    for (unsigned i = 0; i < num_workers; i++) {
+      workers_.emplace_back([this] { encode_frames(); });
+    }
+  }
+
+  FrameExporter(const FrameExporter&) = delete;
+  auto operator=(const FrameExporter&) -> FrameExporter& = delete;
+
+  ~FrameExporter() { finish(); }
+
+  /// @brief Queues a frame for encoding (render thread).
+  /// @param frame The frame's pixels (e.g. from `Texture::copyToImage()`).
+  auto submit(sf::Image frame) -> void {
+    std::unique_lock lock(mutex_);
+    not_full_.wait(
+        lock, [this] { return jobs_.size() < config::EXPORT_QUEUE_DEPTH; });
+    jobs_.push_back(Job{submitted_++, std::move(frame)});
+    lock.unlock();
+    not_empty_.notify_one();
+  }
+
+  /// @brief Waits for all queued frames to be written and stops the encoder
+  /// threads. Called automatically on destruction.
+  auto finish() -> void {
+    {
+      std::lock_guard lock(mutex_);
+      if (finished_) return;
+      finished_ = true;
+    }
+    not_empty_.notify_all();
+    for (auto& worker : workers_) worker.join();
+
+    if (raw_ != nullptr) {
+      std::fflush(raw_);
+      if (raw_ != stdout) std::fclose(raw_);
+      raw_ = nullptr;
+    }
+    tracing::info("Exported {} frames to {}", submitted_, options_.output);
+  }
+
+  /// @brief The number of frames submitted so far.
+  auto frames_submitted() const { return submitted_; }
+
+ private:
+  /// @brief A frame waiting to be encoded.
+  struct Job {
+    /// @brief The index of the frame (used to name / order the output).
+    uint64_t index;
+    /// @brief The frame's pixels.
+    sf::Image image;
+  };
+
+  /// @brief Encoder thread body: encodes queued frames until `finish()`.
+  auto encode_frames() -> void {
+    tracing::set_thread_name("encoder");
+    while (true) {
+      std::unique_lock lock(mutex_);
+      not_empty_.wait(lock, [this] { return !jobs_.empty() || finished_; });
+      if (jobs_.empty()) return;
+      auto job = std::move(jobs_.front());
+      jobs_.pop_front();
+      lock.unlock();
+      not_full_.notify_one();
+
+      encode(job);
+    }
+  }
+
+  /// @brief Writes a single frame.
+  auto encode(const Job& job) -> void {
+    tracing::Span span("encode_frame", "export");
+    span.arg("frame", job.index);
+    if (options_.format == FrameFormat::Png) {
+      auto path = format("{}/frame_{:06}.png", options_.output, job.index);
+      if (!job.image.saveToFile(path)) {
+        tracing::error("Failed to write frame {}", path);
+      }
+      return;
+    }
+
+    if (raw_ == nullptr) return;
+    const auto size = job.image.getSize();
+    std::fwrite(job.image.getPixelsPtr(), 4, size_t{size.x} * size.y, raw_);
+  }
+
+  /// @brief The options the exporter was created with.
+  ExportOptions options_;
+
+  /// @brief The encoder threads.
+  vector<std::thread> workers_;
+
+  /// @brief Guards `jobs_`, `submitted_` and `finished_`.
+  std::mutex mutex_;
+  /// @brief Signalled when a frame is queued (or on `finish()`).
+  std::condition_variable not_empty_;
+  /// @brief Signalled when an encoder takes a frame off the queue.
+  std::condition_variable not_full_;
+
+  /// @brief Frames waiting to be encoded (oldest first).
+  std::deque<Job> jobs_;
+  /// @brief The number of frames submitted so far.
+  uint64_t submitted_ = 0;
+  /// @brief Whether `finish()` has been called.
+  bool finished_ = false;
+
+  /// @brief The raw output stream (`FrameFormat::Raw` only).
+  FILE* raw_ = nullptr;
+  /// @brief The stdio buffer for `raw_` (large to keep writes sequential;
+  /// files only, the exporter doesn't own stdout).
+  vector<char> raw_buffer_;
+};
+
+}  // namespace driver
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/config.h"
+#include "utils/metrics.h"
+#include "utils/tracing.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace driver {
+
+/// @brief The phases of a frame measured by the `FrameProfiler`.
+enum class Phase : uint8_t {
+  /// @brief Polling and handling window events.
+  Events,
+  /// @brief Advancing the simulation (asset uploads, search replay, ...).
+  Simulation,
+  /// @brief Submitting draw calls.
+  Render,
+  /// @brief Presenting the frame (`display()`, plus readback when exporting).
+  Display,
+  /// @brief The whole frame.
+  Frame,
+};
+
+/// @brief The number of phases.
+static constexpr size_t NUM_PHASES = 5;
+
+/// @brief The name of a phase (used in overlays and dumps).
+inline auto phase_name(Phase phase) -> string_view {
+  constexpr std::array<string_view, NUM_PHASES> names = {
+      "events", "simulation", "render", "display", "frame"};
+  return names[static_cast<size_t>(phase)];
+}
+
+/// @brief The color a phase is drawn with in the overlay.
+inline auto phase_color(Phase phase) -> sf::Color {
+  const std::array<sf::Color, NUM_PHASES> colors = {
+      sf::Color(80, 160, 255), sf::Color(255, 170, 0), sf::Color(0, 210, 120),
+      sf::Color(220, 80, 220), sf::Color::White};
+  return colors[static_cast<size_t>(phase)];
+}
+
+/// @brief A fixed-size history of timing samples that overwrites the oldest
+/// sample once full.
+///
+/// Written by a single thread (the render thread) and readable from any
+/// thread without locking: slots and the write counter are atomics, so a
+/// reader never blocks the writer (at worst a snapshot taken mid-frame misses
+/// the sample being written).
+class SampleRing {
+ public:
+  /// @brief Records a sample (writer only).
+  /// @param value The sample (in microseconds).
+  inline auto push(float value) -> void {
+    const auto index = written_.load(std::memory_order_relaxed);
+    slots_[index % slots_.size()].store(value, std::memory_order_relaxed);
+    written_.store(index + 1, std::memory_order_release);
+  }
+
+  /// @brief Copies the recorded samples, oldest first.
+  auto snapshot() const -> vector<float> {
+    const auto written = written_.load(std::memory_order_acquire);
+    const auto count = std::min<uint64_t>(written, slots_.size());
+    vector<float> samples(count);
+    for (uint64_t i = 0; i < count; i++) {
+      const auto index = (written - count + i) % slots_.size();
+      samples[i] = slots_[index].load(std::memory_order_relaxed);
+    }
+    return samples;
+  }
+
+  /// @brief The total number of samples ever recorded.
+  auto written() const { return written_.load(std::memory_order_acquire); }
+
+ private:
+  std::array<std::atomic<float>, config::PROFILER_HISTORY> slots_{};
+  std::atomic<uint64_t> written_{0};
+};
+
+/// @brief Summary statistics of a phase's recent samples (in microseconds).
+struct PhaseStats {
+  float p50 = 0.0f;
+  float p95 = 0.0f;
+  float p99 = 0.0f;
+  float max = 0.0f;
+};
+
+/// @brief Computes percentiles of a set of samples.
+/// @param samples The samples (reordered in place).
+inline auto compute_stats(vector<float>& samples) -> PhaseStats {
+  PhaseStats stats;
+  if (samples.empty()) return stats;
+  auto percentile = [&](float p) {
+    const auto rank = static_cast<size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+  };
+  stats.p50 = percentile(0.50f);
+  stats.p95 = percentile(0.95f);
+  stats.p99 = percentile(0.99f);
+  stats.max = *std::max_element(samples.begin(), samples.end());
+  return stats;
+}
+
+/// @brief Measures how long each phase of a frame takes.
+///
+/// Wrap each phase of `GameState::tick()` in `measure()`; the overlay shows
+/// p50 / p95 / p99 per phase plus a rolling graph of recent frame times, and
+/// the history can be dumped to CSV or JSON for offline analysis. Every
+/// sample is also recorded into a `frame_<phase>_us` histogram of the metrics
+/// registry, which keeps the whole run rather than the recent history.
+class FrameProfiler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  FrameProfiler() {
+    for (size_t i = 0; i < NUM_PHASES; i++) {
+      const auto name = phase_name(static_cast<Phase>(i));
+      histograms_[i] = &tracing::metrics().histogram(
+          format("frame_{}_us", name),
+          format("Time spent in the {} phase of a frame (us)", name));
+    }
+  }
+
+  /// @brief Records the time from construction to destruction (or to
+  /// `stop()`) as a sample of a phase, when the scope ends.
+  class Scope {
+   public:
+    Scope(FrameProfiler& profiler, Phase phase)
+        : profiler_(profiler), phase_(phase), start_(Clock::now()) {}
+
+    Scope(const Scope&) = delete;
+    auto operator=(const Scope&) -> Scope& = delete;
+
+    ~Scope() {
+      if (discarded_) return;
+      const std::chrono::duration<float, std::micro> elapsed =
+          (stopped_ ? end_ : Clock::now()) - start_;
+      profiler_.record(phase_, elapsed.count());
+    }
+
+    /// @brief Ends the measurement, but holds the sample back until the
+    /// scope ends (so it can still be discarded).
+    auto stop() -> void {
+      if (stopped_) return;
+      end_ = Clock::now();
+      stopped_ = true;
+    }
+
+    /// @brief Drops the sample instead of recording it (e.g. for a frame
+    /// that turned out to be skipped).
+    auto discard() -> void { discarded_ = true; }
+
+   private:
+    FrameProfiler& profiler_;
+    Phase phase_;
+    Clock::time_point start_;
+    Clock::time_point end_;
+    bool stopped_ = false;
+    bool discarded_ = false;
+  };
+
+  /// @brief Starts measuring a phase (until the returned scope ends).
+  [[nodiscard]] auto measure(Phase phase) -> Scope { return {*this, phase}; }
+
+  /// @brief Records a sample of a phase.
+  /// @param phase The phase.
+  /// @param micros How long the phase took (in microseconds).
+  auto record(Phase phase, float micros) -> void {
+    rings_[static_cast<size_t>(phase)].push(micros);
+    histograms_[static_cast<size_t>(phase)]->record(
+        static_cast<uint64_t>(micros));
+  }
+
+  /// @brief Statistics over the recent samples of a phase.
+  auto stats(Phase phase) const -> PhaseStats {
+    auto samples = rings_[static_cast<size_t>(phase)].snapshot();
+    return compute_stats(samples);
+  }
+
+  /// @brief Shows or hides the overlay.
+  auto toggle_overlay() -> void { overlay_ = !overlay_; }
+
+  /// @brief Whether the overlay is shown.
+  auto overlay() const { return overlay_; }
+
+  /// @brief Draws the overlay: a rolling graph of frame times and, per phase,
+  /// p50 / p95 / p99 bars (labelled when a font is available).
+  /// @param target The target to draw to.
+  /// @param font The font to label the overlay with (may be `nullptr`).
+  auto render(sf::RenderTarget& target, const sf::Font* font) const -> void {
+    if (!overlay_) return;
+
+    const auto width = static_cast<float>(config::PROFILER_HISTORY);
+    const auto height = config::PROFILER_GRAPH_HEIGHT;
+    const auto scale = height / config::PROFILER_GRAPH_RANGE_US;
+    const auto origin = sf::Vector2f(config::PADDING, config::PADDING);
+
+    sf::RectangleShape background(sf::Vector2f(width, height + 160.0f));
+    background.setPosition(origin);
+    background.setFillColor(sf::Color(0, 0, 0, 180));
+    target.draw(background);
+
+    // Frame time budget (e.g. 16.6ms at 60 FPS)
+    const auto budget_y = origin.y + height - scale * 1e6f / config::MAX_FPS;
+    const sf::Vertex budget[] = {
+        sf::Vertex(sf::Vector2f(origin.x, budget_y), sf::Color::Red),
+        sf::Vertex(sf::Vector2f(origin.x + width, budget_y), sf::Color::Red)};
+    target.draw(budget, 2, sf::Lines);
+
+    // Rolling frame-time graph
+    const auto frames = rings_[static_cast<size_t>(Phase::Frame)].snapshot();
+    sf::VertexArray graph(sf::LineStrip, frames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+      const auto y = std::max(origin.y, origin.y + height - frames[i] * scale);
+      graph[i] = sf::Vertex(sf::Vector2f(origin.x + i, y), sf::Color::White);
+    }
+    target.draw(graph);
+
+    // Per-phase percentile bars
+    auto y = origin.y + height + 10.0f;
+    for (size_t i = 0; i < NUM_PHASES; i++) {
+      const auto phase = static_cast<Phase>(i);
+      const auto stats = this->stats(phase);
+      const float values[] = {stats.p50, stats.p95, stats.p99};
+      for (size_t p = 0; p < 3; p++) {
+        const auto length = std::min(width - 200.0f, values[p] * scale);
+        sf::RectangleShape bar(sf::Vector2f(length, 8.0f));
+        bar.setPosition(origin.x + 200.0f, y + p * 9.0f);
+        auto color = phase_color(phase);
+        color.a = static_cast<sf::Uint8>(255 - p * 70);
+        bar.setFillColor(color);
+        target.draw(bar);
+      }
+
+      if (font != nullptr) {
+        sf::Text label(format("{:<10} {:>7.2f} {:>7.2f} {:>7.2f} ms",
+                              phase_name(phase), stats.p50 / 1000.0f,
+                              stats.p95 / 1000.0f, stats.p99 / 1000.0f),
+                       *font, 12);
+        label.setFillColor(phase_color(phase));
+        label.setPosition(origin.x + 4.0f, y);
+        target.draw(label);
+      }
+      y += 30.0f;
+    }
+  }
+
+  /// @brief Writes the sample history as CSV (one row per frame, one column
+  /// per phase, in microseconds).
+  /// @param path The file to write.
+  /// @return Whether the file was written.
+  auto write_csv(const string& path) const -> bool {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    const auto history = snapshot();
+    out << "sample";
+    for (size_t i = 0; i < NUM_PHASES; i++) {
+      out << ',' << phase_name(static_cast<Phase>(i)) << "_us";
+    }
+    out << '\n';
+
+    // Phases may have fewer samples (e.g. events when headless), so rows are
+    // aligned on the most recent sample.
+    size_t rows = 0;
+    for (const auto& samples : history) rows = std::max(rows, samples.size());
+    for (size_t row = 0; row < rows; row++) {
+      out << row;
+      for (const auto& samples : history) {
+        const auto offset = rows - samples.size();
+        out << ',';
+        if (row >= offset) out << samples[row - offset];
+      }
+      out << '\n';
+    }
+    return static_cast<bool>(out);
+  }
+
+  /// @brief Writes per-phase percentiles and the sample history as JSON.
+  /// @param path The file to write.
+  /// @return Whether the file was written.
+  auto write_json(const string& path) const -> bool {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    auto history = snapshot();
+    out << "{\n  \"unit\": \"us\",\n  \"phases\": {";
+    for (size_t i = 0; i < NUM_PHASES; i++) {
+      auto samples = history[i];
+      const auto stats = compute_stats(samples);
+      out << (i == 0 ? "\n" : ",\n")
+          << format("    \"{}\": {{\"p50\": {}, \"p95\": {}, \"p99\": {}, "
+                    "\"max\": {}, \"samples\": [",
+                    phase_name(static_cast<Phase>(i)), stats.p50, stats.p95,
+                    stats.p99, stats.max);
+      for (size_t s = 0; s < history[i].size(); s++) {
+        out << (s == 0 ? "" : ", ") << history[i][s];
+      }
+      out << "]}";
+    }
+    out << "\n  }\n}\n";
+    return static_cast<bool>(out);
+  }
+
+ private:
+  /// @brief Copies every phase's sample history.
+  auto snapshot() const -> std::array<vector<float>, NUM_PHASES> {
+    std::array<vector<float>, NUM_PHASES> history;
+    for (size_t i = 0; i < NUM_PHASES; i++) history[i] = rings_[i].snapshot();
+    return history;
+  }
+
+  /// @brief The sample history of each phase.
+  std::array<SampleRing, NUM_PHASES> rings_;
+
+  /// @brief Every sample of each phase (owned by the metrics registry).
+  std::array<tracing::Histogram*, NUM_PHASES> histograms_;
+
+  /// @brief Whether the overlay is shown.
+  bool overlay_ = false;
+};
+
+}  // namespace driver
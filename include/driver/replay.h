@@ -0,0 +1,170 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "graph/graph.h"
+#include "graph/step_recorder.h"
+#include "utils/config.h"
+#include "utils/tracing.h"
+
+using sf::Color;
+using std::vector;
+
+namespace driver {
+
+/// @brief The color of nodes the search has not touched (yet).
+const static auto UNVISITED_COLOR = Color::White;
+/// @brief The color of nodes on the open set (frontier).
+const static auto FRONTIER_COLOR = Color(255, 210, 0);
+/// @brief The color of the node currently being expanded.
+const static auto EXPANDING_COLOR = Color(255, 120, 0);
+/// @brief The color of nodes whose cost was just lowered.
+const static auto RELAXED_COLOR = Color(0, 200, 255);
+/// @brief The color of nodes on the closed set.
+const static auto SETTLED_COLOR = Color(90, 90, 140);
+/// @brief The color of nodes on the final path.
+const static auto PATH_COLOR = Color(0, 230, 90);
+
+/// @brief Replays the steps of a search that runs on another thread.
+///
+/// The search thread records steps through `recorder()` into a lock-free SPSC
+/// queue and never waits on rendering. Once per frame the render thread calls
+/// `poll()` to move newly recorded steps onto the replay's timeline, `update()`
+/// to advance the playback cursor, and `apply()` to color the graph's nodes to
+/// match the state of the search at the cursor.
+///
+/// Because the whole timeline is kept, playback can be paused, sped up or
+/// slowed down, and scrubbed or seeked in either direction independently of
+/// how far the search itself has progressed.
+class SearchReplay {
+ public:
+  explicit SearchReplay(size_t capacity = config::REPLAY_QUEUE_CAPACITY)
+      : queue_(capacity), recorder_(queue_) {}
+
+  /// @brief The recorder the search thread should report its steps to.
+  auto recorder() -> graph::StepRecorder& { return recorder_; }
+
+  /// @brief Moves all steps recorded so far onto the timeline (render thread).
+  auto poll() -> void {
+    queue_.drain([this](const graph::StepEvent& event) {
+      timeline_.push_back(event);
+    });
+  }
+
+  /// @brief Advances the playback cursor.
+  /// @param dt The time since the last update (in seconds).
+  auto update(float dt) -> void {
+    if (paused_) return;
+    cursor_ = std::min(cursor_ + static_cast<double>(speed_ * dt),
+                       static_cast<double>(timeline_.size()));
+  }
+
+  /// @brief Colors the nodes of `graph` to match the state of the search at
+  /// the playback cursor. Moving forward only paints the new steps; moving
+  /// backwards repaints from the start of the timeline.
+  /// @param graph The graph the search ran on.
+  auto apply(graph::DirectedAcyclicGraph& graph) -> void {
+    const auto target = position();
+    if (target < applied_) {
+      for (const auto& node : graph.nodes()) node->set_color(UNVISITED_COLOR);
+      applied_ = 0;
+    }
+    for (; applied_ < target; applied_++) {
+      paint(graph, timeline_[applied_]);
+    }
+  }
+
+  /// @brief Moves the playback cursor to the given step.
+  /// @param step The index of the step (clamped to the recorded timeline).
+  auto seek(size_t step) -> void {
+    cursor_ = static_cast<double>(std::min(step, timeline_.size()));
+  }
+
+  /// @brief Moves the playback cursor by the given number of steps.
+  /// @param delta The number of steps to move (negative moves backwards).
+  auto scrub(int64_t delta) -> void {
+    const auto step = static_cast<int64_t>(position()) + delta;
+    seek(step < 0 ? 0 : static_cast<size_t>(step));
+  }
+
+  /// @brief Sets the playback speed.
+  /// @param steps_per_second The number of steps played per second.
+  auto set_speed(float steps_per_second) -> void {
+    speed_ = std::clamp(steps_per_second, config::MIN_REPLAY_SPEED,
+                        config::MAX_REPLAY_SPEED);
+    tracing::debug("Replay speed set to {} steps/s", speed_);
+  }
+
+  /// @brief The playback speed (in steps per second).
+  auto speed() const { return speed_; }
+
+  /// @brief Pauses or resumes playback.
+  auto toggle_pause() -> void { paused_ = !paused_; }
+
+  /// @brief Whether playback is paused.
+  auto paused() const { return paused_; }
+
+  /// @brief The index of the step at the playback cursor.
+  auto position() const -> size_t { return static_cast<size_t>(cursor_); }
+
+  /// @brief The number of steps recorded so far.
+  auto size() const -> size_t { return timeline_.size(); }
+
+  /// @brief Whether the cursor has reached the end of the recorded steps (and
+  /// no more steps are waiting to be polled).
+  auto finished() const { return position() == size() && queue_.empty(); }
+
+  /// @brief The number of steps the search thread had to drop because the
+  /// queue was full.
+  auto dropped() const { return recorder_.dropped(); }
+
+ private:
+  /// @brief Colors the node a single step is about.
+  static auto paint(graph::DirectedAcyclicGraph& graph,
+                    const graph::StepEvent& event) -> void {
+    auto node = graph.node(event.node);
+    switch (event.kind) {
+      case graph::StepKind::Push:
+        node->set_color(FRONTIER_COLOR);
+        break;
+      case graph::StepKind::Pop:
+        node->set_color(EXPANDING_COLOR);
+        break;
+      case graph::StepKind::Relax:
+        node->set_color(RELAXED_COLOR);
+        break;
+      case graph::StepKind::Settle:
+        node->set_color(SETTLED_COLOR);
+        break;
+      case graph::StepKind::PathFound:
+        node->set_color(PATH_COLOR);
+        break;
+    }
+  }
+
+  /// @brief Steps travel from the search thread to the render thread on this.
+  graph::StepQueue queue_;
+
+  /// @brief The producer side of `queue_` (used by the search thread only).
+  graph::StepRecorder recorder_;
+
+  /// @brief Every step received so far (render thread only).
+  vector<graph::StepEvent> timeline_;
+
+  /// @brief The playback cursor (fractional so slow speeds still advance).
+  double cursor_ = 0.0;
+
+  /// @brief The number of timeline steps currently painted onto the graph.
+  size_t applied_ = 0;
+
+  /// @brief The playback speed (in steps per second).
+  float speed_ = config::REPLAY_SPEED;
+
+  /// @brief Whether playback is paused.
+  bool paused_ = false;
+};
+
+}  // namespace driver
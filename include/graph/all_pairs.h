@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <vector>
+
+#include "graph/csr.h"
+#include "graph/graph.h"
+#include "graph/search_context.h"
+#include "utils/config.h"
+#include "utils/parallel.h"
+#include "utils/spans.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define GRAPH_HAS_AVX2_KERNEL 1
+#endif
+
+using std::optional;
+using std::vector;
+
+namespace graph {
+
+// ---------------------------------------------------------------------------
+// Distance matrix
+// ---------------------------------------------------------------------------
+
+/// @brief A dense `n x n` matrix of path costs (`INF` where there is no
+/// path), e.g. an adjacency matrix or the result of an all-pairs search.
+///
+/// Rows are padded to a multiple of `config::APSP_TILE_SIZE` columns (and
+/// the matrix to as many rows), and aligned for SIMD loads, so that tiled
+/// kernels never need edge cases. The padding is `INF`.
+class DistanceMatrix {
+ public:
+  DistanceMatrix() = default;
+
+  /// @brief Creates a matrix with `INF` everywhere but the diagonal (0).
+  explicit DistanceMatrix(size_t size)
+      : size_(size),
+        stride_((size + config::APSP_TILE_SIZE - 1) / config::APSP_TILE_SIZE *
+                config::APSP_TILE_SIZE),
+        data_(new (std::align_val_t{kAlignment}) float[stride_ * stride_]) {
+    std::fill(data_.get(), data_.get() + stride_ * stride_, INF);
+    for (size_t i = 0; i < size_; i++) at(i, i) = 0.0f;
+  }
+
+  DistanceMatrix(DistanceMatrix&&) noexcept = default;
+  auto operator=(DistanceMatrix&&) noexcept -> DistanceMatrix& = default;
+
+  DistanceMatrix(const DistanceMatrix& other) : DistanceMatrix(other.size_) {
+    std::copy(other.data(), other.data() + stride_ * stride_, data());
+  }
+
+  /// @brief The number of nodes (rows and columns).
+  auto size() const -> size_t { return size_; }
+
+  /// @brief The distance between the starts of consecutive rows.
+  auto stride() const -> size_t { return stride_; }
+
+  /// @brief The cost of the cheapest path from `from` to `to`.
+  auto operator()(size_t from, size_t to) const -> float {
+    return data_[from * stride_ + to];
+  }
+
+  auto at(size_t from, size_t to) -> float& {
+    return data_[from * stride_ + to];
+  }
+
+  auto data() -> float* { return data_.get(); }
+  auto data() const -> const float* { return data_.get(); }
+
+ private:
+  /// @brief Rows start on AVX (32 byte) boundaries.
+  static constexpr size_t kAlignment = 32;
+
+  struct AlignedDelete {
+    auto operator()(float* data) const -> void {
+      ::operator delete[](data, std::align_val_t{kAlignment});
+    }
+  };
+
+  size_t size_ = 0;
+  size_t stride_ = 0;
+  std::unique_ptr<float[], AlignedDelete> data_;
+};
+
+/// @brief The adjacency matrix of a graph: the cost of the cheapest edge
+/// between each pair of nodes (`INF` if none, 0 on the diagonal).
+template <ArcGraph Graph>
+auto adjacency_matrix(const Graph& graph) -> DistanceMatrix {
+  DistanceMatrix matrix(graph.num_nodes());
+  for (NodeId from = 0; from < graph.num_nodes(); from++) {
+    graph.for_each_arc(from, [&](NodeId to, float cost) {
+      auto& entry = matrix.at(from, to);
+      entry = std::min(entry, cost);
+    });
+  }
+  return matrix;
+}
+
+/// @brief The adjacency matrix of a (mutable) graph, indexed by `NodeId`.
+inline auto adjacency_matrix(const DirectedAcyclicGraph& graph)
+    -> DistanceMatrix {
+  return adjacency_matrix(CsrGraph::from(graph));
+}
+
+// ---------------------------------------------------------------------------
+// Min-plus kernels
+// ---------------------------------------------------------------------------
+
+/// @brief Relaxes one tile through another pair of tiles:
+/// `c[i][j] = min(c[i][j], a[i][k] + b[k][j])` for every `k`, `i`, `j` of a
+/// `config::APSP_TILE_SIZE` square tile (rows `stride` floats apart).
+///
+/// `k` is the outer loop, so the tiles may alias (as they do on the
+/// diagonal of Floyd-Warshall) and each step sees the previous ones.
+inline auto min_plus_scalar(float* c, const float* a, const float* b,
+                            size_t stride) -> void {
+  constexpr auto kTile = config::APSP_TILE_SIZE;
+  for (size_t k = 0; k < kTile; k++) {
+    const float* b_row = b + k * stride;
+    for (size_t i = 0; i < kTile; i++) {
+      const auto a_ik = a[i * stride + k];
+      if (a_ik == INF) continue;
+      float* c_row = c + i * stride;
+      for (size_t j = 0; j < kTile; j++) {
+        c_row[j] = std::min(c_row[j], a_ik + b_row[j]);
+      }
+    }
+  }
+}
+
+#if defined(GRAPH_HAS_AVX2_KERNEL)
+/// @brief `min_plus_scalar()` with 8 columns per instruction (AVX2), 32
+/// columns per iteration. Only called on CPUs that support AVX2, so the
+/// rest of the build doesn't need `-mavx2`.
+__attribute__((target("avx2"))) inline auto min_plus_avx2(
+    float* c, const float* a, const float* b, size_t stride) -> void {
+  constexpr auto kTile = config::APSP_TILE_SIZE;
+  static_assert(kTile % 32 == 0, "the AVX2 kernel unrolls 4x8 columns");
+  for (size_t k = 0; k < kTile; k++) {
+    const float* b_row = b + k * stride;
+    for (size_t i = 0; i < kTile; i++) {
+      const auto a_ik = a[i * stride + k];
+      if (a_ik == INF) continue;
+      const auto a_broadcast = _mm256_set1_ps(a_ik);
+      float* c_row = c + i * stride;
+      for (size_t j = 0; j < kTile; j += 32) {
+        const auto b0 = _mm256_load_ps(b_row + j);
+        const auto b1 = _mm256_load_ps(b_row + j + 8);
+        const auto b2 = _mm256_load_ps(b_row + j + 16);
+        const auto b3 = _mm256_load_ps(b_row + j + 24);
+        _mm256_store_ps(c_row + j,
+                        _mm256_min_ps(_mm256_load_ps(c_row + j),
+                                      _mm256_add_ps(a_broadcast, b0)));
+        _mm256_store_ps(c_row + j + 8,
+                        _mm256_min_ps(_mm256_load_ps(c_row + j + 8),
+                                      _mm256_add_ps(a_broadcast, b1)));
+        _mm256_store_ps(c_row + j + 16,
+                        _mm256_min_ps(_mm256_load_ps(c_row + j + 16),
+                                      _mm256_add_ps(a_broadcast, b2)));
+        _mm256_store_ps(c_row + j + 24,
+                        _mm256_min_ps(_mm256_load_ps(c_row + j + 24),
+                                      _mm256_add_ps(a_broadcast, b3)));
+      }
+    }
+  }
+}
+#endif
+
+/// @brief A min-plus tile kernel (see `min_plus_scalar()`).
+using MinPlusKernel = void (*)(float*, const float*, const float*, size_t);
+
+/// @brief The fastest min-plus kernel the CPU supports.
+inline auto min_plus_kernel() -> MinPlusKernel {
+#if defined(GRAPH_HAS_AVX2_KERNEL)
+  static const MinPlusKernel kernel =
+      __builtin_cpu_supports("avx2") ? min_plus_avx2 : min_plus_scalar;
+  return kernel;
+#else
+  return min_plus_scalar;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// All-pairs shortest paths
+// ---------------------------------------------------------------------------
+
+/// @brief Turns an adjacency matrix into the matrix of shortest path costs,
+/// in place, with a blocked Floyd-Warshall.
+///
+/// The matrix is split into `config::APSP_TILE_SIZE` square tiles (64 x 64
+/// floats = 16 KiB, so the three tiles a kernel touches stay in L1/L2). For
+/// every diagonal tile `kk`: the tile itself is closed first, then the
+/// tiles in its row and column (in parallel), then all remaining tiles (in
+/// parallel), each through the min-plus kernel. O(n^3) like the plain
+/// triple loop, but compute-bound rather than memory-bound.
+///
+/// Negative edges are fine; a negative cycle shows up as a negative
+/// diagonal entry.
+///
+/// @param threads The maximum number of threads tiles are spread over.
+inline auto floyd_warshall(DistanceMatrix& matrix,
+                           size_t threads = parallel::num_threads()) -> void {
+  tracing::Span span("floyd_warshall", "search");
+  span.arg("nodes", matrix.size());
+  constexpr auto kTile = config::APSP_TILE_SIZE;
+  const auto kernel = min_plus_kernel();
+  const auto stride = matrix.stride();
+  const auto tiles = stride / kTile;
+  auto tile = [&](size_t row, size_t column) {
+    return matrix.data() + row * kTile * stride + column * kTile;
+  };
+
+  for (size_t kk = 0; kk < tiles; kk++) {
+    auto diagonal = tile(kk, kk);
+    kernel(diagonal, diagonal, diagonal, stride);
+
+    // The rest of row `kk` and column `kk` only depend on the diagonal
+    parallel::parallel_for(
+        2 * tiles,
+        [&](size_t index) {
+          const auto other = index / 2;
+          if (other == kk) return;
+          if (index % 2 == 0) {
+            auto row_tile = tile(kk, other);
+            kernel(row_tile, diagonal, row_tile, stride);
+          } else {
+            auto column_tile = tile(other, kk);
+            kernel(column_tile, column_tile, diagonal, stride);
+          }
+        },
+        1, threads);
+
+    // Every other tile only depends on row and column `kk`
+    parallel::parallel_for(
+        tiles * tiles,
+        [&](size_t index) {
+          const auto row = index / tiles;
+          const auto column = index % tiles;
+          if (row == kk || column == kk) return;
+          kernel(tile(row, column), tile(row, kk), tile(kk, column), stride);
+        },
+        1, threads);
+  }
+}
+
+/// @brief The shortest path costs between all pairs of nodes of a sparse
+/// graph, with Johnson's algorithm: O(V E log V) instead of O(V^3).
+///
+/// Bellman-Ford from a virtual source computes a potential `h` that makes
+/// every edge cost `c(u, v) + h(u) - h(v)` non-negative, then one Dijkstra
+/// per source (in parallel, each thread with its own `SearchContext`) runs
+/// on the reweighted edges.
+///
+/// @param threads The maximum number of threads sources are spread over.
+/// @return The matrix of shortest path costs, or nothing if the graph has a
+///         negative cycle.
+template <ArcGraph Graph>
+auto johnson(const Graph& graph, size_t threads = parallel::num_threads())
+    -> optional<DistanceMatrix> {
+  tracing::Span span("johnson", "search");
+  const auto num_nodes = graph.num_nodes();
+  span.arg("nodes", num_nodes).arg("edges", graph.num_edges());
+
+  // Bellman-Ford from a virtual source with a 0-cost edge to every node
+  vector<float> potential(num_nodes, 0.0f);
+  auto changed = true;
+  for (size_t round = 0; changed && round <= num_nodes; round++) {
+    changed = false;
+    for (NodeId from = 0; from < num_nodes; from++) {
+      graph.for_each_arc(from, [&](NodeId to, float cost) {
+        if (potential[from] + cost < potential[to]) {
+          potential[to] = potential[from] + cost;
+          changed = true;
+        }
+      });
+    }
+  }
+  if (changed) {
+    tracing::warn("johnson: the graph has a negative cycle");
+    return std::nullopt;
+  }
+
+  DistanceMatrix distances(num_nodes);
+  parallel::parallel_for(
+      num_nodes,
+      [&](size_t source) {
+        auto& context = internal_search_context();
+        context.begin(num_nodes);
+        context.relax(source, 0.0f, INVALID_NODE);
+        context.push(0.0f, source);
+        while (!context.open_empty()) {
+          const auto [cost, id] = context.pop();
+          if (context.closed(id)) continue;
+          context.close(id);
+          distances.at(source, id) = cost - potential[source] + potential[id];
+          graph.for_each_arc(id, [&](NodeId next, float edge_cost) {
+            // Clamp rounding errors that would make the cost negative
+            const auto reweighted = std::max(
+                0.0f, edge_cost + potential[id] - potential[next]);
+            const auto next_cost = cost + reweighted;
+            if (next_cost < context.cost(next)) {
+              context.relax(next, next_cost, id);
+              context.push(next_cost, next);
+            }
+          });
+        }
+      },
+      1, threads);
+  return distances;
+}
+
+}  // namespace graph
@@ -0,0 +1,387 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "graph/csr.h"
+#include "graph/graph.h"
+#include "utils/config.h"
+#include "utils/spans.h"
+
+using std::vector;
+
+namespace graph {
+
+/// @brief The hop count of nodes a BFS did not reach.
+static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+
+// ---------------------------------------------------------------------------
+// Bit-packed adjacency
+// ---------------------------------------------------------------------------
+
+/// @brief Calls `visit(index)` for every set bit of `bits`, where bit `b` of
+/// word `w` has index `w * 64 + b`.
+template <typename Visit>
+inline auto for_each_bit(std::span<const uint64_t> bits, Visit&& visit)
+    -> void {
+  for (size_t word = 0; word < bits.size(); word++) {
+    for (auto remaining = bits[word]; remaining != 0;
+         remaining &= remaining - 1) {
+      visit(static_cast<NodeId>(word * 64 + std::countr_zero(remaining)));
+    }
+  }
+}
+
+/// @brief The unweighted adjacency of a graph, bit-packed: bit `v` of row
+/// `u` of `out` is set iff there is an edge `u -> v`, and `in` is its
+/// transpose. Each row is also kept as a list of the set bits.
+///
+/// A row costs `n / 64` words to scan and a list costs one entry per edge,
+/// so traversals use whichever is shorter for each node (see `dense()`):
+/// on dense parts of the graph whole words of neighbours are tested against
+/// a frontier or visited set at once, while sparse nodes never pay for
+/// their empty words. The rows take `n^2 / 4` bytes, so this is meant for
+/// dense or mid-sized graphs (a 20K node cluster takes 100 MB).
+class BitAdjacency {
+ public:
+  /// @brief The number of nodes per word.
+  static constexpr size_t kWordBits = 64;
+
+  BitAdjacency() = default;
+
+  /// @brief Packs the edges of a graph (costs and parallel edges are
+  /// ignored).
+  template <ArcGraph Graph>
+  static auto from(const Graph& graph) -> BitAdjacency {
+    BitAdjacency adjacency;
+    const auto n = graph.num_nodes();
+    const auto words = (n + kWordBits - 1) / kWordBits;
+    adjacency.num_nodes_ = n;
+    adjacency.words_ = words;
+    adjacency.out_.assign(n * words, 0);
+    adjacency.in_.assign(n * words, 0);
+    for (NodeId from = 0; from < n; from++) {
+      graph.for_each_arc(from, [&](NodeId to, float) {
+        set(adjacency.out_.data() + from * words, to);
+        set(adjacency.in_.data() + to * words, from);
+      });
+    }
+    adjacency.out_lists_ = Lists::from_rows(adjacency.out_, n, words);
+    adjacency.in_lists_ = Lists::from_rows(adjacency.in_, n, words);
+    return adjacency;
+  }
+
+  auto num_nodes() const -> size_t { return num_nodes_; }
+
+  /// @brief The number of words per row.
+  auto words() const -> size_t { return words_; }
+
+  /// @brief The nodes `node` has an edge to, as a row of bits.
+  auto out(NodeId node) const -> std::span<const uint64_t> {
+    return {out_.data() + node * words_, words_};
+  }
+
+  /// @brief The nodes that have an edge to `node`, as a row of bits.
+  auto in(NodeId node) const -> std::span<const uint64_t> {
+    return {in_.data() + node * words_, words_};
+  }
+
+  /// @brief The nodes `node` has an edge to, as a list.
+  auto out_list(NodeId node) const -> std::span<const NodeId> {
+    return out_lists_.of(node);
+  }
+
+  /// @brief The nodes that have an edge to `node`, as a list.
+  auto in_list(NodeId node) const -> std::span<const NodeId> {
+    return in_lists_.of(node);
+  }
+
+  /// @brief The number of distinct nodes `node` has an edge to.
+  auto out_degree(NodeId node) const -> uint32_t {
+    return out_lists_.degree(node);
+  }
+
+  /// @brief The number of distinct nodes that have an edge to `node`.
+  auto in_degree(NodeId node) const -> uint32_t {
+    return in_lists_.degree(node);
+  }
+
+  /// @brief Whether a list of `degree` nodes is longer than a row.
+  auto dense(uint32_t degree) const -> bool { return degree > words_; }
+
+  auto has_edge(NodeId from, NodeId to) const -> bool {
+    return out(from)[to / kWordBits] >> (to % kWordBits) & 1;
+  }
+
+ private:
+  /// @brief The rows as lists, in CSR form.
+  struct Lists {
+    vector<uint32_t> offsets{0};
+    vector<NodeId> nodes;
+
+    static auto from_rows(const vector<uint64_t>& rows, size_t n,
+                          size_t words) -> Lists {
+      Lists lists;
+      lists.offsets.resize(n + 1);
+      for (size_t node = 0; node < n; node++) {
+        lists.offsets[node] = static_cast<uint32_t>(lists.nodes.size());
+        for_each_bit({rows.data() + node * words, words},
+                     [&](NodeId other) { lists.nodes.push_back(other); });
+      }
+      lists.offsets[n] = static_cast<uint32_t>(lists.nodes.size());
+      return lists;
+    }
+
+    auto of(NodeId node) const -> std::span<const NodeId> {
+      return {nodes.data() + offsets[node], degree(node)};
+    }
+
+    auto degree(NodeId node) const -> uint32_t {
+      return offsets[node + 1] - offsets[node];
+    }
+  };
+
+  static auto set(uint64_t* row, NodeId node) -> void {
+    row[node / kWordBits] |= uint64_t{1} << (node % kWordBits);
+  }
+
+  size_t num_nodes_ = 0;
+  size_t words_ = 0;
+  vector<uint64_t> out_;
+  vector<uint64_t> in_;
+  Lists out_lists_;
+  Lists in_lists_;
+};
+
+// ---------------------------------------------------------------------------
+// Direction-optimizing BFS
+// ---------------------------------------------------------------------------
+
+/// @brief What a `bfs()` did, for tuning `config::BFS_ALPHA`/`BFS_BETA`.
+struct BfsStats {
+  size_t top_down_steps = 0;
+  size_t bottom_up_steps = 0;
+};
+
+/// @brief Whether any of the nodes with an edge to `node` is set in `bits`.
+inline auto has_parent_in(const BitAdjacency& graph, NodeId node,
+                          const vector<uint64_t>& bits) -> bool {
+  if (!graph.dense(graph.in_degree(node))) {
+    for (auto parent : graph.in_list(node)) {
+      if (bits[parent / 64] >> (parent % 64) & 1) return true;
+    }
+    return false;
+  }
+  const auto parents = graph.in(node);
+  for (size_t word = 0; word < parents.size(); word++) {
+    if (parents[word] & bits[word]) return true;
+  }
+  return false;
+}
+
+/// @brief The number of hops from `source` to every node (`UNREACHABLE` for
+/// nodes it cannot reach), with a direction-optimizing BFS.
+///
+/// Small frontiers are expanded top-down: the unvisited bits of each
+/// frontier node's row become the next frontier. Once the frontier's edges
+/// outnumber the unexplored edges by `config::BFS_ALPHA`, each step goes
+/// bottom-up instead: every unvisited node looks for a parent in the frontier
+/// bitmap (ANDing 64 candidate parents at a time on dense nodes), and stops
+/// at the first hit. The BFS switches back once the frontier shrinks below
+/// `n / config::BFS_BETA` nodes. On low-diameter graphs the few huge middle
+/// levels are where the bottom-up steps save most of the work.
+inline auto bfs(const BitAdjacency& graph, NodeId source,
+                BfsStats* stats = nullptr) -> vector<uint32_t> {
+  tracing::Span span("bfs", "search");
+  const auto n = graph.num_nodes();
+  const auto words = graph.words();
+  vector<uint32_t> hops(n, UNREACHABLE);
+  vector<uint64_t> visited(words, 0);
+  vector<uint64_t> frontier_bits(words, 0);
+  vector<uint64_t> next_bits(words, 0);
+  vector<NodeId> frontier;
+  vector<NodeId> next;
+  auto visit = [&](NodeId node, uint32_t level) {
+    hops[node] = level;
+    visited[node / 64] |= uint64_t{1} << (node % 64);
+  };
+
+  size_t unexplored_edges = 0;
+  for (NodeId node = 0; node < n; node++) {
+    unexplored_edges += graph.out_degree(node);
+  }
+  visit(source, 0);
+  frontier.push_back(source);
+  unexplored_edges -= graph.out_degree(source);
+  auto bottom_up = false;
+
+  for (uint32_t level = 1; !frontier.empty(); level++) {
+    size_t frontier_edges = 0;
+    for (auto node : frontier) frontier_edges += graph.out_degree(node);
+    if (!bottom_up) {
+      bottom_up = frontier_edges * config::BFS_ALPHA > unexplored_edges;
+    } else {
+      bottom_up = frontier.size() * config::BFS_BETA >= n;
+    }
+
+    next.clear();
+    if (bottom_up) {
+      if (stats != nullptr) stats->bottom_up_steps++;
+      std::fill(frontier_bits.begin(), frontier_bits.end(), 0);
+      for (auto node : frontier) {
+        frontier_bits[node / 64] |= uint64_t{1} << (node % 64);
+      }
+      std::fill(next_bits.begin(), next_bits.end(), 0);
+      for (size_t word = 0; word < words; word++) {
+        auto unvisited = ~visited[word];
+        if (word + 1 == words && n % 64 != 0) {
+          unvisited &= (uint64_t{1} << (n % 64)) - 1;
+        }
+        for (; unvisited != 0; unvisited &= unvisited - 1) {
+          const auto node =
+              static_cast<NodeId>(word * 64 + std::countr_zero(unvisited));
+          if (has_parent_in(graph, node, frontier_bits)) {
+            next_bits[word] |= uint64_t{1} << (node % 64);
+            next.push_back(node);
+          }
+        }
+      }
+      // Mark after the scan, so the step only sees the current frontier
+      for (size_t word = 0; word < words; word++) {
+        visited[word] |= next_bits[word];
+      }
+      for (auto node : next) hops[node] = level;
+    } else {
+      if (stats != nullptr) stats->top_down_steps++;
+      for (auto node : frontier) {
+        if (!graph.dense(graph.out_degree(node))) {
+          for (auto next_node : graph.out_list(node)) {
+            if (visited[next_node / 64] >> (next_node % 64) & 1) continue;
+            visit(next_node, level);
+            next.push_back(next_node);
+          }
+          continue;
+        }
+        const auto row = graph.out(node);
+        for (size_t word = 0; word < words; word++) {
+          for (auto fresh = row[word] & ~visited[word]; fresh != 0;
+               fresh &= fresh - 1) {
+            const auto next_node =
+                static_cast<NodeId>(word * 64 + std::countr_zero(fresh));
+            visit(next_node, level);
+            next.push_back(next_node);
+          }
+        }
+      }
+    }
+    for (auto node : next) unexplored_edges -= graph.out_degree(node);
+    frontier.swap(next);
+  }
+
+  if (stats != nullptr) {
+    span.arg("top_down", stats->top_down_steps)
+        .arg("bottom_up", stats->bottom_up_steps);
+  }
+  return hops;
+}
+
+// ---------------------------------------------------------------------------
+// Multi-source BFS
+// ---------------------------------------------------------------------------
+
+/// @brief The hop counts of up to 64 BFS runs (see `multi_source_bfs()`).
+class MultiSourceHops {
+ public:
+  /// @brief The most sources one run takes (one bit each in a mask).
+  static constexpr size_t kMaxSources = 64;
+
+  MultiSourceHops(size_t num_sources, size_t num_nodes)
+      : num_sources_(num_sources),
+        hops_(num_sources * num_nodes, UNREACHABLE),
+        reached_(num_nodes, 0) {}
+
+  auto num_sources() const -> size_t { return num_sources_; }
+
+  /// @brief The number of hops from the `source`-th source to `node`.
+  auto hops(size_t source, NodeId node) const -> uint32_t {
+    return hops_[node * num_sources_ + source];
+  }
+
+  /// @brief Which sources reach `node` (bit `i` for the `i`-th source).
+  auto reached_by(NodeId node) const -> uint64_t { return reached_[node]; }
+
+ private:
+  friend auto multi_source_bfs(const BitAdjacency&, std::span<const NodeId>)
+      -> MultiSourceHops;
+
+  size_t num_sources_;
+  /// @brief Node-major, so a node's counts for all sources share a line.
+  vector<uint32_t> hops_;
+  vector<uint64_t> reached_;
+};
+
+/// @brief Runs a BFS from each of up to 64 sources at once.
+///
+/// Every node carries a 64-bit mask of the runs that have seen it and of the
+/// runs whose frontier it is in, so a single pass over a node's edges
+/// advances all the runs that are at that node together (as in MS-BFS).
+/// Runs from nearby sources share most of their traversal, which is what
+/// makes all-sources hop analytics (e.g. eccentricities, closeness) cheap.
+///
+/// @param sources At most `MultiSourceHops::kMaxSources` nodes (duplicates
+///                are allowed).
+/// @throws std::invalid_argument If there are more sources than that.
+inline auto multi_source_bfs(const BitAdjacency& graph,
+                             std::span<const NodeId> sources)
+    -> MultiSourceHops {
+  if (sources.size() > MultiSourceHops::kMaxSources) {
+    throw std::invalid_argument("multi_source_bfs: more than 64 sources");
+  }
+  tracing::Span span("multi_source_bfs", "search");
+  const auto n = graph.num_nodes();
+  const auto num_sources = sources.size();
+  MultiSourceHops result(num_sources, n);
+  auto& seen = result.reached_;
+  vector<uint64_t> visit(n, 0);
+  vector<uint64_t> visit_next(n, 0);
+
+  for (size_t i = 0; i < num_sources; i++) {
+    const auto bit = uint64_t{1} << i;
+    seen[sources[i]] |= bit;
+    visit[sources[i]] |= bit;
+    result.hops_[sources[i] * num_sources + i] = 0;
+  }
+
+  for (uint32_t level = 1;; level++) {
+    auto any = false;
+    for (NodeId node = 0; node < n; node++) {
+      const auto runs = visit[node];
+      if (runs == 0) continue;
+      // Each neighbour gets its own mask updated, so a row of bits (which
+      // still has to be decoded into nodes) is never cheaper than the list
+      for (auto next : graph.out_list(node)) {
+        visit_next[next] |= runs & ~seen[next];
+      }
+    }
+    for (NodeId node = 0; node < n; node++) {
+      const auto fresh = visit_next[node] & ~seen[node];
+      visit[node] = fresh;
+      visit_next[node] = 0;
+      if (fresh == 0) continue;
+      any = true;
+      seen[node] |= fresh;
+      for (auto bits = fresh; bits != 0; bits &= bits - 1) {
+        result.hops_[node * num_sources + std::countr_zero(bits)] = level;
+      }
+    }
+    if (!any) break;
+  }
+  return result;
+}
+
+}  // namespace graph
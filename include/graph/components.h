@@ -0,0 +1,543 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "graph/csr.h"
+#include "graph/graph.h"
+#include "utils/data_structures/union_find.h"
+#include "utils/parallel.h"
+#include "utils/spans.h"
+
+using std::vector;
+
+namespace graph {
+
+/// @brief A partition of a graph's nodes into components.
+struct Components {
+  /// @brief The component of each node (in `[0, num_components)`).
+  vector<uint32_t> component;
+  size_t num_components = 0;
+
+  /// @brief The number of nodes in each component.
+  auto sizes() const -> vector<uint32_t> {
+    vector<uint32_t> sizes(num_components, 0);
+    for (auto id : component) sizes[id]++;
+    return sizes;
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Strongly connected components (sequential)
+// ---------------------------------------------------------------------------
+
+/// @brief The strongly connected components of a graph, with Tarjan's
+/// algorithm: O(V + E), one depth-first search.
+///
+/// The search keeps its own stack of (node, next arc) frames rather than
+/// recursing, so paths of any length (e.g. a 10^7 node chain) only cost heap
+/// memory. Components are numbered in topological order: every edge between
+/// two components goes from a smaller id to a larger one.
+inline auto strongly_connected_components(const CsrGraph& graph)
+    -> Components {
+  tracing::Span span("strongly_connected_components", "graph");
+  constexpr auto kUnvisited = UINT32_MAX;
+  const auto num_nodes = graph.num_nodes();
+  const auto& offsets = graph.offsets();
+  const auto& targets = graph.targets();
+  span.arg("nodes", num_nodes).arg("edges", graph.num_edges());
+
+  struct Frame {
+    NodeId node;
+    /// @brief The position of the next arc to follow in `targets`.
+    uint32_t next;
+  };
+
+  Components result;
+  result.component.assign(num_nodes, 0);
+  vector<uint32_t> index(num_nodes, kUnvisited);
+  vector<uint32_t> low(num_nodes);
+  vector<bool> on_stack(num_nodes, false);
+  vector<NodeId> stack;
+  vector<Frame> calls;
+  uint32_t visited = 0;
+
+  auto enter = [&](NodeId node) {
+    index[node] = low[node] = visited++;
+    stack.push_back(node);
+    on_stack[node] = true;
+    calls.push_back({node, offsets[node]});
+  };
+
+  for (NodeId root = 0; root < num_nodes; root++) {
+    if (index[root] != kUnvisited) continue;
+    enter(root);
+    while (!calls.empty()) {
+      const auto node = calls.back().node;
+      if (calls.back().next < offsets[node + 1]) {
+        const auto next = targets[calls.back().next++];
+        if (index[next] == kUnvisited) {
+          enter(next);
+        } else if (on_stack[next]) {
+          low[node] = std::min(low[node], index[next]);
+        }
+        continue;
+      }
+
+      calls.pop_back();
+      if (!calls.empty()) {
+        const auto parent = calls.back().node;
+        low[parent] = std::min(low[parent], low[node]);
+      }
+      if (low[node] != index[node]) continue;
+      // `node` is the root of a component: everything above it on the stack
+      NodeId member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        on_stack[member] = false;
+        result.component[member] =
+            static_cast<uint32_t>(result.num_components);
+      } while (member != node);
+      result.num_components++;
+    }
+  }
+
+  // Tarjan completes sink components first, flip to topological order
+  for (auto& id : result.component) {
+    id = static_cast<uint32_t>(result.num_components - 1 - id);
+  }
+  span.arg("components", result.num_components);
+  return result;
+}
+
+/// @brief The strongly connected components of a (mutable) graph, indexed
+/// by `NodeId`.
+inline auto strongly_connected_components(const DirectedAcyclicGraph& graph)
+    -> Components {
+  return strongly_connected_components(CsrGraph::from(graph));
+}
+
+/// @brief Whether a graph has no cycle (`add_edge()` doesn't check).
+inline auto is_acyclic(const CsrGraph& graph) -> bool {
+  for (NodeId node = 0; node < graph.num_nodes(); node++) {
+    auto self_loop = false;
+    graph.for_each_arc(node, [&](NodeId to, float) {
+      self_loop = self_loop || to == node;
+    });
+    if (self_loop) return false;
+  }
+  return strongly_connected_components(graph).num_components ==
+         graph.num_nodes();
+}
+
+inline auto is_acyclic(const DirectedAcyclicGraph& graph) -> bool {
+  return is_acyclic(CsrGraph::from(graph));
+}
+
+// ---------------------------------------------------------------------------
+// Strongly connected components (parallel)
+// ---------------------------------------------------------------------------
+
+/// @brief The nodes found by one step of a parallel traversal. Any thread
+/// may append; each node is appended at most twice per step.
+class Worklist {
+ public:
+  explicit Worklist(size_t num_nodes) : nodes_(2 * num_nodes) {}
+
+  auto push(NodeId node) -> void {
+    nodes_[size_.fetch_add(1, std::memory_order_relaxed)] = node;
+  }
+
+  /// @brief Moves the appended nodes to `out` and empties the list.
+  auto take(vector<NodeId>& out) -> void {
+    const auto size = size_.exchange(0, std::memory_order_relaxed);
+    out.assign(nodes_.begin(), nodes_.begin() + size);
+  }
+
+ private:
+  vector<NodeId> nodes_;
+  std::atomic<size_t> size_{0};
+};
+
+/// @brief The strongly connected components of a graph, in parallel, for
+/// graphs too large for one thread.
+///
+/// Three phases, each level-synchronous with every level spread over the
+/// threads:
+///  1. Trimming: nodes without incoming or outgoing edges (from nodes that
+///     aren't assigned yet) are components of their own. Removing one
+///     decrements its neighbours' degrees, which may trim them in turn.
+///  2. Forward-backward: the nodes both reachable from and reaching a pivot
+///     (the node with the largest in x out degree) form its component.
+///     Real graphs usually have one giant component, found here at once.
+///  3. Coloring, for the many small components left: every node takes the
+///     largest id that reaches it (propagated forward until nothing
+///     changes), then each node whose color is its own id collects its
+///     component backwards among the nodes of its color. Repeated (with
+///     trimming) until every node is assigned.
+///
+/// Components are numbered in the order they are found, which varies
+/// between runs; use `strongly_connected_components()` for a topological
+/// numbering.
+///
+/// @param threads The maximum number of threads nodes are spread over.
+inline auto parallel_strongly_connected_components(
+    const CsrGraph& graph, size_t threads = parallel::num_threads())
+    -> Components {
+  tracing::Span span("parallel_strongly_connected_components", "graph");
+  constexpr auto kUnassigned = UINT32_MAX;
+  constexpr auto kClaimed = UINT32_MAX - 1;
+  constexpr size_t kGrain = 256;
+  const auto num_nodes = graph.num_nodes();
+  const auto reverse = graph.transpose();
+  span.arg("nodes", num_nodes).arg("edges", graph.num_edges());
+
+  vector<std::atomic<uint32_t>> component(num_nodes);
+  // The degrees of each node among the unassigned nodes (self loops are
+  // left out, they don't keep a node from being trimmed)
+  vector<std::atomic<uint32_t>> in_degree(num_nodes);
+  vector<std::atomic<uint32_t>> out_degree(num_nodes);
+  std::atomic<uint32_t> num_components{0};
+  Worklist found(num_nodes);
+  vector<NodeId> frontier;
+  // The last traversal level each node was queued in
+  vector<std::atomic<uint32_t>> queued(num_nodes);
+  uint32_t level = 0;
+
+  auto unassigned = [&](NodeId node) {
+    return component[node].load(std::memory_order_relaxed) == kUnassigned;
+  };
+  auto count_arcs = [](const CsrGraph& arcs, NodeId node) {
+    uint32_t count = 0;
+    arcs.for_each_arc(node, [&](NodeId to, float) { count += to != node; });
+    return count;
+  };
+  parallel::parallel_for(
+      num_nodes,
+      [&](size_t node) {
+        component[node].store(kUnassigned, std::memory_order_relaxed);
+        queued[node].store(0, std::memory_order_relaxed);
+        in_degree[node].store(count_arcs(reverse, node),
+                              std::memory_order_relaxed);
+        out_degree[node].store(count_arcs(graph, node),
+                               std::memory_order_relaxed);
+      },
+      kGrain, threads);
+
+  // Decrements the degrees of an assigned node's neighbours, queueing the
+  // ones that can now be trimmed
+  Worklist trimmable(num_nodes);
+  auto detach = [&](NodeId node) {
+    graph.for_each_arc(node, [&](NodeId to, float) {
+      if (to == node || !unassigned(to)) return;
+      if (in_degree[to].fetch_sub(1, std::memory_order_relaxed) == 1) {
+        trimmable.push(to);
+      }
+    });
+    reverse.for_each_arc(node, [&](NodeId from, float) {
+      if (from == node || !unassigned(from)) return;
+      if (out_degree[from].fetch_sub(1, std::memory_order_relaxed) == 1) {
+        trimmable.push(from);
+      }
+    });
+  };
+  auto trim = [&] {
+    vector<NodeId> batch;
+    for (trimmable.take(batch); !batch.empty(); trimmable.take(batch)) {
+      parallel::parallel_for(
+          batch.size(),
+          [&](size_t i) {
+            const auto node = batch[i];
+            // Claimed first, so that only the winner takes an id
+            auto expected = kUnassigned;
+            if (!component[node].compare_exchange_strong(
+                    expected, kClaimed, std::memory_order_relaxed)) {
+              return;
+            }
+            component[node].store(
+                num_components.fetch_add(1, std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            detach(node);
+          },
+          kGrain, threads);
+    }
+  };
+
+  // Expands `frontier` level by level along `arcs`, into the nodes
+  // `claim(from, to)` accepts, and returns every node reached (a node
+  // claimed several times in one level is queued once)
+  auto traverse = [&](const CsrGraph& arcs, auto&& claim) {
+    vector<NodeId> reached = frontier;
+    while (!frontier.empty()) {
+      level++;
+      parallel::parallel_for(
+          frontier.size(),
+          [&](size_t i) {
+            const auto from = frontier[i];
+            arcs.for_each_arc(from, [&](NodeId to, float) {
+              if (claim(from, to) &&
+                  queued[to].exchange(level, std::memory_order_relaxed) !=
+                      level) {
+                found.push(to);
+              }
+            });
+          },
+          kGrain, threads);
+      found.take(frontier);
+      reached.insert(reached.end(), frontier.begin(), frontier.end());
+    }
+    return reached;
+  };
+
+  // 1. Trimming
+  parallel::parallel_for(
+      num_nodes,
+      [&](size_t node) {
+        if (in_degree[node].load(std::memory_order_relaxed) == 0 ||
+            out_degree[node].load(std::memory_order_relaxed) == 0) {
+          trimmable.push(static_cast<NodeId>(node));
+        }
+      },
+      kGrain, threads);
+  trim();
+
+  // 2. Forward-backward from the pivot
+  auto pivot = INVALID_NODE;
+  uint64_t best = 0;
+  for (NodeId node = 0; node < num_nodes; node++) {
+    if (!unassigned(node)) continue;
+    const uint64_t score =
+        uint64_t{in_degree[node].load(std::memory_order_relaxed)} *
+        out_degree[node].load(std::memory_order_relaxed);
+    if (pivot == INVALID_NODE || score > best) {
+      pivot = node;
+      best = score;
+    }
+  }
+  if (pivot != INVALID_NODE) {
+    // 0: unseen, 1: reached forwards, 2: reached both ways
+    vector<std::atomic<uint8_t>> reached(num_nodes);
+    auto mark = [&](NodeId node, uint8_t from, uint8_t to) {
+      auto expected = from;
+      return reached[node].compare_exchange_strong(expected, to,
+                                                   std::memory_order_relaxed);
+    };
+    mark(pivot, 0, 1);
+    frontier = {pivot};
+    traverse(graph, [&](NodeId, NodeId to) {
+      return unassigned(to) && mark(to, 0, 1);
+    });
+    mark(pivot, 1, 2);
+    frontier = {pivot};
+    const auto members =
+        traverse(reverse, [&](NodeId, NodeId to) { return mark(to, 1, 2); });
+    const auto id = num_components.fetch_add(1, std::memory_order_relaxed);
+    for (auto node : members) {
+      component[node].store(id, std::memory_order_relaxed);
+    }
+    parallel::parallel_for(
+        members.size(), [&](size_t i) { detach(members[i]); }, kGrain,
+        threads);
+    trim();
+    span.arg("pivot_component", members.size());
+  }
+
+  // 3. Coloring
+  vector<NodeId> remaining;
+  for (NodeId node = 0; node < num_nodes; node++) {
+    if (unassigned(node)) remaining.push_back(node);
+  }
+  vector<std::atomic<uint32_t>> color(num_nodes);
+  size_t rounds = 0;
+  while (!remaining.empty()) {
+    rounds++;
+    parallel::parallel_for(
+        remaining.size(),
+        [&](size_t i) {
+          color[remaining[i]].store(remaining[i], std::memory_order_relaxed);
+        },
+        kGrain, threads);
+
+    // Push colors forward, revisiting only nodes whose color grew
+    frontier = remaining;
+    traverse(graph, [&](NodeId from, NodeId to) {
+      if (!unassigned(to)) return false;
+      const auto incoming = color[from].load(std::memory_order_relaxed);
+      auto current = color[to].load(std::memory_order_relaxed);
+      while (incoming > current) {
+        if (color[to].compare_exchange_weak(current, incoming,
+                                            std::memory_order_relaxed)) {
+          return true;
+        }
+      }
+      return false;
+    });
+
+    // Each color's root collects the nodes of its color that reach it
+    frontier.clear();
+    for (auto node : remaining) {
+      if (color[node].load(std::memory_order_relaxed) != node) continue;
+      component[node].store(
+          num_components.fetch_add(1, std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      frontier.push_back(node);
+    }
+    const auto members = traverse(reverse, [&](NodeId from, NodeId to) {
+      if (color[to].load(std::memory_order_relaxed) !=
+          color[from].load(std::memory_order_relaxed)) {
+        return false;
+      }
+      auto expected = kUnassigned;
+      return component[to].compare_exchange_strong(
+          expected, component[from].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+    });
+    parallel::parallel_for(
+        members.size(), [&](size_t i) { detach(members[i]); }, kGrain,
+        threads);
+    trim();
+    std::erase_if(remaining, [&](NodeId node) { return !unassigned(node); });
+  }
+  span.arg("coloring_rounds", rounds);
+
+  Components result;
+  result.num_components = num_components.load();
+  result.component.resize(num_nodes);
+  for (NodeId node = 0; node < num_nodes; node++) {
+    result.component[node] = component[node].load(std::memory_order_relaxed);
+  }
+  span.arg("components", result.num_components);
+  return result;
+}
+
+// ---------------------------------------------------------------------------
+// Weakly connected components
+// ---------------------------------------------------------------------------
+
+/// @brief The weakly connected components of a graph (edges taken as
+/// undirected): every edge is united in parallel through a concurrent
+/// union-find. Components are numbered in the order of their smallest node.
+///
+/// @param threads The maximum number of threads nodes are spread over.
+inline auto weakly_connected_components(
+    const CsrGraph& graph, size_t threads = parallel::num_threads())
+    -> Components {
+  tracing::Span span("weakly_connected_components", "graph");
+  const auto num_nodes = graph.num_nodes();
+  span.arg("nodes", num_nodes).arg("edges", graph.num_edges());
+  data_structures::sets::ConcurrentUnionFind sets(num_nodes);
+  parallel::parallel_for(
+      num_nodes,
+      [&](size_t node) {
+        graph.for_each_arc(node, [&](NodeId to, float) {
+          sets.unite(static_cast<uint32_t>(node), to);
+        });
+      },
+      256, threads);
+
+  // The representative of each set is its smallest node, so it is numbered
+  // before the rest of its set
+  Components result;
+  result.component.resize(num_nodes);
+  for (NodeId node = 0; node < num_nodes; node++) {
+    const auto root = sets.find(node);
+    result.component[node] =
+        root == node ? static_cast<uint32_t>(result.num_components++)
+                     : result.component[root];
+  }
+  span.arg("components", result.num_components);
+  return result;
+}
+
+// ---------------------------------------------------------------------------
+// Condensation and pruning
+// ---------------------------------------------------------------------------
+
+/// @brief The condensation of a graph: one node per component, and an edge
+/// between two components if any of their nodes are linked (with the
+/// cheapest such cost). For strongly connected components, this is a DAG.
+inline auto condensation(const CsrGraph& graph, const Components& components)
+    -> CsrGraph {
+  vector<WeightedEdge> edges;
+  for (NodeId node = 0; node < graph.num_nodes(); node++) {
+    const auto from = components.component[node];
+    graph.for_each_arc(node, [&](NodeId to, float cost) {
+      const auto to_component = components.component[to];
+      if (to_component != from) edges.push_back({from, to_component, cost});
+    });
+  }
+  // The cheapest of each run of parallel edges comes first
+  std::sort(edges.begin(), edges.end(), [](const auto& a, const auto& b) {
+    return std::tie(a.from, a.to, a.cost) < std::tie(b.from, b.to, b.cost);
+  });
+  edges.erase(std::unique(edges.begin(), edges.end(),
+                          [](const auto& a, const auto& b) {
+                            return a.from == b.from && a.to == b.to;
+                          }),
+              edges.end());
+  return CsrGraph::from_edges(components.num_components, edges);
+}
+
+/// @brief The nodes reachable from `source` (itself included).
+inline auto reachable_from(const CsrGraph& graph, NodeId source)
+    -> vector<bool> {
+  vector<bool> reached(graph.num_nodes(), false);
+  vector<NodeId> stack = {source};
+  reached[source] = true;
+  while (!stack.empty()) {
+    const auto node = stack.back();
+    stack.pop_back();
+    graph.for_each_arc(node, [&](NodeId to, float) {
+      if (reached[to]) return;
+      reached[to] = true;
+      stack.push_back(to);
+    });
+  }
+  return reached;
+}
+
+/// @brief A subgraph with its own (dense) node ids.
+struct Subgraph {
+  CsrGraph graph;
+  /// @brief The id in the original graph of each node of the subgraph.
+  vector<NodeId> original;
+  /// @brief The id in the subgraph of each node of the original graph
+  /// (`INVALID_NODE` if it was left out).
+  vector<NodeId> index;
+};
+
+/// @brief The part of a graph a search from `source` to `target` can use:
+/// the nodes that are reachable from `source` and reach `target`, and the
+/// edges between them. Shrinks the input of preprocessing (e.g. all-pairs
+/// tables or landmarks) to what matters for the query.
+inline auto prune_unreachable(const CsrGraph& graph, NodeId source,
+                              NodeId target) -> Subgraph {
+  tracing::Span span("prune_unreachable", "graph");
+  const auto forward = reachable_from(graph, source);
+  const auto backward = reachable_from(graph.transpose(), target);
+
+  Subgraph subgraph;
+  subgraph.index.assign(graph.num_nodes(), INVALID_NODE);
+  for (NodeId node = 0; node < graph.num_nodes(); node++) {
+    if (!forward[node] || !backward[node]) continue;
+    subgraph.index[node] = static_cast<NodeId>(subgraph.original.size());
+    subgraph.original.push_back(node);
+  }
+  vector<WeightedEdge> edges;
+  for (auto node : subgraph.original) {
+    graph.for_each_arc(node, [&](NodeId to, float cost) {
+      if (subgraph.index[to] == INVALID_NODE) return;
+      edges.push_back({subgraph.index[node], subgraph.index[to], cost});
+    });
+  }
+  subgraph.graph = CsrGraph::from_edges(subgraph.original.size(), edges);
+  span.arg("nodes", subgraph.original.size()).arg("edges", edges.size());
+  return subgraph;
+}
+
+}  // namespace graph
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "graph/csr.h"
+
+using std::vector;
+
+namespace graph {
+
+// ---------------------------------------------------------------------------
+// Varints
+// ---------------------------------------------------------------------------
+
+/// @brief Appends `value` as a little-endian base-128 varint (7 bits per
+/// byte, high bit set on every byte but the last).
+inline auto encode_varint(uint32_t value, vector<uint8_t>& out) -> void {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+/// @brief Decodes a varint written by `encode_varint`, advancing `in`.
+inline auto decode_varint(const uint8_t*& in) -> uint32_t {
+  uint32_t value = *in & 0x7F;
+  // One byte covers gaps below 128, i.e. most edges of road-like graphs
+  if (*in++ < 0x80) return value;
+  for (uint32_t shift = 7;; shift += 7) {
+    const auto byte = *in++;
+    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if (byte < 0x80) return value;
+  }
+}
+
+/// @brief Maps signed integers to unsigned ones so that small magnitudes
+/// stay small (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...).
+inline auto zigzag_encode(int32_t value) -> uint32_t {
+  return (static_cast<uint32_t>(value) << 1) ^
+         static_cast<uint32_t>(value >> 31);
+}
+
+inline auto zigzag_decode(uint32_t value) -> int32_t {
+  return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+// ---------------------------------------------------------------------------
+// Compressed graph
+// ---------------------------------------------------------------------------
+
+/// @brief How a `CompressedGraph` stores edge costs.
+struct CompressionOptions {
+  /// @brief Whether to store costs as 16-bit steps between the smallest and
+  /// largest finite cost (instead of 32-bit floats). Each decoded cost is
+  /// then off by at most half a step, i.e. `(max - min) / 131068`; `INF`
+  /// costs (impassable edges) have a code of their own and stay exact.
+  bool quantize_costs = false;
+};
+
+/// @brief A read-only graph that stores each node's outgoing edges as a
+/// compact byte stream, decoded on the fly while it is traversed.
+///
+/// Each node's targets are sorted and gap-encoded: the first as a zigzag
+/// varint relative to the node's own id, the others as varint gaps from the
+/// previous target. On graphs with locality (road networks, or any graph
+/// whose ids were assigned in a spatial order) most gaps fit in a single
+/// byte. Costs follow their target in the stream, either as raw floats or
+/// quantized to 16 bits (see `CompressionOptions`). Compared to `CsrGraph`'s
+/// 8 bytes per edge that is typically 5 bytes, or 3 with quantized costs.
+class CompressedGraph {
+ public:
+  CompressedGraph() : offsets_(1, 0), block_starts_(1, 0) {}
+
+  /// @brief Compresses a CSR graph (its arcs are sorted on a copy).
+  static auto from(CsrGraph graph, CompressionOptions options = {})
+      -> CompressedGraph {
+    graph.sort_arcs();
+
+    CompressedGraph compressed;
+    compressed.quantized_ = options.quantize_costs;
+    compressed.num_edges_ = graph.num_edges();
+    if (compressed.quantized_) {
+      auto min = INF;
+      auto max = -INF;
+      for (auto cost : graph.costs()) {
+        if (cost == INF) continue;
+        min = std::min(min, cost);
+        max = std::max(max, cost);
+      }
+      if (min <= max) {
+        compressed.cost_min_ = min;
+        compressed.cost_step_ = (max - min) / kQuantizationSteps;
+      }
+    }
+
+    auto& bytes = compressed.bytes_;
+    bytes.reserve(graph.num_edges() * 3);
+    compressed.offsets_.resize(graph.num_nodes() + 1);
+    compressed.block_starts_.clear();
+    for (size_t node = 0; node < graph.num_nodes(); node++) {
+      compressed.set_offset(node);
+      auto previous = static_cast<NodeId>(node);
+      auto first = true;
+      graph.for_each_arc(node, [&](NodeId to, float cost) {
+        if (first) {
+          encode_varint(zigzag_encode(static_cast<int32_t>(to - previous)),
+                        bytes);
+          first = false;
+        } else {
+          encode_varint(to - previous, bytes);
+        }
+        previous = to;
+        compressed.encode_cost(cost);
+      });
+    }
+    compressed.set_offset(graph.num_nodes());
+    bytes.shrink_to_fit();
+    return compressed;
+  }
+
+  auto num_nodes() const -> size_t { return offsets_.size() - 1; }
+  auto num_edges() const -> size_t { return num_edges_; }
+
+  /// @brief Calls `visit(to, cost)` for every outgoing edge of a node, in
+  /// increasing order of `to`.
+  template <typename Visit>
+  auto for_each_arc(NodeId node, Visit&& visit) const -> void {
+    const uint8_t* in = bytes_.data() + position(node);
+    const uint8_t* end = bytes_.data() + position(node + 1);
+    if (in == end) return;
+
+    auto to = node + static_cast<NodeId>(zigzag_decode(decode_varint(in)));
+    visit(to, decode_cost(in));
+    while (in != end) {
+      to += decode_varint(in);
+      visit(to, decode_cost(in));
+    }
+  }
+
+  /// @brief Whether costs are quantized.
+  auto quantized() const -> bool { return quantized_; }
+
+  /// @brief The memory used by the adjacency (in bytes).
+  auto memory_bytes() const -> size_t {
+    return offsets_.size() * sizeof(uint32_t) +
+           block_starts_.size() * sizeof(uint64_t) + bytes_.size();
+  }
+
+ private:
+  static constexpr float kQuantizationSteps = 65534.0f;
+  /// @brief The quantized code of an `INF` cost.
+  static constexpr uint16_t kInfCode = 0xFFFF;
+  /// @brief The number of nodes whose offsets share a 64-bit start.
+  static constexpr size_t kBlockNodes = 1 << 12;
+
+  /// @brief Where a node's edges start in `bytes_`.
+  auto position(size_t node) const -> uint64_t {
+    return block_starts_[node / kBlockNodes] + offsets_[node];
+  }
+
+  /// @brief Records that `node`'s edges start at the end of `bytes_`.
+  /// @throws std::length_error If a block's edges exceed 4 GiB.
+  auto set_offset(size_t node) -> void {
+    if (node % kBlockNodes == 0) block_starts_.push_back(bytes_.size());
+    const auto offset = bytes_.size() - block_starts_.back();
+    if (offset > UINT32_MAX) {
+      throw std::length_error(
+          "CompressedGraph: a block's edges exceed 32-bit offsets");
+    }
+    offsets_[node] = static_cast<uint32_t>(offset);
+  }
+
+  auto encode_cost(float cost) -> void {
+    if (quantized_) {
+      const auto step = cost_step_ > 0.0f
+                            ? std::lround((cost - cost_min_) / cost_step_)
+                            : 0l;
+      const auto quantized =
+          cost == INF ? kInfCode : static_cast<uint16_t>(step);
+      bytes_.push_back(static_cast<uint8_t>(quantized));
+      bytes_.push_back(static_cast<uint8_t>(quantized >> 8));
+    } else {
+      uint8_t raw[sizeof(float)];
+      std::memcpy(raw, &cost, sizeof(float));
+      bytes_.insert(bytes_.end(), raw, raw + sizeof(float));
+    }
+  }
+
+  auto decode_cost(const uint8_t*& in) const -> float {
+    if (quantized_) {
+      const auto quantized = static_cast<uint16_t>(in[0] | in[1] << 8);
+      in += 2;
+      if (quantized == kInfCode) return INF;
+      return cost_min_ + quantized * cost_step_;
+    }
+    float cost;
+    std::memcpy(&cost, in, sizeof(float));
+    in += sizeof(float);
+    return cost;
+  }
+
+  /// @brief Where each node's edges start in `bytes_` (plus the end), from
+  /// the start of its block of `kBlockNodes` nodes in `block_starts_`. Only
+  /// a block's edges have to fit in 4 GiB, not the whole stream, for 4 bytes
+  /// per node.
+  vector<uint32_t> offsets_;
+  vector<uint64_t> block_starts_;
+  vector<uint8_t> bytes_;
+  size_t num_edges_ = 0;
+  bool quantized_ = false;
+  float cost_min_ = 0.0f;
+  float cost_step_ = 0.0f;
+};
+
+static_assert(ArcGraph<CompressedGraph>);
+
+}  // namespace graph
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "graph/graph.h"
+#include "utils/data_structures/epoch.h"
+#include "utils/data_structures/flat_hash_map.h"
+#include "utils/data_structures/persistent_vector.h"
+#include "utils/data_structures/small_vector.h"
+
+using std::vector;
+
+namespace graph {
+
+// ---------------------------------------------------------------------------
+// Versions
+// ---------------------------------------------------------------------------
+
+/// @brief An outgoing edge in a `ConcurrentGraph`.
+struct Arc {
+  NodeId to;
+  float cost;
+};
+
+/// @brief The outgoing edges of a node.
+using ArcList = data_structures::containers::SmallVector<Arc, INLINE_EDGES>;
+
+/// @brief A published, immutable version of a `ConcurrentGraph`'s adjacency.
+/// Consecutive versions share every chunk of nodes that didn't change.
+struct GraphVersion {
+  /// @brief The outgoing edges of every node, indexed by `NodeId`.
+  data_structures::containers::PersistentVector<ArcList> adjacency;
+  size_t num_edges = 0;
+  /// @brief Increases by one with every published version.
+  uint64_t number = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Concurrent graph
+// ---------------------------------------------------------------------------
+
+/// @brief A graph that can be updated while any number of threads read it,
+/// without readers ever taking a lock.
+///
+/// Writers don't touch the published adjacency: each writer thread appends
+/// its updates to its own delta buffer (so writers don't contend with each
+/// other either). `publish()` folds every buffered update into a new
+/// `GraphVersion`, path-copying only the chunks of the nodes that changed,
+/// and swaps it in with a single atomic store. Readers `read()` the current
+/// version under an epoch guard; replaced versions are retired to the epoch
+/// domain and freed once no reader can still hold them.
+///
+/// Updates made by one thread are applied in order; the order of updates
+/// made by different threads between two publishes is unspecified.
+class ConcurrentGraph {
+ public:
+  using EpochDomain = data_structures::reclamation::EpochDomain;
+
+  /// @brief A consistent view of one version, valid for the reader's
+  /// lifetime. Keep readers short-lived: they hold back reclamation.
+  class Reader {
+   public:
+    auto num_nodes() const -> size_t { return version_->adjacency.size(); }
+    auto num_edges() const -> size_t { return version_->num_edges; }
+
+    /// @brief The number of the version being read.
+    auto version() const -> uint64_t { return version_->number; }
+
+    /// @brief The outgoing edges of a node (`id < num_nodes()`).
+    auto arcs(NodeId id) const -> const ArcList& {
+      return version_->adjacency[id];
+    }
+
+   private:
+    friend class ConcurrentGraph;
+    Reader(EpochDomain::Guard guard, const GraphVersion* version)
+        : guard_(std::move(guard)), version_(version) {}
+
+    EpochDomain::Guard guard_;
+    const GraphVersion* version_;
+  };
+
+  /// @brief Creates a graph with `num_nodes` nodes and no edges.
+  explicit ConcurrentGraph(
+      size_t num_nodes = 0,
+      EpochDomain& domain = data_structures::reclamation::epochs())
+      : domain_(domain),
+        id_(next_id_.fetch_add(1, std::memory_order_relaxed)),
+        next_node_(static_cast<NodeId>(num_nodes)) {
+    auto version = new GraphVersion;
+    for (size_t i = 0; i < num_nodes; i++) version->adjacency.push_back({});
+    current_.store(version, std::memory_order_release);
+  }
+
+  ConcurrentGraph(const ConcurrentGraph&) = delete;
+  auto operator=(const ConcurrentGraph&) -> ConcurrentGraph& = delete;
+
+  /// @brief No reader may outlive the graph.
+  ~ConcurrentGraph() { delete current_.load(std::memory_order_acquire); }
+
+  // Readers
+
+  /// @brief Pins the current version for reading.
+  auto read() const -> Reader {
+    auto guard = domain_.pin();
+    return Reader(std::move(guard), current_.load(std::memory_order_acquire));
+  }
+
+  // Writers (any thread; visible to readers after the next `publish()`)
+
+  /// @brief Adds a node.
+  /// @return The id of the new node.
+  auto add_node() -> NodeId {
+    const auto id = next_node_.fetch_add(1, std::memory_order_relaxed);
+    append({Delta::Kind::AddNode, id, INVALID_NODE, 0.0f});
+    return id;
+  }
+
+  /// @brief Adds an edge, or changes its cost if there already is one
+  /// between the same nodes.
+  /// @throws std::out_of_range If either node hasn't been added.
+  auto set_edge(NodeId from, NodeId to, float cost) -> void {
+    const auto num_nodes = next_node_.load(std::memory_order_relaxed);
+    if (from >= num_nodes || to >= num_nodes) {
+      throw std::out_of_range("ConcurrentGraph::set_edge: no such node");
+    }
+    append({Delta::Kind::SetEdge, from, to, cost});
+  }
+
+  /// @brief Removes the edge between two nodes (if any).
+  auto remove_edge(NodeId from, NodeId to) -> void {
+    append({Delta::Kind::RemoveEdge, from, to, 0.0f});
+  }
+
+  /// @brief Applies every buffered update, publishes the result as a new
+  /// version and reclaims the versions no reader holds anymore.
+  /// @return The number of the published version.
+  auto publish() -> uint64_t {
+    std::lock_guard lock(publish_mutex_);
+    vector<Delta> deltas;
+    {
+      std::lock_guard buffers_lock(buffers_mutex_);
+      // A buffer only the graph holds belongs to a thread that has exited:
+      // nothing can be appended to it anymore, so it goes once drained
+      std::erase_if(buffers_, [&](const std::shared_ptr<DeltaBuffer>& buffer) {
+        const auto orphaned = buffer.use_count() == 1;
+        buffer->drain(deltas);
+        return orphaned;
+      });
+    }
+
+    const auto* current = current_.load(std::memory_order_relaxed);
+    auto next = new GraphVersion(*current);
+    next->number++;
+    for (const auto& delta : deltas) apply(*next, delta);
+
+    current_.store(next, std::memory_order_release);
+    domain_.retire(current);
+    domain_.collect();
+    return next->number;
+  }
+
+  /// @brief The number of writer threads' buffers the graph holds (those of
+  /// exited threads are dropped by the next `publish()`).
+  auto writer_buffer_count() -> size_t {
+    std::lock_guard lock(buffers_mutex_);
+    return buffers_.size();
+  }
+
+  /// @brief The number of graphs the calling thread holds an update buffer
+  /// for (destroyed graphs' buffers are dropped on its next first update to
+  /// another graph).
+  static auto thread_buffer_count() -> size_t {
+    return thread_buffers().size();
+  }
+
+ private:
+  /// @brief A buffered update.
+  struct Delta {
+    enum class Kind : uint8_t { AddNode, SetEdge, RemoveEdge };
+
+    Kind kind;
+    NodeId from;
+    NodeId to;
+    float cost;
+  };
+
+  /// @brief The updates buffered by one writer thread. Only contended when
+  /// `publish()` drains it.
+  class DeltaBuffer {
+   public:
+    auto append(const Delta& delta) -> void {
+      std::lock_guard lock(mutex_);
+      deltas_.push_back(delta);
+    }
+
+    auto drain(vector<Delta>& out) -> void {
+      std::lock_guard lock(mutex_);
+      out.insert(out.end(), deltas_.begin(), deltas_.end());
+      deltas_.clear();
+    }
+
+   private:
+    std::mutex mutex_;
+    vector<Delta> deltas_;
+  };
+
+  auto append(const Delta& delta) -> void { local_buffer().append(delta); }
+
+  /// @brief The calling thread's buffer for this graph, registered on the
+  /// thread's first update. Buffers are shared with the thread, so either
+  /// the graph or the thread can go away first.
+  auto local_buffer() -> DeltaBuffer& {
+    auto& buffers = thread_buffers();
+    if (auto it = buffers.find(id_); it != buffers.end()) return *it->second;
+
+    // Forget the buffers (and undrained updates) of graphs that have been
+    // destroyed
+    vector<uint64_t> destroyed;
+    for (const auto& [graph, buffer] : buffers) {
+      if (buffer.use_count() == 1) destroyed.push_back(graph);
+    }
+    for (auto graph : destroyed) buffers.erase(graph);
+
+    auto buffer = std::make_shared<DeltaBuffer>();
+    {
+      std::lock_guard lock(buffers_mutex_);
+      buffers_.push_back(buffer);
+    }
+    return *buffers.try_emplace(id_, std::move(buffer)).first->second;
+  }
+
+  /// @brief The calling thread's buffers, by graph id.
+  static auto thread_buffers() -> data_structures::containers::FlatHashMap<
+      uint64_t, std::shared_ptr<DeltaBuffer>>& {
+    thread_local data_structures::containers::FlatHashMap<
+        uint64_t, std::shared_ptr<DeltaBuffer>>
+        buffers;
+    return buffers;
+  }
+
+  template <typename Arcs>
+  static auto find(Arcs& arcs, NodeId to) {
+    return std::find_if(arcs.begin(), arcs.end(),
+                        [&](const Arc& arc) { return arc.to == to; });
+  }
+
+  static auto apply(GraphVersion& version, const Delta& delta) -> void {
+    auto& adjacency = version.adjacency;
+    switch (delta.kind) {
+      case Delta::Kind::AddNode:
+        // Nodes can be added by several threads at once, so their ids may
+        // arrive out of order.
+        while (adjacency.size() <= delta.from) adjacency.push_back({});
+        break;
+      case Delta::Kind::SetEdge: {
+        // Both nodes exist, but may have been added by a thread whose
+        // updates are applied after this one's
+        const auto needed = std::max(delta.from, delta.to);
+        while (adjacency.size() <= needed) adjacency.push_back({});
+        adjacency.update(delta.from, [&](ArcList& arcs) {
+          auto arc = find(arcs, delta.to);
+          if (arc != arcs.end()) {
+            arc->cost = delta.cost;
+          } else {
+            arcs.push_back({delta.to, delta.cost});
+            version.num_edges++;
+          }
+        });
+        break;
+      }
+      case Delta::Kind::RemoveEdge:
+        if (delta.from >= adjacency.size()) break;
+        if (find(adjacency[delta.from], delta.to) ==
+            adjacency[delta.from].end()) {
+          break;
+        }
+        adjacency.update(delta.from, [&](ArcList& arcs) {
+          arcs.erase(find(arcs, delta.to));
+          version.num_edges--;
+        });
+        break;
+    }
+  }
+
+  static inline std::atomic<uint64_t> next_id_{0};
+
+  EpochDomain& domain_;
+  /// @brief Identifies the graph in threads' buffer maps (addresses may be
+  /// reused).
+  const uint64_t id_;
+  std::atomic<const GraphVersion*> current_;
+  std::atomic<NodeId> next_node_;
+  /// @brief Serializes publishers.
+  std::mutex publish_mutex_;
+  /// @brief Guards `buffers_`.
+  std::mutex buffers_mutex_;
+  vector<std::shared_ptr<DeltaBuffer>> buffers_;
+};
+
+}  // namespace graph
@@ -0,0 +1,402 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "graph/graph.h"
+#include "utils/parallel.h"
+#include "utils/spans.h"
+
+using std::vector;
+
+namespace graph {
+
+// ---------------------------------------------------------------------------
+// Arc graphs
+// ---------------------------------------------------------------------------
+
+/// @brief A read-only graph whose outgoing edges can be enumerated by node id
+/// (e.g. `CsrGraph`, `CompressedGraph`). Algorithms written against this
+/// concept run on any of the compact representations.
+template <typename G>
+concept ArcGraph = requires(const G& graph, NodeId node) {
+  { graph.num_nodes() } -> std::convertible_to<size_t>;
+  { graph.num_edges() } -> std::convertible_to<size_t>;
+  graph.for_each_arc(node, [](NodeId, float) {});
+};
+
+/// @brief An edge given by the ids of its endpoints.
+struct WeightedEdge {
+  NodeId from;
+  NodeId to;
+  float cost;
+};
+
+/// @brief The edges of a (mutable) graph, indexed by `EdgeId`.
+inline auto edge_list(const DirectedAcyclicGraph& graph)
+    -> vector<WeightedEdge> {
+  vector<WeightedEdge> edges;
+  edges.reserve(graph.num_edges());
+  for (const auto& edge : graph.edges()) {
+    edges.push_back({edge->from()->id(), edge->to()->id(), edge->cost()});
+  }
+  return edges;
+}
+
+// ---------------------------------------------------------------------------
+// CSR
+// ---------------------------------------------------------------------------
+
+/// @brief How `CsrGraph::build()` cleans up its input.
+struct CsrBuildOptions {
+  /// @brief Whether to drop edges from a node to itself.
+  bool remove_self_loops = false;
+  /// @brief Whether to keep only the cheapest of the edges between the same
+  /// pair of nodes (implies `sort_arcs`).
+  bool deduplicate = false;
+  /// @brief Whether to sort each node's outgoing edges by target (then
+  /// cost) rather than keep them in input order.
+  bool sort_arcs = false;
+};
+
+/// @brief A graph in compressed sparse row form: the outgoing edges of every
+/// node are stored contiguously, in `targets`/`costs` between `offsets[n]`
+/// and `offsets[n + 1]`.
+///
+/// Immutable once built and free of rendering state, so it is cheap to
+/// traverse (no pointer chasing) and safe to share between threads.
+class CsrGraph {
+ public:
+  /// @brief The most edges a graph can hold: offsets (and arc positions) are
+  /// 32-bit, which keeps them half the size.
+  static constexpr size_t kMaxEdges = UINT32_MAX;
+
+  CsrGraph() : offsets_(1, 0) {}
+
+  /// @brief Builds a graph from a list of edges (in any order). The outgoing
+  /// edges of each node keep their relative order.
+  /// @throws std::length_error If there are more than `kMaxEdges` edges.
+  /// @throws std::out_of_range If an edge has an end `>= num_nodes`.
+  static auto from_edges(size_t num_nodes, const vector<WeightedEdge>& edges)
+      -> CsrGraph {
+    check_num_edges(edges.size());
+    CsrGraph graph;
+    graph.offsets_.assign(num_nodes + 1, 0);
+    for (const auto& edge : edges) {
+      check_edge(edge, num_nodes);
+      graph.offsets_[edge.from + 1]++;
+    }
+    for (size_t node = 0; node < num_nodes; node++) {
+      graph.offsets_[node + 1] += graph.offsets_[node];
+    }
+
+    graph.targets_.resize(edges.size());
+    graph.costs_.resize(edges.size());
+    vector<uint32_t> next(graph.offsets_.begin(), graph.offsets_.end() - 1);
+    for (const auto& edge : edges) {
+      const auto slot = next[edge.from]++;
+      graph.targets_[slot] = edge.to;
+      graph.costs_[slot] = edge.cost;
+    }
+    return graph;
+  }
+
+  /// @brief Builds a graph from a list of edges (in any order) in parallel,
+  /// for graphs too large to build on one thread (see `build_chunks()`).
+  ///
+  /// @param threads The maximum number of threads the edges are spread over.
+  static auto build(size_t num_nodes, std::span<const WeightedEdge> edges,
+                    CsrBuildOptions options = {},
+                    size_t threads = parallel::num_threads()) -> CsrGraph {
+    // A few lists per thread balance the load, more would only grow the
+    // per-list bucket counts
+    constexpr size_t kMinChunkSize = 1 << 16;
+    threads = std::max<size_t>(threads, 1);
+    const auto chunk_size = std::max(
+        kMinChunkSize, (edges.size() + 4 * threads - 1) / (4 * threads));
+    vector<std::span<const WeightedEdge>> chunks;
+    for (size_t first = 0; first < edges.size(); first += chunk_size) {
+      chunks.push_back(
+          edges.subspan(first, std::min(chunk_size, edges.size() - first)));
+    }
+    return build_chunks(num_nodes, chunks, options, threads);
+  }
+
+  /// @brief Builds a graph from edges generated in parallel: each of
+  /// `num_producers` calls of `produce(producer, emit)` (spread over the
+  /// threads) passes its edges to `emit(from, to, cost)`, into a buffer of
+  /// its own.
+  template <typename Produce>
+  static auto build_with(size_t num_nodes, size_t num_producers,
+                         Produce&& produce, CsrBuildOptions options = {},
+                         size_t threads = parallel::num_threads())
+      -> CsrGraph {
+    vector<vector<WeightedEdge>> buffers(num_producers);
+    parallel::parallel_for(
+        num_producers,
+        [&](size_t producer) {
+          auto& buffer = buffers[producer];
+          produce(producer, [&](NodeId from, NodeId to, float cost) {
+            buffer.push_back({from, to, cost});
+          });
+        },
+        1, threads);
+    return build_chunks(
+        num_nodes,
+        vector<std::span<const WeightedEdge>>(buffers.begin(), buffers.end()),
+        options, threads);
+  }
+
+  /// @brief Builds a graph from several lists of edges, in parallel, with a
+  /// two-pass counting sort that needs no atomics:
+  ///  1. the nodes are split into buckets of `kBucketNodes` consecutive ids,
+  ///     and every list counts its edges per bucket (in parallel over the
+  ///     lists); a prefix sum of the counts, bucket-major, gives every list
+  ///     its own range of each bucket,
+  ///  2. every list copies its edges into its ranges (in parallel over the
+  ///     lists, each writing sequentially to a handful of places),
+  ///  3. every bucket, now a contiguous run of edges, is counting-sorted by
+  ///     source into its own slice of the CSR arrays (in parallel over the
+  ///     buckets, each touching only its nodes' offsets, which fit in
+  ///     cache),
+  ///  4. if asked to, every node's edges are sorted (and deduplicated, then
+  ///     compacted with a second prefix sum).
+  /// No step appends to a shared vector or contends on a counter, so
+  /// building is bound by memory bandwidth rather than by a single thread.
+  /// Each node's edges keep the order of the lists, then of the edges in
+  /// each list.
+  /// @throws std::length_error If more than `kMaxEdges` edges are kept.
+  /// @throws std::out_of_range If an edge has an end `>= num_nodes`.
+  static auto build_chunks(size_t num_nodes,
+                           const vector<std::span<const WeightedEdge>>& chunks,
+                           CsrBuildOptions options = {},
+                           size_t threads = parallel::num_threads())
+      -> CsrGraph {
+    tracing::Span span("build_csr", "graph");
+    constexpr size_t kBucketNodes = 1 << 14;
+    constexpr size_t kNodeGrain = 1024;
+    const auto num_chunks = chunks.size();
+    const auto num_buckets = (num_nodes + kBucketNodes - 1) / kBucketNodes;
+    auto keep = [&](const WeightedEdge& edge) {
+      return !options.remove_self_loops || edge.from != edge.to;
+    };
+
+    // 1. Where each list's edges go in each bucket (`starts[bucket *
+    // num_chunks + chunk]`, plus the total at the end)
+    vector<size_t> starts(num_buckets * num_chunks + 1, 0);
+    parallel::parallel_for(
+        num_chunks,
+        [&](size_t chunk) {
+          for (const auto& edge : chunks[chunk]) {
+            check_edge(edge, num_nodes);
+            if (keep(edge)) {
+              starts[edge.from / kBucketNodes * num_chunks + chunk]++;
+            }
+          }
+        },
+        1, threads);
+    const auto num_edges =
+        parallel::exclusive_scan(starts.begin(), starts.end(), threads);
+    // Every offset below fits in 32 bits once the total does
+    check_num_edges(num_edges);
+
+    // 2. Partition the edges by bucket
+    vector<WeightedEdge> partitioned(num_edges);
+    parallel::parallel_for(
+        num_chunks,
+        [&](size_t chunk) {
+          thread_local vector<size_t> next;
+          next.resize(num_buckets);
+          for (size_t bucket = 0; bucket < num_buckets; bucket++) {
+            next[bucket] = starts[bucket * num_chunks + chunk];
+          }
+          for (const auto& edge : chunks[chunk]) {
+            if (!keep(edge)) continue;
+            partitioned[next[edge.from / kBucketNodes]++] = edge;
+          }
+        },
+        1, threads);
+
+    // 3. Sort each bucket by source, into the same range of the CSR arrays
+    CsrGraph graph;
+    auto& offsets = graph.offsets_;
+    offsets.resize(num_nodes + 1);
+    offsets[num_nodes] = static_cast<uint32_t>(num_edges);
+    graph.targets_.resize(num_edges);
+    graph.costs_.resize(num_edges);
+    parallel::parallel_for(
+        num_buckets,
+        [&](size_t bucket) {
+          const auto first_node = bucket * kBucketNodes;
+          const auto last_node = std::min(num_nodes, first_node + kBucketNodes);
+          const auto first = starts[bucket * num_chunks];
+          const auto last = starts[(bucket + 1) * num_chunks];
+          thread_local vector<uint32_t> next;
+          next.assign(last_node - first_node, 0);
+          for (auto i = first; i < last; i++) {
+            next[partitioned[i].from - first_node]++;
+          }
+          auto offset = static_cast<uint32_t>(first);
+          for (auto node = first_node; node < last_node; node++) {
+            offsets[node] = offset;
+            offset += std::exchange(next[node - first_node], offset);
+          }
+          for (auto i = first; i < last; i++) {
+            const auto& edge = partitioned[i];
+            const auto slot = next[edge.from - first_node]++;
+            graph.targets_[slot] = edge.to;
+            graph.costs_[slot] = edge.cost;
+          }
+        },
+        1, threads);
+    partitioned = {};
+
+    // 4. Sort, then deduplicate each node's edges in place, counting the
+    // survivors
+    if (!options.sort_arcs && !options.deduplicate) {
+      span.arg("nodes", num_nodes).arg("edges", num_edges);
+      return graph;
+    }
+    vector<uint32_t> kept(options.deduplicate ? num_nodes + 1 : 0);
+    parallel::parallel_for(
+        num_nodes,
+        [&](size_t node) {
+          thread_local vector<std::pair<NodeId, float>> arcs;
+          const auto first = offsets[node];
+          const auto last = offsets[node + 1];
+          arcs.clear();
+          for (auto i = first; i < last; i++) {
+            arcs.emplace_back(graph.targets_[i], graph.costs_[i]);
+          }
+          std::sort(arcs.begin(), arcs.end());
+          if (options.deduplicate) {
+            // The cheapest edge to each target comes first
+            arcs.erase(std::unique(arcs.begin(), arcs.end(),
+                                   [](const auto& a, const auto& b) {
+                                     return a.first == b.first;
+                                   }),
+                       arcs.end());
+            kept[node] = static_cast<uint32_t>(arcs.size());
+          }
+          for (size_t i = 0; i < arcs.size(); i++) {
+            graph.targets_[first + i] = arcs[i].first;
+            graph.costs_[first + i] = arcs[i].second;
+          }
+        },
+        kNodeGrain, threads);
+
+    if (options.deduplicate) {
+      kept[num_nodes] = 0;
+      const auto num_kept =
+          parallel::exclusive_scan(kept.begin(), kept.end(), threads);
+      vector<NodeId> targets(num_kept);
+      vector<float> costs(num_kept);
+      parallel::parallel_for(
+          num_nodes,
+          [&](size_t node) {
+            const auto count = kept[node + 1] - kept[node];
+            std::copy_n(graph.targets_.begin() + offsets[node], count,
+                        targets.begin() + kept[node]);
+            std::copy_n(graph.costs_.begin() + offsets[node], count,
+                        costs.begin() + kept[node]);
+          },
+          kNodeGrain, threads);
+      offsets = std::move(kept);
+      graph.targets_ = std::move(targets);
+      graph.costs_ = std::move(costs);
+    }
+    span.arg("nodes", num_nodes).arg("edges", graph.targets_.size());
+    return graph;
+  }
+
+  /// @brief Captures the current edges of a (mutable) graph.
+  static auto from(const DirectedAcyclicGraph& graph) -> CsrGraph {
+    return from_edges(graph.num_nodes(), edge_list(graph));
+  }
+
+  auto num_nodes() const -> size_t { return offsets_.size() - 1; }
+  auto num_edges() const -> size_t { return targets_.size(); }
+
+  /// @brief The number of outgoing edges of a node.
+  auto degree(NodeId node) const -> uint32_t {
+    return offsets_[node + 1] - offsets_[node];
+  }
+
+  /// @brief Calls `visit(to, cost)` for every outgoing edge of a node.
+  template <typename Visit>
+  auto for_each_arc(NodeId node, Visit&& visit) const -> void {
+    for (auto i = offsets_[node]; i < offsets_[node + 1]; i++) {
+      visit(targets_[i], costs_[i]);
+    }
+  }
+
+  /// @brief The graph with every edge reversed.
+  auto transpose() const -> CsrGraph {
+    vector<WeightedEdge> edges;
+    edges.reserve(num_edges());
+    for (NodeId node = 0; node < num_nodes(); node++) {
+      for_each_arc(node, [&](NodeId to, float cost) {
+        edges.push_back({to, node, cost});
+      });
+    }
+    return from_edges(num_nodes(), edges);
+  }
+
+  /// @brief Sorts every node's outgoing edges by target (the order
+  /// `CompressedGraph` needs for gap encoding).
+  auto sort_arcs() -> void {
+    vector<std::pair<NodeId, float>> arcs;
+    for (size_t node = 0; node < num_nodes(); node++) {
+      const auto first = offsets_[node];
+      const auto last = offsets_[node + 1];
+      arcs.clear();
+      for (auto i = first; i < last; i++) {
+        arcs.emplace_back(targets_[i], costs_[i]);
+      }
+      std::sort(arcs.begin(), arcs.end());
+      for (auto i = first; i < last; i++) {
+        targets_[i] = arcs[i - first].first;
+        costs_[i] = arcs[i - first].second;
+      }
+    }
+  }
+
+  auto offsets() const -> const vector<uint32_t>& { return offsets_; }
+  auto targets() const -> const vector<NodeId>& { return targets_; }
+  auto costs() const -> const vector<float>& { return costs_; }
+
+  /// @brief The memory used by the adjacency arrays (in bytes).
+  auto memory_bytes() const -> size_t {
+    return offsets_.size() * sizeof(uint32_t) +
+           targets_.size() * sizeof(NodeId) + costs_.size() * sizeof(float);
+  }
+
+ private:
+  /// @brief Throws rather than let the offsets silently wrap around.
+  static auto check_num_edges(size_t num_edges) -> void {
+    if (num_edges > kMaxEdges) {
+      throw std::length_error("CsrGraph: too many edges for 32-bit offsets");
+    }
+  }
+
+  /// @brief Throws rather than let an edge index past the node arrays.
+  static auto check_edge(const WeightedEdge& edge, size_t num_nodes) -> void {
+    if (edge.from >= num_nodes || edge.to >= num_nodes) {
+      throw std::out_of_range("CsrGraph: edge to or from a missing node");
+    }
+  }
+
+  vector<uint32_t> offsets_;
+  vector<NodeId> targets_;
+  vector<float> costs_;
+};
+
+static_assert(ArcGraph<CsrGraph>);
+
+}  // namespace graph
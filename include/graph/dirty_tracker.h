@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+namespace graph {
+
+/// @brief Collects the indices of elements (nodes or edges) whose rendered
+/// state changed since the last frame, so that only their vertices need to be
+/// rebuilt and re-uploaded.
+///
+/// Marking is O(1) and idempotent; `flush()` coalesces the marked indices
+/// into sorted, contiguous ranges. Not thread-safe: elements are expected to
+/// be edited on the render thread.
+class DirtyTracker {
+ public:
+  /// @brief Marks a single element as changed.
+  /// @param index The index of the element.
+  inline auto mark(uint32_t index) -> void {
+    if (index >= flags_.size()) flags_.resize(index + 1, 0);
+    if (flags_[index]) return;
+    flags_[index] = 1;
+    dirty_.push_back(index);
+  }
+
+  /// @brief Marks every element as changed (e.g. after the vertex buffer had
+  /// to be reallocated).
+  auto mark_all() -> void { all_ = true; }
+
+  /// @brief Records that elements were removed. Removing the last element
+  /// changes no other one, but it still has to disappear from the screen.
+  auto mark_removed() -> void { removed_ = true; }
+
+  /// @brief Whether anything changed since the last `flush()`.
+  auto dirty() const -> bool {
+    return all_ || removed_ || !dirty_.empty();
+  }
+
+  /// @brief Whether every element has to be rebuilt.
+  auto all() const -> bool { return all_; }
+
+  /// @brief Hands every changed range to `update` and resets the tracker.
+  /// @param count The current number of elements (changes to elements past
+  ///              the end, e.g. removed ones, are ignored).
+  /// @param update Called as `update(first, count)` once per contiguous range
+  ///               of changed elements, in increasing order.
+  template <typename Update>
+  auto flush(uint32_t count, Update&& update) -> void {
+    if (all_) {
+      if (count > 0) update(0u, count);
+    } else {
+      std::sort(dirty_.begin(), dirty_.end());
+      size_t i = 0;
+      while (i < dirty_.size() && dirty_[i] < count) {
+        auto first = dirty_[i];
+        auto last = first;
+        while (++i < dirty_.size() && dirty_[i] == last + 1 &&
+               dirty_[i] < count) {
+          last++;
+        }
+        update(first, last - first + 1);
+      }
+    }
+
+    for (auto index : dirty_) flags_[index] = 0;
+    dirty_.clear();
+    all_ = false;
+    removed_ = false;
+  }
+
+ private:
+  /// @brief Whether each element is already in `dirty_`.
+  vector<uint8_t> flags_;
+  /// @brief The indices of the changed elements (unsorted, unique).
+  vector<uint32_t> dirty_;
+  /// @brief Whether every element changed.
+  bool all_ = false;
+  /// @brief Whether elements were removed.
+  bool removed_ = false;
+};
+
+/// @brief The changes to a graph's retained scene since the last frame.
+struct SceneChanges {
+  /// @brief Nodes whose sprite changed (indexed by `NodeId`).
+  DirtyTracker nodes;
+  /// @brief Edges whose line changed (indexed by `EdgeId`).
+  DirtyTracker edges;
+  /// @brief Edges whose geometric cost is stale (indexed by `EdgeId`). Not
+  /// part of `dirty()`: costs are refreshed before searching, not drawing.
+  DirtyTracker costs;
+
+  /// @brief Whether anything has to be re-uploaded.
+  auto dirty() const -> bool { return nodes.dirty() || edges.dirty(); }
+};
+
+}  // namespace graph
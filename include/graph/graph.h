@@ -1,10 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <vector>
 
 // #include "graph/edge.h"
 // #include "graph/node.h"
+#include "graph/dirty_tracker.h"
+#include "utils/data_structures/flat_hash_map.h"
+#include "utils/data_structures/small_vector.h"
+#include "utils/log_sampling.h"
+#include "utils/metrics.h"
 #include "utils/tracing.h"
 
 using std::make_unique;
@@ -14,6 +24,7 @@ using std::vector;
 
 using sf::Color;
 using sf::IntRect;
+using sf::RenderTarget;
 using sf::RenderWindow;
 using sf::Sprite;
 using sf::Text;
@@ -47,9 +58,48 @@ class Edge;
 /// edges that can be added to the graph before the vector is resized).
 static constexpr int32_t INITIAL_GRAPH_CAPACITY = 100;
 
+/// @brief The number of incoming (and of outgoing) edges a node stores inline
+/// before its edge list has to allocate.
+static constexpr size_t INLINE_EDGES = 4;
+
+/// @brief A node's incoming or outgoing edges.
+using EdgeList = data_structures::containers::SmallVector<Edge*, INLINE_EDGES>;
+
+/// @brief Identifies a node within its graph. Ids are dense (`0..n-1`) and are
+/// assigned in insertion order, so they can index side arrays directly.
+using NodeId = uint32_t;
+
+/// @brief Marks a node that has not been added to a graph (yet).
+static constexpr NodeId INVALID_NODE = UINT32_MAX;
+
+/// @brief Identifies an edge within its graph (dense, like `NodeId`).
+using EdgeId = uint32_t;
+
+/// @brief Marks an edge that has not been added to a graph (yet).
+static constexpr EdgeId INVALID_EDGE = UINT32_MAX;
+
+/// @brief The endpoints of an edge, used to look edges up by the nodes they
+/// connect. Nodes are identified by address, which (unlike their ids) stays
+/// the same when other nodes are removed.
+struct EdgeKey {
+  const Node* from;
+  const Node* to;
+
+  auto operator==(const EdgeKey&) const -> bool = default;
+};
+
+/// @brief Hashes an `EdgeKey` (the flat hash map mixes the result further).
+struct EdgeKeyHash {
+  auto operator()(const EdgeKey& key) const -> size_t {
+    const auto from = reinterpret_cast<uintptr_t>(key.from);
+    const auto to = reinterpret_cast<uintptr_t>(key.to);
+    return static_cast<size_t>(from * 0x9E3779B97F4A7C15ull ^ to);
+  }
+};
+
 /// @brief Generates a random position within the window.
 /// @return A random position within the window.
-auto random_position() -> Vector2f {
+inline auto random_position() -> Vector2f {
   return Vector2f(static_cast<float>(rand() % config::WINDOW_HEIGHT),
                   static_cast<float>(rand() % config::PROD_WINDOW_WIDTH));
 }
@@ -58,8 +108,10 @@ auto random_position() -> Vector2f {
 /// @param a The first point.
 /// @param b The second point.
 /// @return The distance between the two points.
-auto distance_between(Vector2f a, Vector2f b) -> float {
-  return sqrt(pow(a.x - b.x, 2) + pow(a.y - b.y, 2));
+inline auto distance_between(Vector2f a, Vector2f b) -> float {
+  const auto dx = a.x - b.x;
+  const auto dy = a.y - b.y;
+  return std::sqrt(dx * dx + dy * dy);
 }
 
 /// A node in a graph that can be visited by a graph search algorithm
@@ -67,53 +119,41 @@ auto distance_between(Vector2f a, Vector2f b) -> float {
 ///
 /// Nodes are connected to other nodes via edges (see Edge class).
 ///
-/// Nodes contain a position, a cost, a heuristic, parent node, vector of
-/// adjacent nodes, and vector of adjacent edges.
+/// Nodes contain a position, parent node, vector of adjacent nodes, and
+/// vector of adjacent edges. Per-query search state (g(n), h(n), ...) lives
+/// in a `SearchContext`, not on the node.
 ///
 /// They can be rendered to the screen using the render() method.
 class Node {
  public:
   /// @brief Constructs a node with a given position.
-  Node(RenderWindow& window, Texture& texture, Vector2f position,
-       float cost = 0.0f, float heuristic = 0.0f)
-      : window_(&window),
-        position_(position),
-        cost_(cost),
-        heuristic_(heuristic) {
+  /// @param target The target the node is drawn to (a window, or a texture
+  ///               when rendering offscreen).
+  Node(RenderTarget& target, const Texture& texture, Vector2f position)
+      : Node(target, position) {
     sprite_.setTexture(texture);
-    sprite_.setPosition(position_);
     sprite_.scale(4.f, 4.f);
     // m_sprite.scale(0.05f, 0.05f);
+  }
 
-    incoming_edges_.reserve(INITIAL_GRAPH_CAPACITY / 10);
-    outgoing_edges_.reserve(INITIAL_GRAPH_CAPACITY / 10);
+  /// @brief Constructs an untextured node with a given position. Until a
+  /// texture is set, the node is drawn as a plain `config::NODE_SIZE` square.
+  Node(RenderTarget& target, Vector2f position)
+      : target_(&target), position_(position) {
+    sprite_.setPosition(position_);
 
     // build_node();
   }
 
   /// @brief Node destructor.
   virtual ~Node() {
-    tracing::trace(
-        format("Node destroyed with cost {}, "
-               "heuristic {}, and "
-               "position ({}, {})",
-               cost_, heuristic_, position_.x, position_.y));
-  }
-
-  /// @brief The cost of the path from the start node
-  /// to this node. This is the sum of the cost of the
-  /// edges from the start node to this node.
-  ///
-  /// @attention This is the g(n) function in the A* algorithm.
-  ///
-  /// @return The cost of the path from the start node
-  inline auto cost() const { return cost_; }
-
-  /// @brief Returns the heuristic cost of the path from
-  ///        this node to the goal node.
-  /// @return The heuristic cost of the path from this
-  ///         node to the goal node.
-  inline auto heuristic() const { return heuristic_; }
+    // Tearing down a large graph destroys every node at once
+    static tracing::FirstNThenEvery destroyed(config::LIFECYCLE_LOG_FIRST,
+                                              config::LIFECYCLE_LOG_EVERY);
+    tracing::trace(destroyed,
+                   "Node destroyed at position ({}, {})", position_.x,
+                   position_.y);
+  }
 
   /// Returns the position of the node.
   inline auto position() const { return position_; }
@@ -126,30 +166,23 @@ class Node {
   /// @return The y-coordinate of the node.
   inline auto y() const { return position_.y; }
 
-  /// @brief The total cost of the path from the start
-  ///        node to the goal node through this node.
-  ///        This is the sum of the cost of the edges
-  ///        from the start node to this node and the
-  ///        cost of the edges from this node to the
-  ///        goal node.
-  /// @return
-  inline auto total_cost() const { return cost_ + heuristic_; }
-
-  /// @brief Sets the cost of the path from the start node
-  ///        to this node.
-  /// @param cost The cost of the path from the start node
-  ///             to this node.
-  inline auto set_cost(float cost) { cost_ = cost; }
-
-  /// @brief Sets the heuristic cost of the path from
-  ///         this node to the goal
-  /// @param heuristic The heuristic cost of the path
-  ///                  from this node to the goal
-  inline auto set_heuristic(float heuristic) { heuristic_ = heuristic; }
-
-  /// @brief Sets the position of the node.
+  /// @brief Sets the position of the node (which also moves every edge
+  /// connected to it).
   /// @param position The position of the node.
-  inline auto set_position(Vector2f position) { position_ = position; }
+  inline auto set_position(Vector2f position) -> void;
+
+  /// @brief Returns the id of the node within its graph (`INVALID_NODE` if the
+  /// node has not been added to a graph).
+  inline auto id() const { return id_; }
+
+  /// @brief Sets the id of the node (assigned by the owning graph).
+  /// @param id The id of the node.
+  inline auto set_id(NodeId id) { id_ = id; }
+
+  /// @brief Reports changes to the node's appearance to `changes` (set by the
+  /// owning graph, so that only changed nodes are re-uploaded).
+  /// @param changes The changes of the graph's scene (may be `nullptr`).
+  inline auto set_changes(SceneChanges* changes) { changes_ = changes; }
 
   inline auto sprite() { return &sprite_; }
 
@@ -161,7 +194,7 @@ class Node {
   /// @brief Returns a reference to incoming edges to this node.
   inline auto incoming_edges() { return &incoming_edges_; }
 
-  /// @brief The edges that are outgoing from this node (vector<Edge*>)
+  /// @brief The edges that are outgoing from this node (an `EdgeList`)
   inline auto outgoing_edges() { return &outgoing_edges_; }
 
   /// @brief Adds an incoming edge to this node.
@@ -195,42 +228,114 @@ class Node {
 
   /// @brief Renders the node to the screen.
   inline auto render() {
-    window_->draw(sprite_);
+    target_->draw(sprite_);
     // m_window->draw(m_text);
   }
 
   /// @brief Sets the color of the sprite.
   /// @param color The color to set.
-  auto set_color(Color color) { sprite_.setColor(color); }
+  auto set_color(Color color) {
+    if (sprite_.getColor() == color) return;
+    sprite_.setColor(color);
+    mark_changed();
+  }
 
   /// @brief Sets the texture of the sprite.
   /// @param texture The texture to set.
-  auto set_texture(Texture* texture) { sprite_.setTexture(*texture); }
+  auto set_texture(const Texture* texture) {
+    sprite_.setTexture(*texture);
+    mark_changed();
+  }
+
+  /// @brief Returns the texture of the sprite (`nullptr` if untextured).
+  auto texture() const { return sprite_.getTexture(); }
 
   /// @brief Sets the texture rect of the sprite.
   /// @param rect The texture rect to set.
-  auto set_texture_rect(IntRect rect) { sprite_.setTextureRect(rect); }
+  auto set_texture_rect(IntRect rect) {
+    sprite_.setTextureRect(rect);
+    mark_changed();
+  }
+
+  /// @brief Scales the sprite so it is drawn `size` pixels wide.
+  /// @param size The on-screen width of the node (in pixels).
+  auto set_size(float size) {
+    const auto width = sprite_.getTextureRect().width;
+    if (width > 0) sprite_.setScale(size / width, size / width);
+    mark_changed();
+  }
+
+  /// @brief The on-screen size of the node (untextured nodes are drawn as
+  /// `config::NODE_SIZE` squares).
+  auto size() const -> Vector2f {
+    if (sprite_.getTexture() == nullptr) {
+      return Vector2f(config::NODE_SIZE, config::NODE_SIZE);
+    }
+    const auto rect = sprite_.getTextureRect();
+    const auto scale = sprite_.getScale();
+    return Vector2f(rect.width * scale.x, rect.height * scale.y);
+  }
+
+  /// @brief The center of the node on screen (where its edges attach).
+  auto center() const { return position_ + size() / 2.0f; }
+
+  /// @brief The number of vertices written by `write_vertices()`.
+  static constexpr size_t NUM_VERTICES = 6;
+
+  /// @brief Writes the node's sprite as two triangles, so that all nodes
+  /// sharing a texture can be drawn with a single call.
+  /// @param out Where to write the `NUM_VERTICES` vertices.
+  auto write_vertices(sf::Vertex* out) const -> void {
+    const auto rect = sprite_.getTextureRect();
+    const auto size = this->size();
+    const auto width = size.x;
+    const auto height = size.y;
+    const auto color = sprite_.getColor();
+
+    const auto left = static_cast<float>(rect.left);
+    const auto top = static_cast<float>(rect.top);
+    const auto right = left + rect.width;
+    const auto bottom = top + rect.height;
+
+    const sf::Vertex top_left(position_, color, Vector2f(left, top));
+    const sf::Vertex top_right(position_ + Vector2f(width, 0.0f), color,
+                               Vector2f(right, top));
+    const sf::Vertex bottom_right(position_ + Vector2f(width, height), color,
+                                  Vector2f(right, bottom));
+    const sf::Vertex bottom_left(position_ + Vector2f(0.0f, height), color,
+                                 Vector2f(left, bottom));
+
+    out[0] = top_left;
+    out[1] = top_right;
+    out[2] = bottom_right;
+    out[3] = top_left;
+    out[4] = bottom_right;
+    out[5] = bottom_left;
+  }
 
  private:
   /// @brief The ID of the node. This is used to
   /// uniquely identify the node in the graph and
   /// allows for fast lookup of the node in the
   /// graph as well as fast comparison of nodes.
-  // u128 m_id;
   // TODO: in the future adapt to using a node registry along
   // with a node arena for fast allocation and deallocation of nodes
+  NodeId id_ = INVALID_NODE;
+
+  /// @brief Where changes to the node's appearance are reported.
+  SceneChanges* changes_ = nullptr;
 
-  /// @brief The window to draw to.
-  RenderWindow* window_;
+  /// @brief The target to draw to.
+  RenderTarget* target_;
 
   /// @brief The position of this node.
   Vector2f position_;
 
   /// @brief The incoming edges to this node.
-  vector<Edge*> incoming_edges_;
+  EdgeList incoming_edges_;
 
   /// @brief The outgoing edges from this node.
-  vector<Edge*> outgoing_edges_;
+  EdgeList outgoing_edges_;
 
   /// @brief The sprite for the boid (used for drawing)
   Sprite sprite_;
@@ -238,21 +343,15 @@ class Node {
   /// @brief The text for the boid.
   Text text_;
 
-  /// @brief The cost of the path from the start node to
-  /// this node.
-  float cost_;
-
-  /// @brief The heuristic cost of the path from this
-  /// node to the goal node.
-  float heuristic_;
+  /// @brief Marks the node's vertices as stale.
+  auto mark_changed() -> void {
+    if (changes_ != nullptr && id_ != INVALID_NODE) changes_->nodes.mark(id_);
+  }
 
-  /// @brief Trace the initialization of the node (i.e. the node's cost,
-  ///        heuristic, position, etc.)
+  /// @brief Trace the initialization of the node (i.e. its position)
   auto trace_init() -> void {
     // inline auto trace_init() -> void {
-    tracing::debug(format("Node created with cost {}, and heuristic {}", cost(),
-                          heuristic()));
-    tracing::debug(format("Node position: ({}, {})", x(), y()));
+    tracing::debug("Node position: ({}, {})", x(), y());
   }
 
   /// @brief Build the node.
@@ -279,8 +378,21 @@ class Node {
 // // Edge
 // // --------------------------------------------------------------------------
 
-/// @brief Represents an infinite cost for an edge in a graph.
-static constexpr int32_t INF = -1;
+/// @brief The cost of an impassable edge, and of a path to a node that
+/// cannot be (or has not been) reached.
+static constexpr float INF = std::numeric_limits<float>::infinity();
+
+/// @brief The color edges are drawn with by default.
+inline const Color EDGE_COLOR = Color(255, 255, 255, 48);
+
+/// @brief Where an edge's cost comes from.
+enum class EdgeWeight : uint8_t {
+  /// @brief The distance between the edge's nodes, cached by the edge and
+  /// recomputed after either node moves.
+  Geometric,
+  /// @brief A cost set with `Edge::set_cost()`.
+  Explicit,
+};
 
 /// @brief An edge in a graph, can be either directed or undirected.  An
 /// edge
@@ -290,8 +402,17 @@ static constexpr int32_t INF = -1;
 /// // TODO: migrate to generic node type via template
 class Edge {
  public:
-  Edge(Node* start, Node* end, float cost = 0.0f)
-      : m_start(start), m_end(end), m_cost(cost) {}
+  /// @brief Creates an edge whose cost is its (geometric) length.
+  Edge(Node* start, Node* end) : m_start(start), m_end(end) {
+    refresh_cost();
+  }
+
+  /// @brief Creates an edge with an explicit cost.
+  Edge(Node* start, Node* end, float cost)
+      : m_start(start),
+        m_end(end),
+        m_cost(cost),
+        m_weight(EdgeWeight::Explicit) {}
 
   // Returns a pointer to the start node of this edge.
   auto from() const { return m_start; }
@@ -302,16 +423,93 @@ class Edge {
 
   auto set_end(Node* end) -> void { m_end = end; }
 
-  auto cost() const -> float { return m_cost; }
+  /// @brief The cost of the edge. Geometric costs are cached, so this only
+  /// computes a distance if a node moved since the last `refresh_cost()`.
+  auto cost() const -> float { return m_cost_stale ? len() : m_cost; }
+
+  /// @brief Sets an explicit cost (which no longer follows the length).
+  auto set_cost(float cost) -> void {
+    m_cost = cost;
+    m_weight = EdgeWeight::Explicit;
+    m_cost_stale = false;
+  }
+
+  /// @brief Makes the cost follow the length of the edge.
+  auto set_geometric_cost() -> void {
+    m_weight = EdgeWeight::Geometric;
+    refresh_cost();
+  }
+
+  /// @brief Where the cost of the edge comes from.
+  auto weight() const { return m_weight; }
 
-  auto set_cost(float cost) -> void { m_cost = cost; }
+  /// @brief Whether a node moved since the geometric cost was cached.
+  auto cost_stale() const { return m_cost_stale; }
 
+  /// @brief Recomputes the cached geometric cost.
+  auto refresh_cost() -> void {
+    if (m_weight != EdgeWeight::Geometric) return;
+    m_cost = len();
+    m_cost_stale = false;
+  }
+
+  /// @brief Drops the cached geometric cost (one of the nodes moved). The
+  /// edge is reported to the scene, whose owner recomputes stale costs in
+  /// bulk (see `DirectedAcyclicGraph::refresh_costs()`).
+  auto invalidate_cost() -> void {
+    if (m_weight != EdgeWeight::Geometric || m_cost_stale) return;
+    m_cost_stale = true;
+    if (m_changes != nullptr && m_id != INVALID_EDGE) {
+      m_changes->costs.mark(m_id);
+    }
+  }
+
+  /// @brief The distance between the edge's nodes (computed on every call).
   auto len() const -> float { return m_start->distance_from(m_end); }
 
+  /// @brief Returns the id of the edge within its graph (`INVALID_EDGE` if
+  /// the edge has not been added to a graph).
+  auto id() const { return m_id; }
+
+  /// @brief Sets the id of the edge (assigned by the owning graph).
+  auto set_id(EdgeId id) -> void { m_id = id; }
+
+  /// @brief Reports changes to the edge's appearance to `changes`.
+  auto set_changes(SceneChanges* changes) -> void { m_changes = changes; }
+
+  /// @brief Returns the color the edge is drawn with.
+  auto color() const { return m_color; }
+
+  /// @brief Sets the color the edge is drawn with.
+  auto set_color(Color color) -> void {
+    if (m_color == color) return;
+    m_color = color;
+    mark_changed();
+  }
+
+  /// @brief Marks the edge's vertices as stale (e.g. because one of its
+  /// nodes moved).
+  auto mark_changed() -> void {
+    if (m_changes != nullptr && m_id != INVALID_EDGE) {
+      m_changes->edges.mark(m_id);
+    }
+  }
+
+  /// @brief The number of vertices written by `write_vertices()`.
+  static constexpr size_t NUM_VERTICES = 2;
+
+  /// @brief Writes the edge as a line between the centers of its nodes.
+  /// @param out Where to write the `NUM_VERTICES` vertices.
+  auto write_vertices(sf::Vertex* out) const -> void {
+    out[0] = sf::Vertex(m_start->center(), m_color);
+    out[1] = sf::Vertex(m_end->center(), m_color);
+  }
+
   // auto angle() const -> float { return m_start->angle(*m_end); }
 
+  /// @brief Orders edges by `cost()`, so stale cached costs don't count.
   auto operator<(const Edge& other) const -> bool {
-    return m_cost < other.m_cost;
+    return cost() < other.cost();
   }
 
   auto operator==(const Edge& other) const -> bool {
@@ -325,13 +523,23 @@ class Edge {
   /// @brief The end node of this edge.
   Node* m_end;
 
-  /// @brief The cost of this edge.
-  float m_cost = INFINITY;
+  /// @brief The cost of this edge (for geometric edges, the cached length).
+  float m_cost = INF;
+
+  /// @brief The id of this edge within its graph.
+  EdgeId m_id = INVALID_EDGE;
+
+  /// @brief Where changes to the edge's appearance are reported.
+  SceneChanges* m_changes = nullptr;
 
-  /// @brief Whether the distance between the start and end nodes of this
-  /// edge
-  ///        should be used as the cost of the edge.
-  bool m_distance_is_cost = true;
+  /// @brief The color this edge is drawn with.
+  Color m_color = EDGE_COLOR;
+
+  /// @brief Where `m_cost` comes from.
+  EdgeWeight m_weight = EdgeWeight::Geometric;
+
+  /// @brief Whether `m_cost` is an outdated geometric cost.
+  bool m_cost_stale = false;
 
   /// @brief Prints the edge to the given output stream.
   /// @param os The output stream to print to.
@@ -344,6 +552,152 @@ class Edge {
   // }
 };
 
+inline auto Node::set_position(Vector2f position) -> void {
+  if (position_ == position) return;
+  position_ = position;
+  sprite_.setPosition(position_);
+  mark_changed();
+  for (auto edge : incoming_edges_) {
+    edge->mark_changed();
+    edge->invalidate_cost();
+  }
+  for (auto edge : outgoing_edges_) {
+    edge->mark_changed();
+    edge->invalidate_cost();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Render scene
+// ---------------------------------------------------------------------------
+
+/// @brief The retained geometry of a graph: the vertices of every node and
+/// edge, kept in GPU vertex buffers between frames.
+///
+/// Nodes and edges report changes through `changes()`; `sync()` rebuilds
+/// only their vertices and uploads only the changed ranges, so a frame in
+/// which a handful of nodes changed color costs a handful of small uploads
+/// rather than a full rebuild. Falls back to drawing the CPU-side copies when
+/// vertex buffers are not supported.
+class RenderScene {
+ public:
+  RenderScene()
+      : m_node_buffer(sf::Triangles, sf::VertexBuffer::Dynamic),
+        m_edge_buffer(sf::Lines, sf::VertexBuffer::Dynamic),
+        m_buffered(sf::VertexBuffer::isAvailable()) {}
+
+  RenderScene(const RenderScene&) = delete;
+  auto operator=(const RenderScene&) -> RenderScene& = delete;
+
+  /// @brief Takes the scene's vertex buffers off `render_buffer_bytes`.
+  ~RenderScene() { m_buffer_bytes.add(-static_cast<double>(buffer_bytes())); }
+
+  /// @brief The bytes allocated for the scene's vertex buffers.
+  auto buffer_bytes() const -> size_t {
+    if (!m_buffered) return 0;
+    return (m_node_buffer.getVertexCount() + m_edge_buffer.getVertexCount()) *
+           sizeof(sf::Vertex);
+  }
+
+  /// @brief Where nodes and edges report changes to their appearance.
+  auto changes() -> SceneChanges* { return &m_changes; }
+
+  /// @brief Whether anything changed since the last `sync()`.
+  auto dirty() const { return m_changes.dirty(); }
+
+  /// @brief Rebuilds and uploads the vertices of changed nodes and edges.
+  /// @param nodes The nodes of the graph (indexed by `NodeId`).
+  /// @param edges The edges of the graph (indexed by `EdgeId`).
+  auto sync(const vector<unique_ptr<Node>>& nodes,
+            const vector<unique_ptr<Edge>>& edges) -> void {
+    sync_layer(nodes, m_changes.nodes, m_node_vertices, m_node_buffer);
+    sync_layer(edges, m_changes.edges, m_edge_vertices, m_edge_buffer);
+  }
+
+  /// @brief Draws the edges, then the nodes on top (two draw calls).
+  /// @param target The target to draw to.
+  /// @param texture The texture shared by every node (may be `nullptr`).
+  auto draw(RenderTarget& target, const Texture* texture) const -> void {
+    draw_layer(target, m_edge_vertices, m_edge_buffer, sf::Lines, nullptr);
+    draw_layer(target, m_node_vertices, m_node_buffer, sf::Triangles,
+               texture);
+  }
+
+ private:
+  /// @brief Brings one layer (nodes or edges) up to date.
+  template <typename Element>
+  auto sync_layer(const vector<unique_ptr<Element>>& elements,
+                  DirtyTracker& tracker, vector<sf::Vertex>& vertices,
+                  sf::VertexBuffer& buffer) -> void {
+    constexpr auto stride = Element::NUM_VERTICES;
+    const auto count = static_cast<uint32_t>(elements.size());
+    const auto required = size_t{count} * stride;
+    // Added elements mark themselves, removed ones simply fall off the end
+    vertices.resize(required);
+
+    if (m_buffered && buffer.getVertexCount() < required) {
+      // Grow geometrically so that adding nodes one by one doesn't
+      // reallocate (and re-upload everything) every frame
+      const auto old_count = buffer.getVertexCount();
+      buffer.create(std::max(required, old_count * 2));
+      tracker.mark_all();
+      m_reallocations.add();
+      m_buffer_bytes.add(static_cast<double>(
+          (buffer.getVertexCount() - old_count) * sizeof(sf::Vertex)));
+    }
+
+    tracker.flush(count, [&](uint32_t first, uint32_t num) {
+      for (auto i = first; i < first + num; i++) {
+        elements[i]->write_vertices(&vertices[size_t{i} * stride]);
+      }
+      if (m_buffered) {
+        buffer.update(&vertices[size_t{first} * stride], size_t{num} * stride,
+                      first * stride);
+      }
+      m_uploads.add();
+      m_uploaded_vertices.add(size_t{num} * stride);
+    });
+  }
+
+  /// @brief Draws one layer, from the vertex buffer when available.
+  auto draw_layer(RenderTarget& target, const vector<sf::Vertex>& vertices,
+                  const sf::VertexBuffer& buffer, sf::PrimitiveType type,
+                  const Texture* texture) const -> void {
+    if (vertices.empty()) return;
+    const sf::RenderStates states(texture);
+    if (m_buffered) {
+      target.draw(buffer, 0, vertices.size(), states);
+    } else {
+      target.draw(vertices.data(), vertices.size(), type, states);
+    }
+  }
+
+  /// @brief The changes since the last `sync()`.
+  SceneChanges m_changes;
+
+  /// @brief CPU-side copies of the node (6 per node) and edge (2 per edge)
+  /// vertices.
+  vector<sf::Vertex> m_node_vertices;
+  vector<sf::Vertex> m_edge_vertices;
+
+  /// @brief The GPU-side vertices (may hold more vertices than drawn).
+  sf::VertexBuffer m_node_buffer;
+  sf::VertexBuffer m_edge_buffer;
+
+  /// @brief Whether vertex buffers are supported.
+  bool m_buffered;
+
+  tracing::Counter& m_uploads = tracing::metrics().counter(
+      "render_uploads_total", "Vertex ranges re-uploaded");
+  tracing::Counter& m_uploaded_vertices = tracing::metrics().counter(
+      "render_uploaded_vertices_total", "Vertices re-uploaded");
+  tracing::Counter& m_reallocations = tracing::metrics().counter(
+      "render_buffer_reallocations_total", "Vertex buffer reallocations");
+  /// @brief Bytes allocated for the vertex buffers of every live scene.
+  tracing::Gauge& m_buffer_bytes = tracing::metrics().gauge(
+      "render_buffer_bytes", "Bytes allocated for vertex buffers");
+};
+
 // //
 // ---------------------------------------------------------------------------
 // // DAG (Directed Acyclic Graph)
@@ -355,7 +709,8 @@ class Edge {
 /// are no cycles in the graph). The DAG is used to represent the
 /// environment
 ///
-/// NOTE: The DAG can be converted to an adjacency matrix
+/// NOTE: The DAG can be converted to an adjacency matrix (see
+/// `adjacency_matrix()` in graph/all_pairs.h)
 ///
 /// The DAG is what the user interacts with inside of the environment when
 /// it comes to adding nodes and edges to the graph via mouse clicks.
@@ -369,39 +724,55 @@ class DirectedAcyclicGraph {
   // auto operator=(DirectedAcyclicGraph&& other)
   //     -> DirectedAcyclicGraph& = delete;
 
-  DirectedAcyclicGraph(RenderWindow* window, Texture* texture,
+  DirectedAcyclicGraph(RenderTarget* target, const Texture* texture,
                        unique_ptr<Node> root, unique_ptr<Node> goal) {
-    // TODO: this needs to me changed
-    m_root = root.release();
-    m_goal = goal.release();
+    m_root = root.get();
+    m_goal = goal.get();
 
     m_nodes.reserve(INITIAL_GRAPH_CAPACITY);
     m_edges.reserve(INITIAL_GRAPH_CAPACITY);
+    m_edge_index.reserve(INITIAL_GRAPH_CAPACITY);
 
-    m_nodes.push_back(std::move(root));
-    m_nodes.push_back(std::move(goal));
-
-    m_window = window;
+    m_target = target;
     m_texture = texture;
+
+    add_node(std::move(root));
+    add_node(std::move(goal));
   }
 
   ~DirectedAcyclicGraph() = default;
 
-  auto add_node(unique_ptr<Node> node) -> void {
+  auto add_node(unique_ptr<Node> node) -> Node* {
+    auto node_ptr = node.get();
+    node_ptr->set_id(static_cast<NodeId>(m_nodes.size()));
+    node_ptr->set_changes(m_scene.changes());
+    m_scene.changes()->nodes.mark(node_ptr->id());
     m_nodes.push_back(std::move(node));
+    return node_ptr;
   }
 
+  /// @brief Adds an untextured node. The graph's texture is only what nodes
+  /// are drawn with (e.g. the whole atlas), not an image of their own: give
+  /// the node one with `Node::set_texture()` and `Node::set_texture_rect()`.
   auto add_node(Vector2f position) -> Node* {
-    // auto node = std::make_unique<Node>(m_window, position);
-    auto node = std::make_unique<Node>(*m_window, *m_texture, position);
-    auto node_ptr = node.get();
-    m_nodes.push_back(std::move(node));
-    return node_ptr;
+    return add_node(std::make_unique<Node>(*m_target, position));
   }
 
+  /// @brief Adds an edge, unless the graph already has one between the same
+  /// nodes (in the same direction).
+  /// @return The new edge, or `nullptr` if it would have been a duplicate.
   auto add_edge(Node* from, Node* to) -> Edge* {
+    const auto id = static_cast<EdgeId>(m_edges.size());
+    if (!m_edge_index.insert(EdgeKey{from, to}, id).second) {
+      tracing::debug("Ignoring duplicate edge {} -> {}", from->id(), to->id());
+      return nullptr;
+    }
+
     auto edge = std::make_unique<Edge>(from, to);
     auto edge_ptr = edge.get();
+    edge_ptr->set_id(id);
+    edge_ptr->set_changes(m_scene.changes());
+    edge_ptr->mark_changed();
     m_edges.push_back(std::move(edge));
 
     from->add_outgoing_edge(edge_ptr);
@@ -409,14 +780,82 @@ class DirectedAcyclicGraph {
     return edge_ptr;
   }
 
-  auto render() -> void {
-    for (const auto& node : m_nodes) {
-      node->render();
+  /// @brief Removes an edge. The last edge takes over its id, so ids stay
+  /// dense (pointers to other edges remain valid).
+  /// @param edge The edge to remove.
+  auto remove_edge(Edge* edge) -> void {
+    detach(edge->from()->outgoing_edges(), edge);
+    detach(edge->to()->incoming_edges(), edge);
+    m_edge_index.erase(EdgeKey{edge->from(), edge->to()});
+
+    const auto id = edge->id();
+    if (id + 1 != m_edges.size()) {
+      m_edges[id] = std::move(m_edges.back());
+      m_edges[id]->set_id(id);
+      m_edges[id]->mark_changed();
+      if (m_edges[id]->cost_stale()) m_scene.changes()->costs.mark(id);
+      m_edge_index[EdgeKey{m_edges[id]->from(), m_edges[id]->to()}] = id;
     }
+    m_edges.pop_back();
+    m_scene.changes()->edges.mark_removed();
+  }
+
+  /// @brief Removes a node along with its edges. The last node takes over its
+  /// id, so ids stay dense. The source and target cannot be removed.
+  /// @param node The node to remove.
+  auto remove_node(Node* node) -> void {
+    if (node == m_root || node == m_goal) {
+      tracing::warn("Cannot remove the source or target node");
+      return;
+    }
+    while (!node->incoming_edges()->empty()) {
+      remove_edge(node->incoming_edges()->back());
+    }
+    while (!node->outgoing_edges()->empty()) {
+      remove_edge(node->outgoing_edges()->back());
+    }
+
+    const auto id = node->id();
+    if (id + 1 != m_nodes.size()) {
+      m_nodes[id] = std::move(m_nodes.back());
+      m_nodes[id]->set_id(id);
+      m_scene.changes()->nodes.mark(id);
+    }
+    m_nodes.pop_back();
+    m_scene.changes()->nodes.mark_removed();
+  }
 
-    // for (const auto& edge : m_edges) {
-    //     edge->render();
-    // }
+  /// @brief Recomputes, in one pass, the geometric costs invalidated by
+  /// nodes that moved since the last call. Searches stay correct without it
+  /// (stale edges compute their length on the fly), just slower.
+  /// @return The number of edges whose cost was recomputed.
+  auto refresh_costs() -> size_t {
+    size_t refreshed = 0;
+    const auto num_edges = static_cast<uint32_t>(m_edges.size());
+    m_scene.changes()->costs.flush(num_edges, [&](uint32_t first, uint32_t n) {
+      for (auto id = first; id < first + n; id++) {
+        if (!m_edges[id]->cost_stale()) continue;
+        m_edges[id]->refresh_cost();
+        refreshed++;
+      }
+    });
+    return refreshed;
+  }
+
+  /// @brief Sets the texture shared by every node (e.g. the texture atlas).
+  /// Untextured nodes sample its top-left texel, which should be white.
+  /// @param texture The texture (may be `nullptr`).
+  auto set_texture(const Texture* texture) -> void { m_texture = texture; }
+
+  /// @brief Whether anything has to be redrawn since the last `render()`.
+  auto dirty() const { return m_scene.dirty(); }
+
+  /// @brief Renders the graph: re-uploads the nodes and edges that changed
+  /// since the last frame, then draws the edges and all nodes (which share
+  /// the graph's texture) with one draw call each.
+  auto render() -> void {
+    m_scene.sync(m_nodes, m_edges);
+    m_scene.draw(*m_target, m_texture);
   }
 
   /// @brief Returns the source node of the graph.
@@ -427,6 +866,30 @@ class DirectedAcyclicGraph {
   /// @return The target node of the graph.
   auto target() const { return m_goal; }
 
+  /// @brief Returns the node with the given id.
+  /// @param id The id of the node (`id < num_nodes()`).
+  /// @return The node with the given id.
+  auto node(NodeId id) const { return m_nodes[id].get(); }
+
+  /// @brief Returns the edge from one node to another, if there is one (in
+  /// O(1)).
+  /// @return The edge, or `nullptr` if the nodes aren't connected.
+  auto find_edge(const Node* from, const Node* to) const -> Edge* {
+    auto it = m_edge_index.find(EdgeKey{from, to});
+    return it == m_edge_index.end() ? nullptr : m_edges[it->second].get();
+  }
+
+  /// @brief Whether there is an edge from one node to another (in O(1)).
+  auto has_edge(const Node* from, const Node* to) const -> bool {
+    return m_edge_index.contains(EdgeKey{from, to});
+  }
+
+  /// @brief Returns the nodes of the graph, indexed by `NodeId`.
+  auto nodes() const -> const vector<unique_ptr<Node>>& { return m_nodes; }
+
+  /// @brief Returns the edges of the graph in insertion order.
+  auto edges() const -> const vector<unique_ptr<Edge>>& { return m_edges; }
+
   /// @brief Returns the number of nodes in the graph.
   /// @return The number of nodes in the graph.
   auto num_nodes() const { return m_nodes.size(); }
@@ -442,7 +905,20 @@ class DirectedAcyclicGraph {
   Node* m_root;
   Node* m_goal;
 
-  RenderWindow* m_window;
-  Texture* m_texture;
+  RenderTarget* m_target;
+  const Texture* m_texture;
+
+  /// @brief The retained vertices of the nodes and edges.
+  RenderScene m_scene;
+
+  /// @brief The id of every edge, by its endpoints.
+  data_structures::containers::FlatHashMap<EdgeKey, EdgeId, EdgeKeyHash>
+      m_edge_index;
+
+  /// @brief Removes an edge from a node's incoming or outgoing edges.
+  static auto detach(EdgeList* edges, Edge* edge) -> void {
+    edges->erase(std::remove(edges->begin(), edges->end(), edge),
+                 edges->end());
+  }
 };
 }  // namespace graph
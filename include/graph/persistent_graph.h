@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "graph/graph.h"
+#include "utils/config.h"
+#include "utils/data_structures/persistent_vector.h"
+#include "utils/data_structures/small_vector.h"
+
+namespace graph {
+
+// ---------------------------------------------------------------------------
+// Persistent graph
+// ---------------------------------------------------------------------------
+
+/// @brief The ids of a node's incoming or outgoing edges in a
+/// `PersistentGraph`.
+using EdgeIdList =
+    data_structures::containers::SmallVector<EdgeId, INLINE_EDGES>;
+
+/// @brief A node of a `PersistentGraph`.
+struct NodeState {
+  Vector2f position;
+  EdgeIdList incoming;
+  EdgeIdList outgoing;
+  /// @brief Whether the node has been removed (ids are never reused, so
+  /// removed nodes stay behind as tombstones).
+  bool removed = false;
+};
+
+/// @brief An edge of a `PersistentGraph`.
+struct EdgeState {
+  NodeId from = INVALID_NODE;
+  NodeId to = INVALID_NODE;
+  float cost = 0.0f;
+  /// @brief Whether the edge has been removed.
+  bool removed = false;
+};
+
+/// @brief A version of a graph that never changes once it has been copied.
+///
+/// Nodes and edges are stored in `PersistentVector`s, so copying a graph is
+/// O(1) and every edit copies only the O(log n) chunks on its path while the
+/// rest are shared with earlier versions. That makes it cheap to keep every
+/// version around (see `GraphHistory`) and to hand a consistent snapshot to
+/// a search thread while the UI keeps editing its own copy.
+///
+/// Unlike `DirectedAcyclicGraph`, ids are stable: removed nodes and edges are
+/// marked as such rather than swapped out. The graph holds no rendering
+/// state.
+class PersistentGraph {
+ public:
+  PersistentGraph() = default;
+
+  /// @brief Captures the current state of a (mutable) graph, in O(n).
+  static auto from(const DirectedAcyclicGraph& graph) -> PersistentGraph {
+    PersistentGraph snapshot;
+    for (const auto& node : graph.nodes()) {
+      snapshot.add_node(node->position());
+    }
+    for (const auto& edge : graph.edges()) {
+      snapshot.add_edge(edge->from()->id(), edge->to()->id(), edge->cost());
+    }
+    return snapshot;
+  }
+
+  /// @brief Adds a node.
+  /// @return The id of the new node.
+  auto add_node(Vector2f position) -> NodeId {
+    const auto id = static_cast<NodeId>(nodes_.size());
+    nodes_.push_back(NodeState{position, {}, {}, false});
+    return id;
+  }
+
+  /// @brief Moves a node.
+  auto move_node(NodeId id, Vector2f position) -> void {
+    nodes_.update(id, [&](NodeState& node) { node.position = position; });
+  }
+
+  /// @brief Removes a node along with its edges (no-op if it already was).
+  auto remove_node(NodeId id) -> void {
+    const auto node = nodes_[id];
+    if (node.removed) return;
+    for (auto edge : node.incoming) remove_edge(edge);
+    for (auto edge : node.outgoing) remove_edge(edge);
+    nodes_.update(id, [](NodeState& node) { node.removed = true; });
+    num_removed_nodes_++;
+  }
+
+  /// @brief Adds an edge between two existing nodes.
+  /// @return The id of the new edge.
+  auto add_edge(NodeId from, NodeId to, float cost) -> EdgeId {
+    const auto id = static_cast<EdgeId>(edges_.size());
+    edges_.push_back(EdgeState{from, to, cost});
+    nodes_.update(from, [&](NodeState& node) { node.outgoing.push_back(id); });
+    nodes_.update(to, [&](NodeState& node) { node.incoming.push_back(id); });
+    return id;
+  }
+
+  /// @brief Removes an edge (no-op if it already was).
+  auto remove_edge(EdgeId id) -> void {
+    const auto edge = edges_[id];
+    if (edge.removed) return;
+    edges_.update(id, [](EdgeState& edge) { edge.removed = true; });
+    nodes_.update(edge.from,
+                  [&](NodeState& node) { detach(node.outgoing, id); });
+    nodes_.update(edge.to, [&](NodeState& node) { detach(node.incoming, id); });
+    num_removed_edges_++;
+  }
+
+  /// @brief Changes the cost of an edge.
+  auto set_edge_cost(EdgeId id, float cost) -> void {
+    edges_.update(id, [&](EdgeState& edge) { edge.cost = cost; });
+  }
+
+  /// @brief The node with the given id (`id < node_capacity()`).
+  auto node(NodeId id) const -> const NodeState& { return nodes_[id]; }
+
+  /// @brief The edge with the given id (`id < edge_capacity()`).
+  auto edge(EdgeId id) const -> const EdgeState& { return edges_[id]; }
+
+  /// @brief The number of node ids handed out (including removed nodes).
+  auto node_capacity() const -> size_t { return nodes_.size(); }
+
+  /// @brief The number of edge ids handed out (including removed edges).
+  auto edge_capacity() const -> size_t { return edges_.size(); }
+
+  /// @brief The number of nodes in the graph.
+  auto num_nodes() const -> size_t {
+    return nodes_.size() - num_removed_nodes_;
+  }
+
+  /// @brief The number of edges in the graph.
+  auto num_edges() const -> size_t {
+    return edges_.size() - num_removed_edges_;
+  }
+
+  /// @brief Calls `visit(id, node)` for every node that hasn't been removed.
+  template <typename Visit>
+  auto for_each_node(Visit&& visit) const -> void {
+    NodeId id = 0;
+    nodes_.for_each([&](const NodeState& node) {
+      if (!node.removed) visit(id, node);
+      id++;
+    });
+  }
+
+ private:
+  static auto detach(EdgeIdList& edges, EdgeId edge) -> void {
+    edges.erase(std::remove(edges.begin(), edges.end(), edge), edges.end());
+  }
+
+  data_structures::containers::PersistentVector<NodeState> nodes_;
+  data_structures::containers::PersistentVector<EdgeState> edges_;
+  size_t num_removed_nodes_ = 0;
+  size_t num_removed_edges_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// History
+// ---------------------------------------------------------------------------
+
+/// @brief The versions of a graph, for undo and redo.
+///
+/// Versions share all unchanged chunks, so keeping
+/// `config::GRAPH_HISTORY_DEPTH` of them costs little more than the edits
+/// themselves. The current version can be read by other threads through
+/// `snapshot()`.
+class GraphHistory {
+ public:
+  explicit GraphHistory(PersistentGraph initial = {}) {
+    versions_.push_back(std::move(initial));
+  }
+
+  /// @brief The current version (owning thread only).
+  auto current() const -> const PersistentGraph& { return versions_[index_]; }
+
+  /// @brief A copy of the current version, safe to call from any thread.
+  /// The copy is O(1) and never changes, whatever happens to the history.
+  auto snapshot() const -> PersistentGraph {
+    std::lock_guard lock(mutex_);
+    return versions_[index_];
+  }
+
+  /// @brief Makes a new version current, discarding the versions that could
+  /// have been redone. The oldest version is dropped once there are more
+  /// than `config::GRAPH_HISTORY_DEPTH`.
+  auto commit(PersistentGraph version) -> void {
+    std::lock_guard lock(mutex_);
+    versions_.erase(versions_.begin() + index_ + 1, versions_.end());
+    versions_.push_back(std::move(version));
+    if (versions_.size() > config::GRAPH_HISTORY_DEPTH) versions_.pop_front();
+    index_ = versions_.size() - 1;
+  }
+
+  /// @brief Applies an edit to a copy of the current version and commits it.
+  /// @param edit Called with the new version (e.g. `[&](auto& graph) {
+  ///             graph.add_node(position); }`).
+  template <typename Edit>
+  auto edit(Edit&& edit) -> void {
+    auto version = current();
+    edit(version);
+    commit(std::move(version));
+  }
+
+  /// @brief Goes back to the previous version.
+  /// @return Whether there was a version to go back to.
+  auto undo() -> bool {
+    std::lock_guard lock(mutex_);
+    if (index_ == 0) return false;
+    index_--;
+    return true;
+  }
+
+  /// @brief Goes forward to the version that was undone last.
+  /// @return Whether there was a version to go forward to.
+  auto redo() -> bool {
+    std::lock_guard lock(mutex_);
+    if (index_ + 1 == versions_.size()) return false;
+    index_++;
+    return true;
+  }
+
+  auto can_undo() const -> bool { return index_ > 0; }
+  auto can_redo() const -> bool { return index_ + 1 < versions_.size(); }
+
+ private:
+  /// @brief Guards `versions_` and `index_` against `snapshot()`.
+  mutable std::mutex mutex_;
+  std::deque<PersistentGraph> versions_;
+  /// @brief The index of the current version.
+  size_t index_ = 0;
+};
+
+}  // namespace graph
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "graph/csr.h"
+#include "graph/graph.h"
+#include "graph/search_context.h"
+#include "graph/step_recorder.h"
+#include "utils/metrics.h"
+#include "utils/spans.h"
+
+using std::vector;
+
+namespace graph {
+
+// ---------------------------------------------------------------------------
+// Heuristics
+// ---------------------------------------------------------------------------
+
+/// @brief A heuristic that always returns 0 (turns A* into Dijkstra's).
+inline auto zero_heuristic(const Node&, const Node&) -> float { return 0.0f; }
+
+/// @brief The straight-line distance between two nodes. Admissible whenever
+/// edge costs are at least the distance between their endpoints.
+inline auto euclidean_heuristic(const Node& from, const Node& to) -> float {
+  return distance_between(from.position(), to.position());
+}
+
+// ---------------------------------------------------------------------------
+// Metrics
+// ---------------------------------------------------------------------------
+
+/// @brief What a single search did (reported to the metrics registry once
+/// the search finishes, rather than per step).
+struct SearchStats {
+  size_t expanded = 0;
+  size_t pushes = 0;
+  size_t pops = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+};
+
+/// @brief Reports a finished search to the metrics registry.
+inline auto report_search(const SearchStats& stats) -> void {
+  auto& registry = tracing::metrics();
+  static auto& queries =
+      registry.counter("search_queries_total", "Searches run");
+  static auto& expanded = registry.counter("search_nodes_expanded_total",
+                                           "Nodes expanded by all searches");
+  static auto& pushes = registry.counter("search_queue_pushes_total",
+                                         "Priority queue pushes");
+  static auto& pops =
+      registry.counter("search_queue_pops_total", "Priority queue pops");
+  static auto& expanded_per_query = registry.histogram(
+      "search_nodes_expanded", "Nodes expanded per search");
+  static auto& duration =
+      registry.histogram("search_duration_us", "Search duration (us)");
+
+  const auto elapsed = std::chrono::steady_clock::now() - stats.start;
+  queries.add();
+  expanded.add(stats.expanded);
+  pushes.add(stats.pushes);
+  pops.add(stats.pops);
+  expanded_per_query.record(stats.expanded);
+  duration.record(
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+// ---------------------------------------------------------------------------
+// Search
+// ---------------------------------------------------------------------------
+
+/// @brief Finds the cheapest path from `source` to `target` using the A*
+/// algorithm.
+///
+/// The g(n) values and parents of the nodes the search reached are kept in
+/// `context` (not in the nodes), where they can be inspected until the
+/// context's next query. Reusing a context between queries is O(1), so short
+/// queries on large graphs only pay for the nodes they touch.
+///
+/// Every step of the search is reported to `recorder` (see `StepRecorder`).
+/// Pass a `NullRecorder` to compile the instrumentation out entirely. Totals
+/// (nodes expanded, queue operations, duration) are reported to the metrics
+/// registry once the search finishes.
+///
+/// @param graph The graph to search.
+/// @param context The state of the query (owned by the calling thread).
+/// @param source The node to start from.
+/// @param target The node to find a path to.
+/// @param heuristic Estimates the remaining cost from a node to `target`.
+/// @param recorder Receives every step of the search.
+/// @return The nodes on the path (source first), or an empty vector if
+///         `target` is unreachable.
+template <typename Heuristic, typename Recorder>
+auto a_star(const DirectedAcyclicGraph& graph, SearchContext& context,
+            Node* source, Node* target, Heuristic&& heuristic,
+            Recorder& recorder) -> vector<Node*> {
+  tracing::Span span("a_star", "search");
+  context.begin(graph.num_nodes());
+  SearchStats stats;
+
+  context.relax(source->id(), 0.0f, INVALID_NODE);
+  context.push(heuristic(*source, *target), source->id());
+  stats.pushes++;
+  if constexpr (Recorder::kEnabled) {
+    recorder.record(StepKind::Push, source->id(), INVALID_NODE, 0.0f);
+  }
+
+  while (!context.open_empty()) {
+    const auto id = context.pop().second;
+    stats.pops++;
+    // Stale entry (the node was pushed again with a lower cost).
+    if (context.closed(id)) continue;
+
+    auto node = graph.node(id);
+    const auto node_cost = context.cost(id);
+    context.close(id);
+    stats.expanded++;
+    if constexpr (Recorder::kEnabled) {
+      recorder.record(StepKind::Pop, id, context.parent(id), node_cost);
+    }
+
+    if (node == target) {
+      vector<Node*> path;
+      for (auto at = id; at != INVALID_NODE; at = context.parent(at)) {
+        if constexpr (Recorder::kEnabled) {
+          recorder.record(StepKind::PathFound, at, context.parent(at),
+                          context.cost(at));
+        }
+        path.push_back(graph.node(at));
+      }
+      std::reverse(path.begin(), path.end());
+      span.arg("expanded", stats.expanded).arg("path", path.size());
+      report_search(stats);
+      return path;
+    }
+
+    for (auto edge : *node->outgoing_edges()) {
+      auto next = edge->to();
+      const auto next_id = next->id();
+      if (context.closed(next_id)) continue;
+
+      const auto cost = node_cost + edge->cost();
+      if (cost < context.cost(next_id)) {
+        context.relax(next_id, cost, id);
+        context.push(cost + heuristic(*next, *target), next_id);
+        stats.pushes++;
+        if constexpr (Recorder::kEnabled) {
+          recorder.record(StepKind::Relax, next_id, id, cost);
+          recorder.record(StepKind::Push, next_id, id, cost);
+        }
+      }
+    }
+
+    if constexpr (Recorder::kEnabled) {
+      recorder.record(StepKind::Settle, id, context.parent(id), node_cost);
+    }
+  }
+
+  span.arg("expanded", stats.expanded).arg("path", 0);
+  report_search(stats);
+  return {};
+}
+
+/// @brief Finds the cheapest path from `source` to `target` using the A*
+/// algorithm, with the calling thread's search context.
+template <typename Heuristic, typename Recorder>
+auto a_star(const DirectedAcyclicGraph& graph, Node* source, Node* target,
+            Heuristic&& heuristic, Recorder& recorder) -> vector<Node*> {
+  return a_star(graph, search_context(), source, target,
+                std::forward<Heuristic>(heuristic), recorder);
+}
+
+/// @brief Finds the cheapest path from `source` to `target` using the A*
+/// algorithm (uninstrumented).
+template <typename Heuristic>
+auto a_star(const DirectedAcyclicGraph& graph, Node* source, Node* target,
+            Heuristic&& heuristic) -> vector<Node*> {
+  NullRecorder recorder;
+  return a_star(graph, source, target, std::forward<Heuristic>(heuristic),
+                recorder);
+}
+
+/// @brief Finds the cheapest path from `source` to `target` using Dijkstra's
+/// algorithm, reporting every step to `recorder`.
+template <typename Recorder>
+auto dijkstra(const DirectedAcyclicGraph& graph, Node* source, Node* target,
+              Recorder& recorder) -> vector<Node*> {
+  return a_star(graph, source, target, zero_heuristic, recorder);
+}
+
+/// @brief Finds the cheapest path from `source` to `target` using Dijkstra's
+/// algorithm (uninstrumented).
+inline auto dijkstra(const DirectedAcyclicGraph& graph, Node* source,
+                     Node* target) -> vector<Node*> {
+  NullRecorder recorder;
+  return a_star(graph, source, target, zero_heuristic, recorder);
+}
+
+/// @brief Finds the cheapest path from `source` to `target` in an
+/// `ArcGraph` (e.g. a `CsrGraph` or a `CompressedGraph`, whose edges are
+/// decoded as they are relaxed) using Dijkstra's algorithm.
+///
+/// The costs and parents of the nodes reached are left in `context`.
+/// @return The ids of the nodes on the path (source first), or an empty
+///         vector if `target` is unreachable.
+template <ArcGraph Graph>
+auto dijkstra(const Graph& graph, SearchContext& context, NodeId source,
+              NodeId target) -> vector<NodeId> {
+  tracing::Span span("dijkstra", "search");
+  context.begin(graph.num_nodes());
+  SearchStats stats;
+
+  context.relax(source, 0.0f, INVALID_NODE);
+  context.push(0.0f, source);
+  stats.pushes++;
+  while (!context.open_empty()) {
+    const auto [cost, id] = context.pop();
+    stats.pops++;
+    if (context.closed(id)) continue;
+    context.close(id);
+    stats.expanded++;
+    if (id == target) break;
+
+    graph.for_each_arc(id, [&](NodeId next, float edge_cost) {
+      if (context.closed(next)) return;
+      const auto next_cost = cost + edge_cost;
+      if (next_cost < context.cost(next)) {
+        context.relax(next, next_cost, id);
+        context.push(next_cost, next);
+        stats.pushes++;
+      }
+    });
+  }
+
+  report_search(stats);
+  if (!context.closed(target)) return {};
+  auto path = context.path_to(target);
+  span.arg("expanded", stats.expanded).arg("path", path.size());
+  return path;
+}
+
+}  // namespace graph
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "graph/graph.h"
+
+using std::vector;
+
+namespace graph {
+
+/// @brief The cost assigned to nodes the search has not reached (yet).
+static constexpr float UNREACHED = INF;
+
+/// @brief The per-query state of a search (g(n), parents, closed set and the
+/// open set), kept outside the graph so that searches don't have to touch
+/// every node between queries and several threads can search the same graph
+/// at once, each with its own context.
+///
+/// Every entry is stamped with the epoch of the query that last wrote it;
+/// entries with an older stamp read as unreached. Starting a query just
+/// bumps the epoch, so it costs O(1) rather than O(V) (the arrays are only
+/// cleared when the 32-bit epoch wraps around).
+///
+/// Not thread-safe: use one context per thread (see `search_context()`).
+class SearchContext {
+ public:
+  /// @brief An entry of the open set: f(n) and the node.
+  using OpenEntry = std::pair<float, NodeId>;
+
+  /// @brief Starts a new query over a graph of `num_nodes` nodes, forgetting
+  /// everything about the previous one.
+  auto begin(size_t num_nodes) -> void {
+    if (num_nodes > states_.size()) states_.resize(num_nodes);
+    if (++epoch_ == 0) {
+      std::fill(states_.begin(), states_.end(), State{});
+      epoch_ = 1;
+    }
+    open_.clear();
+  }
+
+  /// @brief The cost (g(n)) of the cheapest path found so far to a node
+  /// (`UNREACHED` if none).
+  auto cost(NodeId id) const -> float {
+    return reached(id) ? states_[id].cost : UNREACHED;
+  }
+
+  /// @brief The node `id` was reached from on the cheapest path found so far
+  /// (`INVALID_NODE` if none).
+  auto parent(NodeId id) const -> NodeId {
+    return reached(id) ? states_[id].parent : INVALID_NODE;
+  }
+
+  /// @brief Whether the current query has reached a node.
+  auto reached(NodeId id) const -> bool { return states_[id].seen == epoch_; }
+
+  /// @brief Whether a node's cost is final.
+  auto closed(NodeId id) const -> bool { return states_[id].closed == epoch_; }
+
+  /// @brief Records a (cheaper) path to a node.
+  auto relax(NodeId id, float cost, NodeId parent) -> void {
+    auto& state = states_[id];
+    state.cost = cost;
+    state.parent = parent;
+    state.seen = epoch_;
+  }
+
+  /// @brief Marks a node's cost as final.
+  auto close(NodeId id) -> void { states_[id].closed = epoch_; }
+
+  /// @brief Pushes a node onto the open set (min-heap on f(n)).
+  auto push(float priority, NodeId id) -> void {
+    open_.emplace_back(priority, id);
+    std::push_heap(open_.begin(), open_.end(), std::greater<>{});
+  }
+
+  /// @brief Pops the entry with the lowest f(n) off the open set.
+  auto pop() -> OpenEntry {
+    std::pop_heap(open_.begin(), open_.end(), std::greater<>{});
+    auto entry = open_.back();
+    open_.pop_back();
+    return entry;
+  }
+
+  /// @brief Whether the open set is empty.
+  auto open_empty() const -> bool { return open_.empty(); }
+
+  /// @brief The nodes on the path to `target` (source first), following the
+  /// parents recorded by the current query.
+  auto path_to(NodeId target) const -> vector<NodeId> {
+    vector<NodeId> path;
+    for (auto at = target; at != INVALID_NODE; at = parent(at)) {
+      path.push_back(at);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+
+  /// @brief The epoch of the current query.
+  auto epoch() const -> uint32_t { return epoch_; }
+
+ private:
+  /// @brief Everything a query knows about a node (16 bytes, so a node's
+  /// state is a single cache line access).
+  struct State {
+    float cost = UNREACHED;
+    NodeId parent = INVALID_NODE;
+    /// @brief The epoch in which `cost` and `parent` were written.
+    uint32_t seen = 0;
+    /// @brief The epoch in which the node was closed.
+    uint32_t closed = 0;
+  };
+
+  vector<State> states_;
+  /// @brief Reused across queries (so is its capacity).
+  vector<OpenEntry> open_;
+  uint32_t epoch_ = 0;
+};
+
+/// @brief The calling thread's search context.
+inline auto search_context() -> SearchContext& {
+  thread_local SearchContext context;
+  return context;
+}
+
+/// @brief The calling thread's context for searches that algorithms run
+/// internally (e.g. one per source for all-pairs shortest paths). Separate
+/// from `search_context()`, so they don't clobber a search the caller is
+/// still reading from it (the calling thread takes part in parallel loops).
+inline auto internal_search_context() -> SearchContext& {
+  thread_local SearchContext context;
+  return context;
+}
+
+}  // namespace graph
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "graph/csr.h"
+#include "graph/graph.h"
+#include "utils/data_structures/union_find.h"
+#include "utils/parallel.h"
+#include "utils/spans.h"
+
+using std::vector;
+
+namespace graph {
+
+/// @brief The color of the edges of a spanning forest in the overlay.
+inline const Color SPANNING_TREE_COLOR = Color(0, 230, 90);
+
+/// @brief The color of the other edges while the overlay is shown.
+inline const Color NON_TREE_EDGE_COLOR = Color(255, 255, 255, 16);
+
+/// @brief A minimum spanning forest: one minimum spanning tree per
+/// connected component (edges are treated as undirected).
+struct SpanningForest {
+  /// @brief The ids of the edges of the forest, in the order they were
+  /// added.
+  vector<EdgeId> edges;
+  /// @brief The sum of the costs of the edges.
+  double cost = 0.0;
+  /// @brief The number of trees (connected components, isolated nodes
+  /// included).
+  size_t num_trees = 0;
+};
+
+/// @brief An edge as a single integer ordered by cost, then by id (the
+/// float's bits are flipped so that they compare like the float).
+///
+/// Breaking ties by id makes the minimum spanning forest unique, so
+/// Kruskal and Borůvka agree and Borůvka's simultaneous merges never close
+/// a cycle.
+inline auto edge_key(float cost, EdgeId id) -> uint64_t {
+  const auto bits = std::bit_cast<uint32_t>(cost);
+  const auto ordered = bits >> 31 ? ~bits : bits | 0x80000000u;
+  return uint64_t{ordered} << 32 | id;
+}
+
+/// @brief The key of a component without an outgoing edge (yet).
+inline constexpr uint64_t NO_EDGE_KEY = UINT64_MAX;
+
+/// @brief The number of edges a thread claims at once in parallel passes.
+inline constexpr size_t EDGE_GRAIN = 4096;
+
+// ---------------------------------------------------------------------------
+// Kruskal
+// ---------------------------------------------------------------------------
+
+/// @brief The minimum spanning forest of a graph, with Kruskal's algorithm:
+/// the edges are sorted by cost (in parallel, see `parallel::parallel_sort`)
+/// and added in that order unless they would close a cycle, which a
+/// union-find with path compression and union by rank detects in
+/// near-constant time. O(E log E), dominated by the sort.
+///
+/// @param num_nodes The number of nodes (edge endpoints are below this).
+/// @param edges The edges, indexed by `EdgeId`.
+/// @param threads The maximum number of threads the sort is spread over.
+inline auto kruskal(size_t num_nodes, std::span<const WeightedEdge> edges,
+                    size_t threads = parallel::num_threads())
+    -> SpanningForest {
+  tracing::Span span("kruskal", "graph");
+  span.arg("nodes", num_nodes).arg("edges", edges.size());
+
+  // Sorting the keys (8 bytes) moves less memory than sorting the edges
+  vector<uint64_t> order(edges.size());
+  parallel::parallel_for(
+      edges.size(),
+      [&](size_t id) {
+        order[id] = edge_key(edges[id].cost, static_cast<EdgeId>(id));
+      },
+      EDGE_GRAIN, threads);
+  parallel::parallel_sort(order.begin(), order.end(), std::less<>{}, threads);
+
+  SpanningForest forest;
+  data_structures::sets::UnionFind components(num_nodes);
+  for (auto key : order) {
+    // A spanning tree of everything is complete
+    if (components.num_sets() <= 1) break;
+    const auto id = static_cast<EdgeId>(key);
+    const auto& edge = edges[id];
+    if (!components.unite(edge.from, edge.to)) continue;
+    forest.edges.push_back(id);
+    forest.cost += edge.cost;
+  }
+  forest.num_trees = components.num_sets();
+  return forest;
+}
+
+/// @brief The minimum spanning forest of a (mutable) graph, in the order of
+/// `Edge::operator<`.
+inline auto kruskal(const DirectedAcyclicGraph& graph,
+                    size_t threads = parallel::num_threads())
+    -> SpanningForest {
+  return kruskal(graph.num_nodes(), edge_list(graph), threads);
+}
+
+// ---------------------------------------------------------------------------
+// Borůvka
+// ---------------------------------------------------------------------------
+
+/// @brief The minimum spanning forest of a graph, with Borůvka's algorithm,
+/// which needs no global sort and parallelizes over edges.
+///
+/// Every round, each component finds its cheapest outgoing edge (all edges
+/// are scanned in parallel, each lowering the candidates of both its
+/// components with an atomic min), then all those edges are added at once,
+/// which at least halves the number of components. Edges inside a component
+/// are dropped as the rounds go, so O(E log V) work in total but usually
+/// much less, and only O(log V) sequential steps over the nodes.
+///
+/// @param num_nodes The number of nodes (edge endpoints are below this).
+/// @param edges The edges, indexed by `EdgeId`.
+/// @param threads The maximum number of threads edges are spread over.
+inline auto boruvka(size_t num_nodes, std::span<const WeightedEdge> edges,
+                    size_t threads = parallel::num_threads())
+    -> SpanningForest {
+  tracing::Span span("boruvka", "graph");
+  span.arg("nodes", num_nodes).arg("edges", edges.size());
+
+  data_structures::sets::UnionFind components(num_nodes);
+  // The representative of each node's component as of the current round
+  vector<NodeId> component(num_nodes);
+  std::iota(component.begin(), component.end(), NodeId{0});
+  vector<EdgeId> remaining;
+  remaining.reserve(edges.size());
+  for (size_t id = 0; id < edges.size(); id++) {
+    if (edges[id].from != edges[id].to) {
+      remaining.push_back(static_cast<EdgeId>(id));
+    }
+  }
+  // The key of each component's cheapest outgoing edge
+  vector<std::atomic<uint64_t>> cheapest(num_nodes);
+
+  SpanningForest forest;
+  size_t rounds = 0;
+  while (!remaining.empty()) {
+    rounds++;
+    parallel::parallel_for(
+        num_nodes,
+        [&](size_t node) {
+          cheapest[node].store(NO_EDGE_KEY, std::memory_order_relaxed);
+        },
+        EDGE_GRAIN, threads);
+
+    parallel::parallel_for(
+        remaining.size(),
+        [&](size_t index) {
+          const auto id = remaining[index];
+          const auto& edge = edges[id];
+          const auto key = edge_key(edge.cost, id);
+          for (auto end : {component[edge.from], component[edge.to]}) {
+            auto current = cheapest[end].load(std::memory_order_relaxed);
+            while (key < current &&
+                   !cheapest[end].compare_exchange_weak(
+                       current, key, std::memory_order_relaxed)) {
+            }
+          }
+        },
+        EDGE_GRAIN, threads);
+
+    // Both components of an edge may have picked it, the second `unite()`
+    // then fails
+    for (size_t node = 0; node < num_nodes; node++) {
+      const auto key = cheapest[node].load(std::memory_order_relaxed);
+      if (key == NO_EDGE_KEY) continue;
+      const auto id = static_cast<EdgeId>(key);
+      const auto& edge = edges[id];
+      if (!components.unite(edge.from, edge.to)) continue;
+      forest.edges.push_back(id);
+      forest.cost += edge.cost;
+    }
+
+    for (NodeId node = 0; node < num_nodes; node++) {
+      component[node] = components.find(node);
+    }
+    std::erase_if(remaining, [&](EdgeId id) {
+      return component[edges[id].from] == component[edges[id].to];
+    });
+  }
+  span.arg("rounds", rounds);
+  forest.num_trees = components.num_sets();
+  return forest;
+}
+
+/// @brief The minimum spanning forest of a (mutable) graph, with Borůvka's
+/// algorithm.
+inline auto boruvka(const DirectedAcyclicGraph& graph,
+                    size_t threads = parallel::num_threads())
+    -> SpanningForest {
+  return boruvka(graph.num_nodes(), edge_list(graph), threads);
+}
+
+// ---------------------------------------------------------------------------
+// Overlay
+// ---------------------------------------------------------------------------
+
+/// @brief Highlights the edges of a spanning forest (in
+/// `SPANNING_TREE_COLOR`) and dims every other edge. Only the edges whose
+/// color changes are re-uploaded.
+inline auto show_spanning_forest(DirectedAcyclicGraph& graph,
+                                 const SpanningForest& forest) -> void {
+  vector<bool> in_forest(graph.num_edges(), false);
+  for (auto id : forest.edges) in_forest[id] = true;
+  for (const auto& edge : graph.edges()) {
+    edge->set_color(in_forest[edge->id()] ? SPANNING_TREE_COLOR
+                                          : NON_TREE_EDGE_COLOR);
+  }
+}
+
+/// @brief Restores the color of every edge.
+inline auto hide_spanning_forest(DirectedAcyclicGraph& graph) -> void {
+  for (const auto& edge : graph.edges()) edge->set_color(EDGE_COLOR);
+}
+
+}  // namespace graph
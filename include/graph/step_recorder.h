@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "graph/graph.h"
+#include "utils/data_structures/spsc_queue.h"
+#include "utils/log_sampling.h"
+
+namespace graph {
+
+// ---------------------------------------------------------------------------
+// Search steps
+// ---------------------------------------------------------------------------
+
+/// @brief The kind of step a search algorithm took.
+enum class StepKind : uint8_t {
+  /// @brief A node was pushed onto the open set (frontier).
+  Push,
+  /// @brief A node was popped off the open set.
+  Pop,
+  /// @brief A shorter path to a node was found through `parent`.
+  Relax,
+  /// @brief A node's cost became final (closed set).
+  Settle,
+  /// @brief A node is part of the final path. Emitted once per path node,
+  /// from the target back to the source.
+  PathFound,
+};
+
+/// @brief A single, compact (16 byte) step of a search. Cheap enough to copy
+/// into a ring buffer from inside the search's inner loop.
+struct StepEvent {
+  /// @brief What happened.
+  StepKind kind;
+  /// @brief The node the step is about.
+  NodeId node;
+  /// @brief The node `node` was reached from (`INVALID_NODE` if none).
+  NodeId parent;
+  /// @brief The cost (g(n)) of `node` at the time of the step.
+  float cost;
+};
+
+static_assert(sizeof(StepEvent) == 16, "StepEvent should stay compact");
+
+/// @brief The queue step events are handed over on (search thread -> render
+/// thread).
+using StepQueue = data_structures::queue::SpscQueue<StepEvent>;
+
+// ---------------------------------------------------------------------------
+// Recorders
+// ---------------------------------------------------------------------------
+
+/// @brief A recorder that records nothing. Search algorithms check
+/// `kEnabled` with `if constexpr`, so instantiating a search with this
+/// recorder compiles the instrumentation away entirely.
+struct NullRecorder {
+  static constexpr bool kEnabled = false;
+
+  auto record(StepKind, NodeId, NodeId, float) const -> void {}
+};
+
+/// @brief Records search steps into a `StepQueue`.
+///
+/// The recorder lives on the search thread (it is the queue's single
+/// producer). Recording never blocks: if the consumer falls behind and the
+/// queue is full, the event is dropped and counted in `dropped()`.
+class StepRecorder {
+ public:
+  static constexpr bool kEnabled = true;
+
+  explicit StepRecorder(StepQueue& queue) : queue_(&queue) {}
+
+  /// @brief Records a single step.
+  inline auto record(StepKind kind, NodeId node, NodeId parent, float cost)
+      -> void {
+    if (!queue_->try_push(StepEvent{kind, node, parent, cost})) {
+      // Only the search thread writes, so no read-modify-write is needed.
+      const auto dropped = dropped_.load(std::memory_order_relaxed) + 1;
+      dropped_.store(dropped, std::memory_order_relaxed);
+
+      static tracing::PerSecond drops(1);
+      tracing::warn(drops, "Step queue full, {} search steps dropped so far",
+                    dropped);
+    }
+  }
+
+  /// @brief The number of events dropped because the queue was full.
+  auto dropped() const -> uint64_t {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /// @brief The queue events are pushed onto.
+  StepQueue* queue_;
+
+  /// @brief The number of events dropped because the queue was full.
+  std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace graph
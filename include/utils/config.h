@@ -14,7 +14,7 @@ namespace config {
 // ----------------------------------------
 
 /// @brief The time step for the simulation
-float dt;
+inline float dt;
 
 /// @brief Whether or not to run in debug mode
 static bool DEBUG_MODE = true;
@@ -32,9 +32,11 @@ const int DEBUG_WINDOW_WIDTH = 1920;
 const int DEBUG_WINDOW_HEIGHT = 1080;
 
 /// @brief The width of the window
-auto WINDOW_WIDTH = DEBUG_MODE ? DEBUG_WINDOW_WIDTH : PROD_WINDOW_WIDTH;
+inline auto WINDOW_WIDTH =
+    DEBUG_MODE ? DEBUG_WINDOW_WIDTH : PROD_WINDOW_WIDTH;
 /// @brief The height of the window
-auto WINDOW_HEIGHT = DEBUG_MODE ? DEBUG_WINDOW_HEIGHT : PROD_WINDOW_HEIGHT;
+inline auto WINDOW_HEIGHT =
+    DEBUG_MODE ? DEBUG_WINDOW_HEIGHT : PROD_WINDOW_HEIGHT;
 
 /// @brief The aspect ratio of the window
 const float ASPECT_RATIO = 4 / 3;
@@ -53,4 +55,108 @@ static int MAP_WIDTH = 100;
 /// @brief The height of the map (in tiles)
 static int MAP_HEIGHT = 100;
 
+// Graph
+
+/// @brief The number of nodes in the generated graph (besides source/target)
+const int NUM_NODES = 48;
+/// @brief The number of nearest neighbours each generated node connects to
+const int NUM_NEIGHBOURS = 3;
+
+/// @brief The on-screen size of a node (in pixels)
+const float NODE_SIZE = 32.0f;
+/// @brief The number of graph versions kept for undo/redo
+const size_t GRAPH_HISTORY_DEPTH = 256;
+/// @brief The side of the square tiles all-pairs shortest paths work on
+constexpr size_t APSP_TILE_SIZE = 64;
+/// @brief BFS switches to bottom-up steps once the frontier's edges exceed
+/// the unexplored edges divided by this
+const size_t BFS_ALPHA = 14;
+/// @brief BFS switches back to top-down steps once the frontier holds fewer
+/// than the nodes divided by this
+const size_t BFS_BETA = 24;
+
+// Assets
+
+/// @brief The width and height of the shared texture atlas (in pixels)
+const unsigned ATLAS_SIZE = 2048;
+/// @brief Images up to this size (in pixels) are packed into the atlas
+const unsigned ATLAS_MAX_ENTRY_SIZE = 256;
+/// @brief The gap left between images in the atlas (avoids bleeding)
+const unsigned ATLAS_PADDING = 1;
+
+/// @brief The (monospace) font overlays are labelled with
+const string FONT_PATH = "assets/SourceCodePro-Regular.ttf";
+
+// Profiler
+
+/// @brief The number of frames of timing history kept per phase
+constexpr size_t PROFILER_HISTORY = 512;
+/// @brief The height of the profiler's frame-time graph (in pixels)
+const float PROFILER_GRAPH_HEIGHT = 120.0f;
+/// @brief The frame time at the top of the profiler's graph (in microseconds)
+const float PROFILER_GRAPH_RANGE_US = 50000.0f;
+/// @brief Where the profiler's CSV dump is written
+const string PROFILE_CSV_PATH = "profile.csv";
+/// @brief Where the profiler's JSON dump is written
+const string PROFILE_JSON_PATH = "profile.json";
+
+// Search replay
+
+/// @brief The default replay speed (in search steps per second)
+const float REPLAY_SPEED = 30.0f;
+/// @brief The slowest replay speed (in search steps per second)
+const float MIN_REPLAY_SPEED = 0.5f;
+/// @brief The fastest replay speed (in search steps per second)
+const float MAX_REPLAY_SPEED = 100000.0f;
+/// @brief The capacity of the queue search steps are recorded into
+const size_t REPLAY_QUEUE_CAPACITY = 1 << 16;
+
+// Frame export
+
+/// @brief The maximum number of frames waiting to be encoded
+const size_t EXPORT_QUEUE_DEPTH = 32;
+/// @brief The size of the write buffer for raw frame output (in bytes)
+const size_t EXPORT_WRITE_BUFFER_SIZE = 8 << 20;
+
+// Logging
+
+/// @brief The number of log messages that can wait for the writer thread
+const size_t LOG_QUEUE_CAPACITY = 1 << 14;
+/// @brief The maximum number of log lines written (and flushed) at once
+const size_t LOG_BATCH_SIZE = 512;
+/// @brief How long the log writer sleeps when idle (in microseconds)
+const int LOG_FLUSH_INTERVAL_US = 2000;
+/// @brief The maximum number of mouse events logged per second
+const uint64_t MOUSE_LOG_RATE = 5;
+/// @brief Per-object lifecycle traces (e.g. node destruction): the first
+/// `LIFECYCLE_LOG_FIRST` are logged, then every `LIFECYCLE_LOG_EVERY`-th
+const uint64_t LIFECYCLE_LOG_FIRST = 16;
+const uint64_t LIFECYCLE_LOG_EVERY = 1000;
+/// @brief The size of a log file's write buffer (in bytes)
+const size_t LOG_FILE_BUFFER_SIZE = 4 << 20;
+/// @brief The size a log file is rotated at (in bytes)
+const size_t LOG_FILE_MAX_BYTES = 256 << 20;
+/// @brief The age a log file is rotated at (in seconds, 0 to never rotate by
+/// age)
+const int64_t LOG_FILE_MAX_AGE_S = 0;
+/// @brief The number of rotated log files kept (`log.1` ... `log.N`)
+const size_t LOG_FILE_MAX_FILES = 8;
+/// @brief How much a memory-mapped log file grows at a time (in bytes, a
+/// multiple of the page size)
+const size_t LOG_MMAP_CHUNK_SIZE = 64 << 20;
+
+// Spans
+
+/// @brief The number of spans each thread can record
+constexpr size_t SPAN_BUFFER_CAPACITY = 1 << 16;
+/// @brief Where recorded spans are written (Chrome Trace Event format)
+const string TRACE_JSON_PATH = "trace.json";
+
+// Metrics
+
+/// @brief Prepended to every metric name in Prometheus output
+const string METRICS_PREFIX = "ficiel_";
+/// @brief Where metrics are written (Prometheus text format)
+const string METRICS_PATH = "metrics.prom";
+
 }  // namespace config
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/// @brief Data structures used throughout the codebase
+namespace data_structures {
+
+/// @brief Safe memory reclamation for lock-free readers.
+namespace reclamation {
+
+/// @brief Epoch-based reclamation: lets writers free memory that lock-free
+/// readers might still be looking at, once no reader can be anymore.
+///
+/// Readers `pin()` the domain for as long as they hold pointers to shared
+/// objects; pinning is a couple of atomic operations on a record owned by
+/// the calling thread, so readers never contend with each other or with
+/// writers. Writers unlink an object (e.g. swap in a new version) and then
+/// `retire()` it instead of deleting it. `collect()` advances the global
+/// epoch once every pinned thread has caught up with it, and frees the
+/// objects retired two or more epochs ago: by then, every reader that could
+/// have seen them has unpinned.
+///
+/// Each thread claims a record in every domain it pins, on its first `pin()`,
+/// and hands it back when it exits.
+class EpochDomain {
+    struct Record;
+
+   public:
+    /// @brief The epoch announced by threads that aren't pinned.
+    static constexpr uint64_t kInactive = UINT64_MAX;
+
+    /// @brief Keeps the calling thread pinned while alive. Guards nest.
+    class Guard {
+       public:
+        Guard(Guard&& other) noexcept
+            : record_(std::exchange(other.record_, nullptr)) {}
+        Guard(const Guard&) = delete;
+        auto operator=(const Guard&) -> Guard& = delete;
+        auto operator=(Guard&&) -> Guard& = delete;
+
+        ~Guard() {
+            if (record_ != nullptr && --record_->depth == 0) {
+                record_->epoch.store(kInactive, std::memory_order_release);
+            }
+        }
+
+       private:
+        friend class EpochDomain;
+        explicit Guard(Record* record) : record_(record) {}
+
+        Record* record_;
+    };
+
+    EpochDomain() : id_(next_id_.fetch_add(1, std::memory_order_relaxed)) {}
+    EpochDomain(const EpochDomain&) = delete;
+    auto operator=(const EpochDomain&) -> EpochDomain& = delete;
+
+    /// @brief Frees everything still retired. No thread may be pinned (or
+    /// pin again) by then.
+    ~EpochDomain() {
+        for (auto& retired : retired_) retired.deleter(retired.object);
+    }
+
+    /// @brief Pins the calling thread: objects retired from now on won't be
+    /// freed until the returned guard is destroyed.
+    auto pin() -> Guard {
+        auto record = local_record();
+        if (record->depth++ == 0) {
+            // Announce the current epoch, retrying if it moved meanwhile (so
+            // a collector can't have missed the announcement). The fence
+            // orders the announcement before the re-read without writing
+            // to `epoch_`, whose cache line every reader shares.
+            auto epoch = epoch_.load(std::memory_order_relaxed);
+            while (true) {
+                record->epoch.store(epoch, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const auto current = epoch_.load(std::memory_order_relaxed);
+                if (current == epoch) break;
+                epoch = current;
+            }
+        }
+        return Guard(record);
+    }
+
+    /// @brief Frees `object` with `deleter` once no pinned thread can still
+    /// be using it. The object must already be unreachable for new readers.
+    auto retire(void* object, void (*deleter)(void*)) -> void {
+        std::lock_guard lock(*mutex_);
+        retired_.push_back(
+            {object, deleter, epoch_.load(std::memory_order_seq_cst)});
+    }
+
+    /// @brief Retires an object allocated with `new`.
+    template <typename T>
+    auto retire(T* object) -> void {
+        retire(const_cast<void*>(static_cast<const void*>(object)),
+               [](void* object) { delete static_cast<T*>(object); });
+    }
+
+    /// @brief Advances the epoch if every pinned thread has caught up with
+    /// it, and frees the objects that became safe to free.
+    /// @return The number of objects freed.
+    auto collect() -> size_t {
+        std::vector<Retired> freeable;
+        {
+            std::lock_guard lock(*mutex_);
+            auto epoch = epoch_.load(std::memory_order_seq_cst);
+            if (all_caught_up(epoch) &&
+                epoch_.compare_exchange_strong(epoch, epoch + 1,
+                                               std::memory_order_seq_cst)) {
+                epoch++;
+            }
+            auto kept = retired_.begin();
+            for (auto& retired : retired_) {
+                if (retired.epoch + 2 <= epoch) {
+                    freeable.push_back(retired);
+                } else {
+                    *kept++ = retired;
+                }
+            }
+            retired_.erase(kept, retired_.end());
+        }
+        for (auto& retired : freeable) retired.deleter(retired.object);
+        return freeable.size();
+    }
+
+    /// @brief The number of objects retired but not freed yet.
+    auto pending() const -> size_t {
+        std::lock_guard lock(*mutex_);
+        return retired_.size();
+    }
+
+    /// @brief The current global epoch.
+    auto epoch() const -> uint64_t {
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+   private:
+    /// @brief A thread's announcement (cache-line sized so that pinning
+    /// doesn't bounce other threads' lines).
+    struct alignas(64) Record {
+        /// @brief The epoch the thread is pinned in (`kInactive` if none).
+        std::atomic<uint64_t> epoch{kInactive};
+        /// @brief Whether a live thread owns the record (guarded by
+        /// `owner_mutex`).
+        bool claimed = true;
+        /// @brief The domain's mutex.
+        std::shared_ptr<std::mutex> owner_mutex;
+        /// @brief The number of live guards (owning thread only).
+        uint32_t depth = 0;
+    };
+
+    struct Retired {
+        void* object;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    /// @brief A thread's records, one per domain it pinned. Records are
+    /// shared with their domain, so either can go away first.
+    struct LocalRecords {
+        struct Entry {
+            uint64_t domain;
+            std::shared_ptr<Record> record;
+        };
+        std::vector<Entry> entries;
+
+        ~LocalRecords() {
+            for (auto& entry : entries) release(entry);
+        }
+
+        auto release(Entry& entry) -> void {
+            // The mutex outlives the domain for as long as the record does
+            std::lock_guard lock(*entry.record->owner_mutex);
+            entry.record->claimed = false;
+        }
+    };
+
+    auto local_record() -> Record* {
+        thread_local LocalRecords local;
+        for (auto& entry : local.entries) {
+            if (entry.domain == id_) return entry.record.get();
+        }
+        // Forget the records of domains that have been destroyed
+        std::erase_if(local.entries, [](const auto& entry) {
+            return entry.record.use_count() == 1;
+        });
+        local.entries.push_back({id_, claim()});
+        return local.entries.back().record.get();
+    }
+
+    /// @brief Reuses a record left behind by an exited thread, or adds one.
+    auto claim() -> std::shared_ptr<Record> {
+        std::lock_guard lock(*mutex_);
+        for (auto& record : records_) {
+            if (!record->claimed) {
+                record->claimed = true;
+                return record;
+            }
+        }
+        auto record = std::make_shared<Record>();
+        record->owner_mutex = mutex_;
+        records_.push_back(record);
+        return record;
+    }
+
+    /// @brief Whether every pinned thread announced `epoch` (with `mutex_`
+    /// held).
+    auto all_caught_up(uint64_t epoch) const -> bool {
+        for (const auto& record : records_) {
+            const auto announced =
+                record->epoch.load(std::memory_order_seq_cst);
+            if (announced != kInactive && announced != epoch) return false;
+        }
+        return true;
+    }
+
+    static inline std::atomic<uint64_t> next_id_{0};
+
+    /// @brief Distinguishes domains in threads' record lists (addresses may
+    /// be reused).
+    const uint64_t id_;
+    std::atomic<uint64_t> epoch_{0};
+    /// @brief Guards `records_`, `retired_` and the records' `claimed` flags,
+    /// and serializes collectors. Shared with the records.
+    std::shared_ptr<std::mutex> mutex_ = std::make_shared<std::mutex>();
+    std::vector<std::shared_ptr<Record>> records_;
+    std::vector<Retired> retired_;
+};
+
+/// @brief The process-wide reclamation domain.
+inline auto epochs() -> EpochDomain& {
+    static EpochDomain domain;
+    return domain;
+}
+
+}  // namespace reclamation
+
+}  // namespace data_structures
@@ -0,0 +1,435 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// @brief Data structures used throughout the codebase
+namespace data_structures {
+
+/// @brief General-purpose containers.
+namespace containers {
+
+/// @brief The state of a slot of a `FlatHashTable`: empty, deleted (a
+/// tombstone), or full, in which case it holds the low 7 bits of the key's
+/// hash (so most mismatching keys are rejected without comparing them).
+using Control = int8_t;
+static constexpr Control kEmpty = -128;
+static constexpr Control kDeleted = -2;
+
+/// @brief The number of control bytes probed at once.
+static constexpr size_t kGroupWidth = 16;
+
+/// @brief A group of `kGroupWidth` control bytes, matched against a hash
+/// with one SSE2 compare (or a portable loop where SSE2 is unavailable).
+/// Matches are returned as bit masks, bit `i` standing for slot `i`.
+class ControlGroup {
+   public:
+    explicit ControlGroup(const Control* controls) {
+#if defined(__SSE2__)
+        controls_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(controls));
+#else
+        std::memcpy(controls_, controls, kGroupWidth);
+#endif
+    }
+
+    /// @brief The full slots holding the given 7 hash bits.
+    auto match(Control hash) const -> uint32_t {
+#if defined(__SSE2__)
+        return movemask(_mm_cmpeq_epi8(controls_, _mm_set1_epi8(hash)));
+#else
+        return match_if([&](Control c) { return c == hash; });
+#endif
+    }
+
+    /// @brief The empty slots (never used since the table was built).
+    auto match_empty() const -> uint32_t {
+#if defined(__SSE2__)
+        return movemask(_mm_cmpeq_epi8(controls_, _mm_set1_epi8(kEmpty)));
+#else
+        return match_if([](Control c) { return c == kEmpty; });
+#endif
+    }
+
+    /// @brief The empty or deleted slots (the ones a key can be stored in).
+    auto match_free() const -> uint32_t {
+#if defined(__SSE2__)
+        // Both have their sign bit set, unlike full slots
+        return movemask(controls_);
+#else
+        return match_if([](Control c) { return c < 0; });
+#endif
+    }
+
+   private:
+#if defined(__SSE2__)
+    static auto movemask(__m128i mask) -> uint32_t {
+        return static_cast<uint32_t>(_mm_movemask_epi8(mask));
+    }
+
+    __m128i controls_;
+#else
+    template <typename Predicate>
+    auto match_if(Predicate predicate) const -> uint32_t {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; i++) {
+            if (predicate(controls_[i])) mask |= uint32_t{1} << i;
+        }
+        return mask;
+    }
+
+    Control controls_[kGroupWidth];
+#endif
+};
+
+/// @brief An open-addressing hash table in the style of Abseil's Swiss
+/// tables, shared by `FlatHashMap` and `FlatHashSet`.
+///
+/// Slots are stored in one flat array next to an array of one-byte control
+/// words. A lookup hashes the key once, then probes groups of `kGroupWidth`
+/// control bytes for the hash's low 7 bits, so it usually compares a single
+/// key and touches one or two cache lines. The table grows (doubling) at a
+/// load factor of 7/8; erased slots become tombstones until the next rehash.
+/// Pointers and iterators are invalidated by any insertion.
+///
+/// @tparam Key The key type
+/// @tparam Slot The stored type (the key, or a key/value pair)
+/// @tparam KeyOf Extracts the key from a slot
+/// @tparam Hash Hashes keys (mixed afterwards, so `std::hash` of integers
+///              and pointers works well)
+/// @tparam Eq Compares keys
+template <typename Key, typename Slot, typename KeyOf, typename Hash,
+          typename Eq>
+class FlatHashTable {
+   public:
+    template <bool Const>
+    class Iterator {
+        using Table = std::conditional_t<Const, const FlatHashTable,
+                                         FlatHashTable>;
+        using Reference = std::conditional_t<Const, const Slot&, Slot&>;
+
+       public:
+        Iterator(Table* table, size_t index) : table_(table), index_(index) {
+            skip_free();
+        }
+
+        auto operator*() const -> Reference { return table_->slots_[index_]; }
+        auto operator->() const { return &**this; }
+
+        auto operator++() -> Iterator& {
+            index_++;
+            skip_free();
+            return *this;
+        }
+
+        friend auto operator==(const Iterator& a, const Iterator& b) -> bool {
+            return a.index_ == b.index_;
+        }
+
+       private:
+        auto skip_free() -> void {
+            while (index_ < table_->capacity_ &&
+                   table_->controls_[index_] < 0) {
+                index_++;
+            }
+        }
+
+        Table* table_;
+        size_t index_;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashTable() = default;
+
+    FlatHashTable(const FlatHashTable& other) {
+        reserve(other.size_);
+        for (const auto& slot : other) emplace_slot(slot);
+    }
+
+    FlatHashTable(FlatHashTable&& other) noexcept { swap(other); }
+
+    auto operator=(FlatHashTable other) -> FlatHashTable& {
+        swap(other);
+        return *this;
+    }
+
+    ~FlatHashTable() { destroy(); }
+
+    auto size() const -> size_t { return size_; }
+    auto empty() const -> bool { return size_ == 0; }
+    auto capacity() const -> size_t { return capacity_; }
+
+    auto begin() -> iterator { return iterator(this, 0); }
+    auto end() -> iterator { return iterator(this, capacity_); }
+    auto begin() const -> const_iterator { return const_iterator(this, 0); }
+    auto end() const -> const_iterator {
+        return const_iterator(this, capacity_);
+    }
+
+    auto find(const Key& key) -> iterator {
+        return iterator(this, find_index(key));
+    }
+    auto find(const Key& key) const -> const_iterator {
+        return const_iterator(this, find_index(key));
+    }
+
+    auto contains(const Key& key) const -> bool {
+        return find_index(key) != capacity_;
+    }
+
+    /// @brief Removes a key.
+    /// @return Whether the key was present.
+    auto erase(const Key& key) -> bool {
+        const auto index = find_index(key);
+        if (index == capacity_) return false;
+        std::destroy_at(&slots_[index]);
+        controls_[index] = kDeleted;
+        size_--;
+        return true;
+    }
+
+    /// @brief Removes every element (keeping the capacity).
+    auto clear() -> void {
+        for (size_t i = 0; i < capacity_; i++) {
+            if (controls_[i] >= 0) std::destroy_at(&slots_[i]);
+            controls_[i] = kEmpty;
+        }
+        size_ = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    /// @brief Makes room for `count` elements without rehashing.
+    auto reserve(size_t count) -> void {
+        if (count > max_load(capacity_)) rehash(capacity_for(count));
+    }
+
+    void swap(FlatHashTable& other) noexcept {
+        std::swap(controls_, other.controls_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(growth_left_, other.growth_left_);
+    }
+
+   protected:
+    /// @brief Finds a key's slot, or constructs one from `args` if absent.
+    /// @return The slot and whether it was constructed.
+    template <typename... Args>
+    auto find_or_emplace(const Key& key, Args&&... args)
+        -> std::pair<iterator, bool> {
+        const auto hash = hash_of(key);
+        if (auto index = find_index(key, hash); index != capacity_) {
+            return {iterator(this, index), false};
+        }
+        const auto index = emplace_at(hash, std::forward<Args>(args)...);
+        return {iterator(this, index), true};
+    }
+
+   private:
+    /// @brief Mixes the user hash so that its low bits (the control byte)
+    /// and high bits (the probe start) are both well distributed.
+    static auto hash_of(const Key& key) -> size_t {
+        auto hash = static_cast<uint64_t>(Hash{}(key));
+        hash *= 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+
+    static auto control_of(size_t hash) -> Control {
+        return static_cast<Control>(hash & 0x7F);
+    }
+
+    /// @brief The number of elements a capacity holds before growing.
+    static auto max_load(size_t capacity) -> size_t {
+        return capacity - capacity / 8;
+    }
+
+    /// @brief The smallest capacity (a power of two, at least one group)
+    /// holding `count` elements.
+    static auto capacity_for(size_t count) -> size_t {
+        size_t capacity = kGroupWidth;
+        while (max_load(capacity) < count) capacity *= 2;
+        return capacity;
+    }
+
+    /// @brief Calls `visit(group_start)` for each group on a hash's probe
+    /// sequence until it returns `true`. Quadratic (triangular) probing over
+    /// a power-of-two number of groups visits every group.
+    template <typename Visit>
+    auto probe(size_t hash, Visit&& visit) const -> void {
+        const auto groups_mask = capacity_ / kGroupWidth - 1;
+        auto group = (hash >> 7) & groups_mask;
+        for (size_t step = 1;; step++) {
+            if (visit(group * kGroupWidth)) return;
+            group = (group + step) & groups_mask;
+        }
+    }
+
+    auto find_index(const Key& key) const -> size_t {
+        return find_index(key, hash_of(key));
+    }
+
+    /// @brief The index of a key's slot (`capacity_` if absent).
+    auto find_index(const Key& key, size_t hash) const -> size_t {
+        if (size_ == 0) return capacity_;
+        auto found = capacity_;
+        probe(hash, [&](size_t start) {
+            const ControlGroup group(&controls_[start]);
+            for (auto mask = group.match(control_of(hash)); mask != 0;
+                 mask &= mask - 1) {
+                const auto index = start + std::countr_zero(mask);
+                if (Eq{}(KeyOf{}(slots_[index]), key)) {
+                    found = index;
+                    return true;
+                }
+            }
+            // An empty slot ends the probe sequence: the key would have
+            // been stored there
+            return group.match_empty() != 0;
+        });
+        return found;
+    }
+
+    /// @brief Constructs a slot for a key known to be absent.
+    template <typename... Args>
+    auto emplace_at(size_t hash, Args&&... args) -> size_t {
+        if (growth_left_ == 0) {
+            // Rehashing in place is enough if most of the load is tombstones
+            const auto grow = size_ + 1 > max_load(capacity_) / 2;
+            rehash(capacity_ == 0 ? kGroupWidth
+                   : grow         ? capacity_ * 2
+                                  : capacity_);
+        }
+        size_t index = 0;
+        probe(hash, [&](size_t start) {
+            const auto mask = ControlGroup(&controls_[start]).match_free();
+            if (mask == 0) return false;
+            index = start + std::countr_zero(mask);
+            return true;
+        });
+        if (controls_[index] == kEmpty) growth_left_--;
+        controls_[index] = control_of(hash);
+        new (&slots_[index]) Slot(std::forward<Args>(args)...);
+        size_++;
+        return index;
+    }
+
+    auto emplace_slot(const Slot& slot) -> void {
+        emplace_at(hash_of(KeyOf{}(slot)), slot);
+    }
+
+    /// @brief Moves every element into a table of the given capacity.
+    auto rehash(size_t capacity) -> void {
+        FlatHashTable table;
+        table.controls_ = new Control[capacity];
+        std::memset(table.controls_, static_cast<uint8_t>(kEmpty), capacity);
+        table.slots_ = static_cast<Slot*>(::operator new(
+            capacity * sizeof(Slot), std::align_val_t{alignof(Slot)}));
+        table.capacity_ = capacity;
+        table.growth_left_ = max_load(capacity);
+
+        for (size_t i = 0; i < capacity_; i++) {
+            if (controls_[i] < 0) continue;
+            table.emplace_at(hash_of(KeyOf{}(slots_[i])), std::move(slots_[i]));
+        }
+        swap(table);
+    }
+
+    /// @brief Destroys the elements and frees the arrays.
+    auto destroy() -> void {
+        if (capacity_ == 0) return;
+        for (size_t i = 0; i < capacity_; i++) {
+            if (controls_[i] >= 0) std::destroy_at(&slots_[i]);
+        }
+        delete[] controls_;
+        ::operator delete(slots_, std::align_val_t{alignof(Slot)});
+    }
+
+    /// @brief The control byte of each slot.
+    Control* controls_ = nullptr;
+    /// @brief The slots (only full ones are constructed).
+    Slot* slots_ = nullptr;
+    /// @brief The number of slots (0, or a power of two >= `kGroupWidth`).
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    /// @brief The number of empty slots that can still be filled before the
+    /// table has to grow.
+    size_t growth_left_ = 0;
+};
+
+/// @brief Extracts the key of a map entry.
+struct PairKey {
+    template <typename Pair>
+    auto operator()(const Pair& pair) const -> const auto& {
+        return pair.first;
+    }
+};
+
+/// @brief Extracts the key of a set entry (the entry itself).
+struct IdentityKey {
+    template <typename Key>
+    auto operator()(const Key& key) const -> const Key& {
+        return key;
+    }
+};
+
+/// @brief A hash map storing its entries inline in a `FlatHashTable` (a
+/// replacement for `std::unordered_map` that doesn't allocate per entry).
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename Eq = std::equal_to<Key>>
+class FlatHashMap : public FlatHashTable<Key, std::pair<Key, Value>, PairKey,
+                                         Hash, Eq> {
+    using Table =
+        FlatHashTable<Key, std::pair<Key, Value>, PairKey, Hash, Eq>;
+
+   public:
+    using iterator = typename Table::iterator;
+
+    /// @brief Inserts an entry unless the key is already present.
+    /// @return The key's entry and whether it was inserted.
+    auto insert(const Key& key, Value value) -> std::pair<iterator, bool> {
+        return this->find_or_emplace(key, key, std::move(value));
+    }
+
+    /// @brief Inserts an entry with a value constructed from `args`, unless
+    /// the key is already present.
+    template <typename... Args>
+    auto try_emplace(const Key& key, Args&&... args)
+        -> std::pair<iterator, bool> {
+        return this->find_or_emplace(key, std::piecewise_construct,
+                                     std::forward_as_tuple(key),
+                                     std::forward_as_tuple(
+                                         std::forward<Args>(args)...));
+    }
+
+    /// @brief The value of a key (default-constructed if absent).
+    auto operator[](const Key& key) -> Value& {
+        return try_emplace(key).first->second;
+    }
+};
+
+/// @brief A hash set storing its keys inline in a `FlatHashTable`.
+template <typename Key, typename Hash = std::hash<Key>,
+          typename Eq = std::equal_to<Key>>
+class FlatHashSet : public FlatHashTable<Key, Key, IdentityKey, Hash, Eq> {
+   public:
+    /// @brief Inserts a key.
+    /// @return Whether the key was inserted (i.e. wasn't already present).
+    auto insert(const Key& key) -> bool {
+        return this->find_or_emplace(key, key).second;
+    }
+};
+
+}  // namespace containers
+
+}  // namespace data_structures
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Data structures used throughout the codebase
+namespace data_structures {
+
+namespace string {
+
+/// @brief An interned string: a 32-bit id that is equal for equal strings,
+/// so comparing and hashing symbols is O(1) regardless of their length.
+struct Symbol {
+    /// @brief The symbol's index in its `SymbolTable`.
+    uint32_t id = 0;
+
+    friend auto operator==(Symbol, Symbol) -> bool = default;
+    friend auto operator<=>(Symbol, Symbol) = default;
+};
+
+/// @brief Maps strings to `Symbol`s and back.
+///
+/// Interned characters are copied into large, never-freed blocks, so the
+/// views returned by `str()` stay valid for the table's lifetime. Looking up
+/// an existing string takes a shared lock; only new strings take the
+/// exclusive one. The empty string is always symbol 0.
+class SymbolTable {
+   public:
+    /// @brief The size of the blocks interned characters are copied into.
+    static constexpr size_t kBlockSize = 64 << 10;
+
+    SymbolTable() { intern(""); }
+
+    SymbolTable(const SymbolTable&) = delete;
+    auto operator=(const SymbolTable&) -> SymbolTable& = delete;
+
+    /// @brief The symbol of a string, interning it on first use.
+    auto intern(std::string_view str) -> Symbol {
+        {
+            std::shared_lock lock(mutex_);
+            if (auto it = ids_.find(str); it != ids_.end()) {
+                return Symbol{it->second};
+            }
+        }
+
+        std::unique_lock lock(mutex_);
+        // Another thread may have interned it in the meantime
+        if (auto it = ids_.find(str); it != ids_.end()) {
+            return Symbol{it->second};
+        }
+        const auto stored = store(str);
+        const auto id = static_cast<uint32_t>(strings_.size());
+        strings_.push_back(stored);
+        ids_.emplace(stored, id);
+        return Symbol{id};
+    }
+
+    /// @brief The symbol of a string, if it has been interned.
+    auto find(std::string_view str) const -> std::optional<Symbol> {
+        std::shared_lock lock(mutex_);
+        if (auto it = ids_.find(str); it != ids_.end()) {
+            return Symbol{it->second};
+        }
+        return std::nullopt;
+    }
+
+    /// @brief The string of a symbol (null-terminated).
+    auto str(Symbol symbol) const -> std::string_view {
+        std::shared_lock lock(mutex_);
+        return strings_[symbol.id];
+    }
+
+    /// @brief The number of interned strings.
+    auto size() const -> size_t {
+        std::shared_lock lock(mutex_);
+        return strings_.size();
+    }
+
+   private:
+    /// @brief Copies a string (and a terminator) into the current block.
+    auto store(std::string_view str) -> std::string_view {
+        const auto size = str.size() + 1;
+        if (size > kBlockSize) {
+            // Too large to share a block
+            blocks_.push_back(std::make_unique<char[]>(size));
+            return copy(blocks_.back().get(), str);
+        }
+        if (current_ == nullptr || used_ + size > kBlockSize) {
+            blocks_.push_back(std::make_unique<char[]>(kBlockSize));
+            current_ = blocks_.back().get();
+            used_ = 0;
+        }
+        auto* dest = current_ + used_;
+        used_ += size;
+        return copy(dest, str);
+    }
+
+    static auto copy(char* dest, std::string_view str) -> std::string_view {
+        std::memcpy(dest, str.data(), str.size());
+        dest[str.size()] = '\0';
+        return {dest, str.size()};
+    }
+
+    mutable std::shared_mutex mutex_;
+    /// @brief The id of every interned string (keys point into `blocks_`).
+    std::unordered_map<std::string_view, uint32_t> ids_;
+    /// @brief The interned strings, indexed by id.
+    std::vector<std::string_view> strings_;
+    /// @brief The interned characters.
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    /// @brief The block new strings are copied into.
+    char* current_ = nullptr;
+    /// @brief The number of bytes used in `current_`.
+    size_t used_ = 0;
+};
+
+/// @brief The process-wide symbol table.
+inline auto symbols() -> SymbolTable& {
+    static SymbolTable table;
+    return table;
+}
+
+/// @brief Interns a string in the process-wide symbol table.
+inline auto intern(std::string_view str) -> Symbol {
+    return symbols().intern(str);
+}
+
+}  // namespace string
+
+}  // namespace data_structures
+
+template <>
+struct std::hash<data_structures::string::Symbol> {
+    auto operator()(data_structures::string::Symbol symbol) const -> size_t {
+        return symbol.id;
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "utils/data_structures/spsc_queue.h"
+
+/// @brief Data structures used throughout the codebase
+namespace data_structures {
+
+/// @brief Bounded queues used to hand data between threads without locks.
+namespace queue {
+
+/// @brief A bounded, lock-free, **multi-producer / single-consumer** queue
+/// (Vyukov's bounded queue).
+///
+/// Any number of threads may call `try_push()` concurrently; exactly one
+/// thread may call `try_pop()`. Each slot carries a sequence number telling
+/// producers whether it is free and the consumer whether it has been filled,
+/// so a push is a single compare-and-swap on the shared tail plus a move into
+/// the claimed slot. Neither side ever blocks.
+///
+/// Unlike `SpscQueue`, elements may be non-trivial (e.g. strings): they are
+/// moved into and out of their slots.
+///
+/// @tparam T The element type (must be default-constructible and movable).
+template <typename T>
+class MpscQueue {
+   public:
+    /// @brief Creates a queue able to hold at least `capacity` elements. The
+    /// capacity is rounded up to the next power of two.
+    explicit MpscQueue(size_t capacity)
+        : mask_(round_up_pow2(capacity < 2 ? 2 : capacity) - 1),
+          slots_(std::make_unique<Slot[]>(mask_ + 1)) {
+        for (size_t i = 0; i <= mask_; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    auto operator=(const MpscQueue&) -> MpscQueue& = delete;
+
+    /// @brief Pushes an element (any thread).
+    /// @return `false` if the queue was full and the element was not pushed
+    /// (`value` is left untouched).
+    auto try_push(T&& value) -> bool {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            auto& slot = slots_[tail & mask_];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(sequence) -
+                              static_cast<intptr_t>(tail);
+            if (diff == 0) {
+                // The slot is free: claim it
+                if (tail_.compare_exchange_weak(tail, tail + 1,
+                                                std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The consumer hasn't freed the slot yet: the queue is full
+                return false;
+            } else {
+                // Another producer claimed the slot first
+                tail = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// @brief Pops an element (consumer only).
+    /// @return `false` if the queue was empty (or the oldest element is still
+    /// being written by its producer).
+    auto try_pop(T& out) -> bool {
+        auto& slot = slots_[head_ & mask_];
+        const auto sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != head_ + 1) return false;
+
+        out = std::move(slot.value);
+        slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        head_++;
+        popped_.store(head_, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief The number of elements pushed so far (claimed slots, some of
+    /// which may still be being written).
+    auto pushed() const -> size_t {
+        return tail_.load(std::memory_order_acquire);
+    }
+
+    /// @brief The number of elements popped so far.
+    auto popped() const -> size_t {
+        return popped_.load(std::memory_order_acquire);
+    }
+
+    /// @brief Whether the queue currently looks empty.
+    auto empty() const -> bool { return pushed() == popped(); }
+
+    /// @brief The maximum number of elements the queue can hold.
+    auto capacity() const -> size_t { return mask_ + 1; }
+
+   private:
+    /// @brief An element and the sequence number guarding it.
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static auto round_up_pow2(size_t n) -> size_t {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    /// @brief `capacity - 1`, used to wrap indices.
+    const size_t mask_;
+    /// @brief The element storage.
+    std::unique_ptr<Slot[]> slots_;
+
+    /// @brief The next slot to push (shared by all producers).
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+
+    /// @brief The next slot to pop (consumer only).
+    alignas(kCacheLineSize) size_t head_ = 0;
+    /// @brief `head_`, published for `popped()`.
+    std::atomic<size_t> popped_{0};
+};
+
+}  // namespace queue
+
+}  // namespace data_structures
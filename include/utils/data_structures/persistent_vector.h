@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/// @brief Data structures used throughout the codebase
+namespace data_structures {
+
+/// @brief General-purpose containers.
+namespace containers {
+
+/// @brief An immutable vector with structural sharing (a bit-partitioned
+/// trie, as in Clojure's persistent vectors).
+///
+/// Elements are stored in chunks of `kChunkSize`, under a tree of nodes with
+/// `kChunkSize` children each. Copying a vector is O(1) (the copies share
+/// every chunk), and `set()`/`push_back()` copy only the path from the root
+/// to the affected chunk, i.e. O(log n) with a base of 32, so older copies
+/// remain unchanged and valid. Nodes are never modified once shared, so
+/// copies can be read from any number of threads.
+///
+/// @tparam T The element type (copied when its chunk is)
+template <typename T>
+class PersistentVector {
+   public:
+    /// @brief The number of bits of an index consumed per tree level.
+    static constexpr uint32_t kChunkBits = 5;
+    /// @brief The number of elements per chunk (and children per node).
+    static constexpr size_t kChunkSize = size_t{1} << kChunkBits;
+
+    PersistentVector() = default;
+
+    auto size() const -> size_t { return size_; }
+    auto empty() const -> bool { return size_ == 0; }
+
+    /// @brief The element at an index (`index < size()`), in O(log n).
+    auto operator[](size_t index) const -> const T& {
+        const Node* node = root_.get();
+        for (auto shift = shift_; shift > 0; shift -= kChunkBits) {
+            node = node->children[(index >> shift) & kMask].get();
+        }
+        return node->values[index & kMask];
+    }
+
+    /// @brief Replaces the element at an index (`index < size()`), copying
+    /// the path to its chunk.
+    auto set(size_t index, T value) -> void {
+        root_ = set(*root_, shift_, index, std::move(value));
+    }
+
+    /// @brief Replaces the element at an index with `update(element)`.
+    template <typename Update>
+    auto update(size_t index, Update&& update) -> void {
+        auto value = (*this)[index];
+        update(value);
+        set(index, std::move(value));
+    }
+
+    /// @brief Appends an element, copying the path to the last chunk.
+    auto push_back(T value) -> void {
+        if (!root_) {
+            auto leaf = std::make_shared<Node>();
+            leaf->values.reserve(kChunkSize);
+            leaf->values.push_back(std::move(value));
+            root_ = std::move(leaf);
+            size_ = 1;
+            return;
+        }
+        // The tree is full: grow a level
+        if (size_ == capacity()) {
+            auto root = std::make_shared<Node>();
+            root->children.push_back(std::move(root_));
+            root_ = std::move(root);
+            shift_ += kChunkBits;
+        }
+        root_ = push(root_.get(), shift_, size_, std::move(value));
+        size_++;
+    }
+
+    /// @brief Calls `visit(element)` on every element in order, walking
+    /// each chunk once (cheaper than indexing every element).
+    template <typename Visit>
+    auto for_each(Visit&& visit) const -> void {
+        if (root_) for_each(*root_, shift_, visit);
+    }
+
+   private:
+    static constexpr size_t kMask = kChunkSize - 1;
+
+    /// @brief A chunk of elements (at the bottom level) or of children.
+    struct Node {
+        std::vector<std::shared_ptr<const Node>> children;
+        std::vector<T> values;
+    };
+
+    /// @brief The number of elements the tree holds without growing a level.
+    auto capacity() const -> size_t {
+        return size_t{1} << (shift_ + kChunkBits);
+    }
+
+    static auto set(const Node& node, uint32_t shift, size_t index, T value)
+        -> std::shared_ptr<const Node> {
+        auto copy = std::make_shared<Node>(node);
+        if (shift == 0) {
+            copy->values[index & kMask] = std::move(value);
+        } else {
+            auto& child = copy->children[(index >> shift) & kMask];
+            child = set(*child, shift - kChunkBits, index, std::move(value));
+        }
+        return copy;
+    }
+
+    /// @brief Copies the path to the slot of `index` (creating the missing
+    /// nodes) and stores `value` there.
+    static auto push(const Node* node, uint32_t shift, size_t index, T value)
+        -> std::shared_ptr<const Node> {
+        auto copy = node ? std::make_shared<Node>(*node)
+                         : std::make_shared<Node>();
+        if (shift == 0) {
+            copy->values.reserve(kChunkSize);
+            copy->values.push_back(std::move(value));
+            return copy;
+        }
+        const auto slot = (index >> shift) & kMask;
+        const Node* child = nullptr;
+        if (slot < copy->children.size()) {
+            child = copy->children[slot].get();
+        } else {
+            copy->children.emplace_back();
+        }
+        copy->children[slot] =
+            push(child, shift - kChunkBits, index, std::move(value));
+        return copy;
+    }
+
+    template <typename Visit>
+    static auto for_each(const Node& node, uint32_t shift, Visit& visit)
+        -> void {
+        if (shift == 0) {
+            for (const auto& value : node.values) visit(value);
+            return;
+        }
+        for (const auto& child : node.children) {
+            for_each(*child, shift - kChunkBits, visit);
+        }
+    }
+
+    std::shared_ptr<const Node> root_;
+    /// @brief The index bits consumed above the bottom level (0 while the
+    /// root is a single chunk).
+    uint32_t shift_ = 0;
+    size_t size_ = 0;
+};
+
+}  // namespace containers
+
+}  // namespace data_structures
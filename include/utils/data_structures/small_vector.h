@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+
+/// @brief Data structures used throughout the codebase
+namespace data_structures {
+
+/// @brief General-purpose containers.
+namespace containers {
+
+/// @brief A vector that stores up to `N` elements inline and only allocates
+/// once it grows past them (like `llvm::SmallVector`).
+///
+/// Meant for many small lists whose typical size is known (e.g. the edges
+/// of a node): a list that never exceeds `N` elements costs no allocation
+/// and lives next to its owner in memory. Iterators are plain pointers and
+/// are invalidated by any insertion, as with `std::vector`.
+///
+/// @tparam T The element type
+/// @tparam N The number of elements stored inline
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(N > 0, "use std::vector for lists that are never small");
+
+   public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+
+    SmallVector(std::initializer_list<T> values) {
+        reserve(values.size());
+        for (const auto& value : values) push_back(value);
+    }
+
+    SmallVector(const SmallVector& other) {
+        reserve(other.size_);
+        std::uninitialized_copy(other.begin(), other.end(), data_);
+        size_ = other.size_;
+    }
+
+    SmallVector(SmallVector&& other) noexcept { steal(other); }
+
+    auto operator=(const SmallVector& other) -> SmallVector& {
+        if (this != &other) {
+            clear();
+            reserve(other.size_);
+            std::uninitialized_copy(other.begin(), other.end(), data_);
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    auto operator=(SmallVector&& other) noexcept -> SmallVector& {
+        if (this != &other) {
+            clear();
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    // Accessors
+    auto size() const -> size_t { return size_; }
+    auto empty() const -> bool { return size_ == 0; }
+    auto capacity() const -> size_t { return capacity_; }
+
+    /// @brief Whether the elements are stored inline.
+    auto is_small() const -> bool { return data_ == inline_data(); }
+
+    auto data() -> T* { return data_; }
+    auto data() const -> const T* { return data_; }
+
+    auto operator[](size_t index) -> T& { return data_[index]; }
+    auto operator[](size_t index) const -> const T& { return data_[index]; }
+
+    auto front() -> T& { return data_[0]; }
+    auto front() const -> const T& { return data_[0]; }
+    auto back() -> T& { return data_[size_ - 1]; }
+    auto back() const -> const T& { return data_[size_ - 1]; }
+
+    auto begin() -> iterator { return data_; }
+    auto end() -> iterator { return data_ + size_; }
+    auto begin() const -> const_iterator { return data_; }
+    auto end() const -> const_iterator { return data_ + size_; }
+
+    // Modifiers
+
+    /// @brief Makes room for at least `capacity` elements.
+    auto reserve(size_t capacity) -> void {
+        if (capacity <= capacity_) return;
+        move_to(allocate(capacity), capacity);
+    }
+
+    template <typename... Args>
+    auto emplace_back(Args&&... args) -> T& {
+        if (size_ == capacity_) {
+            // Grow geometrically so repeated pushes stay amortized O(1). The
+            // arguments may refer to an element (`v.push_back(v[0])`), so
+            // the new element is built before the old ones are moved away
+            const auto capacity = size_t{capacity_} * 2;
+            auto* data = allocate(capacity);
+            new (data + size_) T(std::forward<Args>(args)...);
+            move_to(data, capacity);
+        } else {
+            new (data_ + size_) T(std::forward<Args>(args)...);
+        }
+        size_++;
+        return back();
+    }
+
+    auto push_back(const T& value) -> void { emplace_back(value); }
+    auto push_back(T&& value) -> void { emplace_back(std::move(value)); }
+
+    auto pop_back() -> void {
+        size_--;
+        std::destroy_at(data_ + size_);
+    }
+
+    /// @brief Removes the elements in `[first, last)`, keeping the order of
+    /// the others.
+    auto erase(const_iterator first, const_iterator last) -> iterator {
+        auto* dest = data_ + (first - data_);
+        auto* tail = data_ + (last - data_);
+        auto* new_end = std::move(tail, end(), dest);
+        std::destroy(new_end, end());
+        size_ = static_cast<uint32_t>(new_end - data_);
+        return dest;
+    }
+
+    auto erase(const_iterator position) -> iterator {
+        return erase(position, position + 1);
+    }
+
+    /// @brief Removes every element (keeping the capacity).
+    auto clear() -> void {
+        std::destroy(begin(), end());
+        size_ = 0;
+    }
+
+   private:
+    /// @brief Allocates (uninitialized) heap storage for `capacity` elements.
+    static auto allocate(size_t capacity) -> T* {
+        return static_cast<T*>(
+            ::operator new(capacity * sizeof(T), std::align_val_t{alignof(T)}));
+    }
+
+    /// @brief Moves the elements to `data` (heap storage for `capacity`
+    /// elements) and frees the current storage.
+    auto move_to(T* data, size_t capacity) -> void {
+        std::uninitialized_move(begin(), end(), data);
+        std::destroy(begin(), end());
+        release();
+        data_ = data;
+        capacity_ = static_cast<uint32_t>(capacity);
+    }
+
+    auto inline_data() -> T* { return reinterpret_cast<T*>(inline_); }
+    auto inline_data() const -> const T* {
+        return reinterpret_cast<const T*>(inline_);
+    }
+
+    /// @brief Takes over another vector's elements (this one must be empty
+    /// and small), leaving it empty and small.
+    auto steal(SmallVector& other) -> void {
+        if (other.is_small()) {
+            std::uninitialized_move(other.begin(), other.end(), data_);
+            size_ = other.size_;
+            other.clear();
+            return;
+        }
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        other.data_ = other.inline_data();
+        other.size_ = 0;
+        other.capacity_ = N;
+    }
+
+    /// @brief Frees the heap storage (if any) and goes back to the inline
+    /// storage. The elements must already be destroyed.
+    auto release() -> void {
+        if (!is_small()) {
+            ::operator delete(data_, std::align_val_t{alignof(T)});
+        }
+        data_ = inline_data();
+        capacity_ = N;
+    }
+
+    /// @brief The elements (`inline_` or a heap allocation).
+    T* data_ = inline_data();
+    uint32_t size_ = 0;
+    uint32_t capacity_ = N;
+    /// @brief The inline storage.
+    alignas(T) std::byte inline_[N * sizeof(T)];
+};
+
+}  // namespace containers
+
+}  // namespace data_structures
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+/// @brief Data structures used throughout the codebase
+namespace data_structures {
+
+/// @brief Bounded queues used to hand data between threads without locks.
+namespace queue {
+
+/// @brief The assumed size of a cache line. Producer and consumer indices are
+/// kept on separate lines so that the two threads never write to the same line.
+static constexpr size_t kCacheLineSize = 64;
+
+/// @brief A bounded, lock-free, **single-producer / single-consumer** ring
+/// buffer.
+///
+/// Exactly one thread may call `try_push()` and exactly one (other) thread may
+/// call `try_pop()` / `drain()`. Neither side ever blocks: a full queue makes
+/// `try_push()` return `false` and an empty queue makes `try_pop()` return
+/// `false`.
+///
+/// Each side keeps a cached copy of the other side's index, so in the common
+/// case a push or pop is a single relaxed load, a copy and a release store.
+///
+/// @tparam T The element type (must be trivially copyable so that slots can be
+///           overwritten without running destructors).
+template <typename T>
+class SpscQueue {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "SpscQueue elements must be trivially copyable");
+
+   public:
+    /// @brief Creates a queue able to hold at least `capacity` elements. The
+    /// capacity is rounded up to the next power of two.
+    explicit SpscQueue(size_t capacity)
+        : mask_(round_up_pow2(capacity < 2 ? 2 : capacity) - 1),
+          slots_(std::make_unique<T[]>(mask_ + 1)) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    auto operator=(const SpscQueue&) -> SpscQueue& = delete;
+
+    /// @brief Pushes an element (producer only).
+    /// @return `false` if the queue was full and the element was not pushed.
+    auto try_push(const T& value) -> bool {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Pops an element (consumer only).
+    /// @return `false` if the queue was empty.
+    auto try_pop(T& out) -> bool {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        out = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Pops up to `max` elements in one go, handing each to `sink`
+    /// (consumer only). Publishes the new head once for the whole batch.
+    /// @return The number of elements popped.
+    template <typename Sink>
+    auto drain(Sink&& sink, size_t max = SIZE_MAX) -> size_t {
+        const auto head = head_.load(std::memory_order_relaxed);
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        auto available = cached_tail_ - head;
+        auto count = available < max ? available : max;
+        for (size_t i = 0; i < count; i++) {
+            sink(slots_[(head + i) & mask_]);
+        }
+        if (count > 0) head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    /// @brief An approximation of the number of queued elements (exact when
+    /// called from either endpoint while the other is idle).
+    auto size_approx() const -> size_t {
+        return tail_.load(std::memory_order_acquire) -
+               head_.load(std::memory_order_acquire);
+    }
+
+    /// @brief Whether the queue currently looks empty.
+    auto empty() const -> bool { return size_approx() == 0; }
+
+    /// @brief The maximum number of elements the queue can hold.
+    auto capacity() const -> size_t { return mask_ + 1; }
+
+   private:
+    static auto round_up_pow2(size_t n) -> size_t {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    /// @brief `capacity - 1`, used to wrap indices.
+    const size_t mask_;
+    /// @brief The element storage.
+    std::unique_ptr<T[]> slots_;
+
+    /// @brief The next slot to pop (written by the consumer).
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+    /// @brief The consumer's last observed producer index.
+    size_t cached_tail_ = 0;
+
+    /// @brief The next slot to push (written by the producer).
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+    /// @brief The producer's last observed consumer index.
+    size_t cached_head_ = 0;
+};
+
+}  // namespace queue
+
+}  // namespace data_structures
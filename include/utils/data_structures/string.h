@@ -1,11 +1,16 @@
 #pragma once
 
-// #include <folly/FBString.h>
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 
-// #include "llvm/ADT/SmallString.h"
-
 /// @brief Data structures used throughout the codebase
 namespace data_structures {
 
@@ -14,8 +19,6 @@ namespace data_structures {
 /// for small strings.
 namespace string {
 
-// using llvm::SmallString; // TODO
-
 /// @brief The size of the small string optimization buffer
 /// @details This is the size of the buffer that is used for
 /// small string optimization. If the string is smaller than
@@ -23,88 +26,221 @@ namespace string {
 /// being allocated on the heap.
 static constexpr size_t kSmallStringSize = 32;
 
-/// @brief A newtype wrapper for `llvm::SmallString` that
-/// represents a string with a small size optimization.
-/// This is used as a stand-in replacement for `std::string`
-/// in the codebase.
-/// A **newtype** wrapper for `llvm::SmallString`
+/// @brief A string that stores up to `kSmallStringSize` characters inline
+/// (no heap allocation) and longer ones on the heap.
+///
+/// Used in place of `std::string` for short, frequently copied strings (node
+/// labels, asset paths, categories): libstdc++ and libc++ only keep 15 and
+/// 22 characters inline respectively. Always null-terminated.
 class String {
    public:
     // Constructors
-    String() = default;
-    // SmallString(const char* str) : data_(str) {}
-    // SmallString(const std::string& str) : data_(str) {}
-    // SmallString(std::string&& str) : data_(std::move(str)) {}
+    String() { inline_[0] = '\0'; }
+    String(const char* str) : String(std::string_view(str)) {}
+    String(const std::string& str) : String(std::string_view(str)) {}
+    explicit String(std::string_view str) {
+        inline_[0] = '\0';
+        assign(str);
+    }
 
-    // Conversion operators
-    // operator const std::string&() const { return data_; }
-    // operator std::string() const { return data_; }
-    // operator const llvm::SmallString<kSmallStringSize>&() const {
-    //     return data_;
-    // }
+    String(const String& other) : String(other.view()) {}
 
-    // operator llvm::SmallString<kSmallStringSize>() const { return data_; }
+    String(String&& other) noexcept { steal(other); }
 
-    // Comparison operators
-    bool operator==(const String& other) const { return data_ == other.data_; }
-    bool operator!=(const String& other) const { return data_ != other.data_; }
+    auto operator=(const String& other) -> String& {
+        if (this != &other) assign(other.view());
+        return *this;
+    }
+
+    auto operator=(String&& other) noexcept -> String& {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~String() { release(); }
+
+    /// @brief Create a new instance of String from a null-terminated string
+    static String from(const char* str) { return String(str); }
+
+    /// @brief Create a new instance of String from a given string
+    /// @param str The string to create a new instance of String from
+    /// @return A new instance of String
+    static String from(const std::string& str) { return String(str); }
+
+    static String from(std::string_view str) { return String(str); }
+
+    /// @brief Create a new instance of String from the first `size`
+    /// characters of a string (which need not be null-terminated)
+    static String from(const char* str, size_t size) {
+        return String(std::string_view(str, size));
+    }
+
+    /// @brief Create a new instance of String from (at most) the first
+    /// `size` characters of a string
+    static String from(const std::string& str, size_t size) {
+        return String(std::string_view(str).substr(0, size));
+    }
 
     // Accessors
-    const char* c_str() const { return data_.c_str(); }
+    auto data() const -> const char* { return small_ ? inline_ : heap_.data; }
+    auto data() -> char* { return small_ ? inline_ : heap_.data; }
+    auto c_str() const -> const char* { return data(); }
+    auto size() const -> size_t { return size_; }
+    auto length() const -> size_t { return size_; }
+    auto empty() const -> bool { return size_ == 0; }
+
+    /// @brief The longest string that can be stored (sizes are kept in 32
+    /// bits to keep the string small).
+    static constexpr auto max_size() -> size_t { return UINT32_MAX; }
+
+    /// @brief The number of characters that fit without reallocating.
+    auto capacity() const -> size_t {
+        return small_ ? kSmallStringSize : heap_.capacity;
+    }
+
+    /// @brief Whether the characters are stored inline.
+    auto is_small() const -> bool { return small_; }
+
+    auto view() const -> std::string_view { return {data(), size_}; }
+    operator std::string_view() const { return view(); }
+    auto str() const -> std::string { return std::string(view()); }
+
+    auto operator[](size_t index) const -> char { return data()[index]; }
+    auto operator[](size_t index) -> char& { return data()[index]; }
 
-    // static method to create a new instance of SmallString from a given string
-    // literal
-    static String from(const char* str) {
-        String string;
-        string.data_ = str;
-        return string;
+    auto begin() const -> const char* { return data(); }
+    auto end() const -> const char* { return data() + size_; }
+
+    // Modifiers
+
+    /// @brief Makes room for at least `capacity` characters.
+    auto reserve(size_t capacity) -> void {
+        if (capacity <= this->capacity()) return;
+        check_size(capacity);
+        auto* data = new char[capacity + 1];
+        std::memcpy(data, this->data(), size_ + 1);
+        release();
+        heap_.data = data;
+        heap_.capacity = capacity;
+        small_ = false;
     }
 
-    /// @brief Create a new instance of SmallString from a given string
-    /// @param str The string to create a new instance of SmallString from
-    /// @return A new instance of SmallString
-    static String from(const std::string& str) {
-        String string;
-        string.data_ = str;
-        return string;
+    auto append(std::string_view str) -> String& {
+        check_size(size_ + str.size());
+        if (size_ + str.size() > capacity()) {
+            // `str` may point into this string, whose storage is about to
+            // move: find it again by its offset afterwards
+            const auto* old = data();
+            const auto inside = std::less_equal<>{}(old, str.data()) &&
+                                std::less<>{}(str.data(), old + size_ + 1);
+            const auto offset = str.data() - old;
+            // Grow geometrically so repeated appends stay amortized O(1)
+            reserve(std::clamp(capacity() * 2, size_ + str.size(), max_size()));
+            if (inside) str = std::string_view(data() + offset, str.size());
+        }
+        // `str` may still point into this string, so copy before terminating
+        std::memmove(data() + size_, str.data(), str.size());
+        size_ += str.size();
+        data()[size_] = '\0';
+        return *this;
     }
 
-    static String from(std::string&& str) {
-        String string;
-        string.data_ = std::move(str);
-        return string;
+    auto operator+=(std::string_view str) -> String& { return append(str); }
+
+    auto push_back(char c) -> void { append(std::string_view(&c, 1)); }
+
+    /// @brief Empties the string (keeping its capacity).
+    auto clear() -> void {
+        size_ = 0;
+        data()[0] = '\0';
     }
 
-    static String from(const char* str, size_t size) {
-        String string;
-        string.data_ = str;
-        return string;
+    // Comparison operators
+    friend auto operator==(const String& a, const String& b) -> bool {
+        return a.view() == b.view();
+    }
+    friend auto operator==(const String& a, std::string_view b) -> bool {
+        return a.view() == b;
+    }
+    friend auto operator==(const String& a, const char* b) -> bool {
+        return a.view() == b;
+    }
+    friend auto operator<=>(const String& a, const String& b) {
+        return a.view() <=> b.view();
+    }
+    friend auto operator<=>(const String& a, std::string_view b) {
+        return a.view() <=> b;
+    }
+    friend auto operator<=>(const String& a, const char* b) {
+        return a.view() <=> std::string_view(b);
     }
 
-    static String from(std::string& str, size_t size) {
-        String string;
-        string.data_ = str;
-        return string;
+   private:
+    /// @brief Replaces the contents (reusing the current storage if it is
+    /// large enough).
+    auto assign(std::string_view str) -> void {
+        check_size(str.size());
+        size_ = 0;
+        if (str.size() > capacity()) reserve(str.size());
+        std::memmove(data(), str.data(), str.size());
+        size_ = str.size();
+        data()[size_] = '\0';
     }
 
-    static String from(std::string&& str, size_t size) {
-        String string;
-        string.data_ = std::move(str);
-        return string;
+    /// @brief Throws rather than let the size silently wrap around.
+    static auto check_size(size_t size) -> void {
+        if (size > max_size()) {
+            throw std::length_error("String: longer than max_size()");
+        }
     }
 
-    // size_t size() const { return data_.size(); }
-    // size_t length() const { return data_.length(); }
+    /// @brief Takes over another string's contents, leaving it empty.
+    auto steal(String& other) -> void {
+        size_ = other.size_;
+        small_ = other.small_;
+        if (small_) {
+            std::memcpy(inline_, other.inline_, size_ + 1);
+        } else {
+            heap_ = other.heap_;
+            other.small_ = true;
+        }
+        other.size_ = 0;
+        other.inline_[0] = '\0';
+    }
 
-    // from(&str) is a static method that returns a SmallString
-    // from a string
-    // static SmallString from(const std::string& str) { return
-    // SmallString(str); }
+    /// @brief Frees the heap storage (if any).
+    auto release() -> void {
+        if (!small_) delete[] heap_.data;
+        small_ = true;
+    }
 
-   private:
-    std::string data_;  // TODO: temp
-    // SmallString<kSmallStringSize> data_;
+    struct Heap {
+        char* data;
+        size_t capacity;
+    };
+
+    union {
+        /// @brief The characters (and terminator) of a small string.
+        char inline_[kSmallStringSize + 1];
+        /// @brief The storage of a large string.
+        Heap heap_;
+    };
+    /// @brief The number of characters (at most `max_size()`).
+    uint32_t size_ = 0;
+    /// @brief Whether the characters are stored in `inline_`.
+    bool small_ = true;
 };
+
 }  // namespace string
 
 }  // namespace data_structures
+
+template <>
+struct std::hash<data_structures::string::String> {
+    auto operator()(const data_structures::string::String& str) const {
+        return std::hash<std::string_view>{}(str.view());
+    }
+};
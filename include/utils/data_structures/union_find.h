@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+/// @brief Data structures used throughout the codebase
+namespace data_structures {
+
+/// @brief Disjoint sets.
+namespace sets {
+
+/// @brief A partition of `[0, size)` into disjoint sets (a disjoint-set
+/// forest), with union by rank and path compression: any sequence of `m`
+/// operations takes O(m α(n)), i.e. effectively constant time each.
+///
+/// Not thread-safe.
+class UnionFind {
+   public:
+    UnionFind() = default;
+
+    /// @brief Puts every element in a set of its own.
+    explicit UnionFind(size_t size)
+        : parents_(size), ranks_(size, 0), num_sets_(size) {
+        std::iota(parents_.begin(), parents_.end(), uint32_t{0});
+    }
+
+    /// @brief The number of elements.
+    auto size() const -> size_t { return parents_.size(); }
+
+    /// @brief The number of disjoint sets.
+    auto num_sets() const -> size_t { return num_sets_; }
+
+    /// @brief The representative of the set containing `element`. Every
+    /// element on the way is re-pointed at the representative.
+    auto find(uint32_t element) -> uint32_t {
+        auto root = element;
+        while (parents_[root] != root) root = parents_[root];
+        while (parents_[element] != root) {
+            element = std::exchange(parents_[element], root);
+        }
+        return root;
+    }
+
+    /// @brief Merges the sets containing `a` and `b`.
+    /// @return Whether they were different sets.
+    auto unite(uint32_t a, uint32_t b) -> bool {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        // The shallower tree goes under the deeper one
+        if (ranks_[a] < ranks_[b]) std::swap(a, b);
+        parents_[b] = a;
+        if (ranks_[a] == ranks_[b]) ranks_[a]++;
+        num_sets_--;
+        return true;
+    }
+
+    /// @brief Whether `a` and `b` are in the same set.
+    auto same(uint32_t a, uint32_t b) -> bool { return find(a) == find(b); }
+
+   private:
+    std::vector<uint32_t> parents_;
+    /// @brief An upper bound on the height of each root's tree (at most
+    /// log2(n), so a byte is plenty).
+    std::vector<uint8_t> ranks_;
+    size_t num_sets_ = 0;
+};
+
+/// @brief A union-find that any number of threads can use at once
+/// (lock-free, after Anderson and Woll).
+///
+/// Roots are linked with a compare-and-swap, always the larger index under
+/// the smaller one (instead of by rank, which can't be updated atomically
+/// along with the link), so links can't form a cycle and the representative
+/// of a set is its smallest element. `find()` halves paths as it goes; a
+/// halving step that loses a race is simply skipped.
+class ConcurrentUnionFind {
+   public:
+    /// @brief Puts every element in a set of its own.
+    explicit ConcurrentUnionFind(size_t size) : parents_(size) {
+        for (uint32_t i = 0; i < size; i++) {
+            parents_[i].store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief The number of elements.
+    auto size() const -> size_t { return parents_.size(); }
+
+    /// @brief The representative of the set containing `element` (the
+    /// smallest element of the set once no `unite()` is in flight).
+    auto find(uint32_t element) -> uint32_t {
+        for (;;) {
+            auto parent = parents_[element].load(std::memory_order_acquire);
+            if (parent == element) return element;
+            const auto grandparent =
+                parents_[parent].load(std::memory_order_acquire);
+            if (grandparent != parent) {
+                parents_[element].compare_exchange_weak(
+                    parent, grandparent, std::memory_order_acq_rel);
+            }
+            element = grandparent;
+        }
+    }
+
+    /// @brief Merges the sets containing `a` and `b`.
+    /// @return Whether they were different sets (exactly one of several
+    ///         concurrent calls merging the same sets returns true).
+    auto unite(uint32_t a, uint32_t b) -> bool {
+        for (;;) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return false;
+            if (a < b) std::swap(a, b);
+            // Fails if `a` stopped being a root meanwhile, then retry
+            auto expected = a;
+            if (parents_[a].compare_exchange_strong(
+                    expected, b, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+    }
+
+    /// @brief Whether `a` and `b` are in the same set.
+    auto same(uint32_t a, uint32_t b) -> bool {
+        for (;;) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return true;
+            // Only conclusive if `a` is still a root
+            if (parents_[a].load(std::memory_order_acquire) == a) {
+                return false;
+            }
+        }
+    }
+
+   private:
+    std::vector<std::atomic<uint32_t>> parents_;
+};
+
+}  // namespace sets
+
+}  // namespace data_structures
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+
+#include "utils/tracing.h"
+
+namespace tracing {
+
+/// @brief Decides which messages of a single call site are logged, so that
+/// high-frequency events can stay instrumented without flooding the output.
+///
+/// Samplers are meant to be `static` at their call site and are safe to share
+/// between threads:
+///
+/// ```cpp
+/// static tracing::EveryN mouse_moves(10);
+/// tracing::trace(mouse_moves, "Mouse moved to ({}, {})", x, y);
+/// ```
+template <typename T>
+concept LogSampler = requires(T& sampler) {
+  { sampler.sample() } -> std::same_as<bool>;
+};
+
+/// @brief Logs every `n`-th message (the first one included). One relaxed
+/// atomic increment per message.
+class EveryN {
+ public:
+  explicit EveryN(uint64_t n) : n_(std::max<uint64_t>(n, 1)) {}
+
+  /// @brief Whether the current message should be logged.
+  inline auto sample() -> bool {
+    return count_.fetch_add(1, std::memory_order_relaxed) % n_ == 0;
+  }
+
+ private:
+  const uint64_t n_;
+  std::atomic<uint64_t> count_{0};
+};
+
+/// @brief Logs the first `first` messages, then every `every`-th one. One
+/// relaxed atomic increment per message.
+class FirstNThenEvery {
+ public:
+  FirstNThenEvery(uint64_t first, uint64_t every)
+      : first_(first), every_(std::max<uint64_t>(every, 1)) {}
+
+  /// @brief Whether the current message should be logged.
+  inline auto sample() -> bool {
+    const auto count = count_.fetch_add(1, std::memory_order_relaxed);
+    return count < first_ || (count - first_) % every_ == 0;
+  }
+
+ private:
+  const uint64_t first_;
+  const uint64_t every_;
+  std::atomic<uint64_t> count_{0};
+};
+
+/// @brief Logs at most `rate` messages per second, allowing bursts of up to
+/// `rate` messages (a token bucket).
+///
+/// Implemented as a generic cell rate algorithm: the whole bucket is a single
+/// "theoretical arrival time", so a message costs a clock read and one
+/// compare-and-swap (none at all once the bucket is empty).
+class PerSecond {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit PerSecond(uint64_t rate)
+      : interval_ns_(1'000'000'000 / std::max<uint64_t>(rate, 1)),
+        burst_ns_(interval_ns_ * std::max<uint64_t>(rate, 1)) {}
+
+  /// @brief Whether the current message should be logged.
+  inline auto sample() -> bool {
+    return sample(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      Clock::now().time_since_epoch())
+                      .count());
+  }
+
+  /// @brief Whether a message logged at `now` (nanoseconds on `Clock`)
+  /// should be logged. Times must not go backwards.
+  inline auto sample(int64_t now) -> bool {
+    auto arrival = arrival_ns_.load(std::memory_order_relaxed);
+    while (true) {
+      const auto next = std::max(arrival, now) + interval_ns_;
+      // The bucket is empty: the message would arrive too far ahead
+      if (next - now > burst_ns_) return false;
+      if (arrival_ns_.compare_exchange_weak(arrival, next,
+                                            std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+  }
+
+ private:
+  /// @brief The time each token takes to refill.
+  const int64_t interval_ns_;
+  /// @brief How far ahead of the clock the arrival time may run (the bucket
+  /// size).
+  const int64_t burst_ns_;
+  /// @brief When the bucket will be full again.
+  std::atomic<int64_t> arrival_ns_{0};
+};
+
+/// @brief Format and log a message if its level is enabled and the sampler
+/// picks it. The level is checked first, so disabled levels never touch the
+/// sampler's state.
+/// @tparam level The log level
+/// @param sampler The call site's sampler
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <LogLevel level, LogSampler Sampler, typename... Args>
+inline void log_sampled(Sampler& sampler,
+                        fmt::format_string<Args...> format_str,
+                        Args&&... args) {
+  if constexpr (compiled_in(level)) {
+    if (level >= getLogLevel() && sampler.sample()) [[unlikely]] {
+      log_message(level, fmt::format(format_str, std::forward<Args>(args)...));
+    }
+  }
+}
+
+/// @brief Log a sampled trace message to the console
+/// @param sampler The call site's sampler (e.g. `EveryN`)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <LogSampler Sampler, typename... Args>
+inline auto trace(Sampler& sampler, fmt::format_string<Args...> format_str,
+                  Args&&... args) {
+  log_sampled<LVL_TRACE, Sampler, Args...>(sampler, format_str,
+                                           std::forward<Args>(args)...);
+}
+
+/// @brief Log a sampled debug message to the console
+/// @param sampler The call site's sampler (e.g. `EveryN`)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <LogSampler Sampler, typename... Args>
+inline auto debug(Sampler& sampler, fmt::format_string<Args...> format_str,
+                  Args&&... args) {
+  log_sampled<LVL_DEBUG, Sampler, Args...>(sampler, format_str,
+                                           std::forward<Args>(args)...);
+}
+
+/// @brief Log a sampled info message to the console
+/// @param sampler The call site's sampler (e.g. `EveryN`)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <LogSampler Sampler, typename... Args>
+inline auto info(Sampler& sampler, fmt::format_string<Args...> format_str,
+                 Args&&... args) {
+  log_sampled<LVL_INFO, Sampler, Args...>(sampler, format_str,
+                                          std::forward<Args>(args)...);
+}
+
+/// @brief Log a sampled warning message to the console
+/// @param sampler The call site's sampler (e.g. `EveryN`)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <LogSampler Sampler, typename... Args>
+inline auto warn(Sampler& sampler, fmt::format_string<Args...> format_str,
+                 Args&&... args) {
+  log_sampled<LVL_WARN, Sampler, Args...>(sampler, format_str,
+                                          std::forward<Args>(args)...);
+}
+
+/// @brief Log a sampled error message to the console
+/// @param sampler The call site's sampler (e.g. `EveryN`)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <LogSampler Sampler, typename... Args>
+inline auto error(Sampler& sampler, fmt::format_string<Args...> format_str,
+                  Args&&... args) {
+  log_sampled<LVL_ERROR, Sampler, Args...>(sampler, format_str,
+                                           std::forward<Args>(args)...);
+}
+
+}  // namespace tracing
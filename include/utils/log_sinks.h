@@ -0,0 +1,295 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "utils/config.h"
+#include "utils/tracing.h"
+
+using std::string;
+using std::string_view;
+
+namespace tracing {
+
+/// @brief How a `FileSink` writes and rotates its file.
+struct FileSinkOptions {
+  /// @brief The file to write. Rotated files are named `<path>.1` (the most
+  /// recent) to `<path>.<max_files>`.
+  string path;
+  /// @brief The size of the write buffer (in bytes). Lines are only written
+  /// to the file when the buffer is full or the sink is flushed.
+  size_t buffer_size = config::LOG_FILE_BUFFER_SIZE;
+  /// @brief The size the file is rotated at (in bytes, 0 to never rotate by
+  /// size).
+  size_t max_bytes = config::LOG_FILE_MAX_BYTES;
+  /// @brief The age the file is rotated at (in seconds, 0 to never rotate by
+  /// age).
+  int64_t max_age_s = config::LOG_FILE_MAX_AGE_S;
+  /// @brief The number of rotated files kept (older ones are deleted).
+  size_t max_files = config::LOG_FILE_MAX_FILES;
+  /// @brief Whether to append by copying into a memory mapping of the file
+  /// instead of through a write buffer (no system call per buffer, at the
+  /// cost of growing the file `config::LOG_MMAP_CHUNK_SIZE` at a time).
+  bool mmap = false;
+};
+
+/// @brief Writes uncolored, structured lines to a file:
+///
+/// ```
+/// 2026-10-19T12:34:56.123456Z INFO  0 Initializing ficiel
+/// ```
+///
+/// i.e. a UTC timestamp, the level, the thread (see `log_thread_id()`) and
+/// the message, separated by spaces (newlines in messages are escaped so
+/// every record is one line).
+///
+/// Lines are collected in a large buffer and written with a single system
+/// call when it fills up or the log writer catches up, and the file is
+/// rotated by size and/or age. Errors are reported on `stderr` (the sink
+/// can't log them itself) and disable the sink.
+class FileSink : public LogSink {
+ public:
+  explicit FileSink(FileSinkOptions options) : options_(std::move(options)) {
+    buffer_.reserve(options_.buffer_size);
+    open();
+  }
+
+  FileSink(const FileSink&) = delete;
+  auto operator=(const FileSink&) -> FileSink& = delete;
+
+  ~FileSink() override { close(); }
+
+  /// @brief Whether the file is open (and lines are being written).
+  auto ok() const -> bool { return fd_ >= 0; }
+
+  /// @brief The number of times the file has been rotated.
+  auto rotations() const -> size_t { return rotations_; }
+
+  auto write(std::span<const LogRecord> records) -> void override {
+    for (const auto& record : records) {
+      if (!ok()) return;
+      format_line(record);
+      if (should_rotate(line_.size(), record.time_ns)) rotate();
+      append(line_);
+    }
+  }
+
+  auto flush() -> void override { write_buffer(); }
+
+ private:
+  /// @brief Formats a record into `line_`.
+  auto format_line(const LogRecord& record) -> void {
+    const auto seconds = record.time_ns / 1'000'000'000;
+    const auto micros = record.time_ns % 1'000'000'000 / 1000;
+    // Consecutive records mostly fall into the same second
+    if (seconds != timestamp_seconds_) {
+      const auto time = static_cast<std::time_t>(seconds);
+      std::tm utc{};
+      gmtime_r(&time, &utc);
+      char buffer[32];
+      std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+      timestamp_ = buffer;
+      timestamp_seconds_ = seconds;
+    }
+
+    line_.clear();
+    fmt::format_to(std::back_inserter(line_), "{}.{:06}Z {:<5} {} ",
+                   timestamp_, micros, level_name(record.level),
+                   record.thread);
+    for (auto c : record.message) {
+      if (c == '\n') {
+        line_ += "\\n";
+      } else {
+        line_ += c;
+      }
+    }
+    line_ += '\n';
+  }
+
+  /// @brief Whether the file has to be rotated before appending a line.
+  auto should_rotate(size_t bytes, int64_t time_ns) const -> bool {
+    if (size_ == 0) return false;
+    if (options_.max_bytes > 0 && size_ + bytes > options_.max_bytes) {
+      return true;
+    }
+    return options_.max_age_s > 0 &&
+           time_ns - opened_ns_ >= options_.max_age_s * 1'000'000'000;
+  }
+
+  /// @brief Opens (or creates) the file for appending.
+  auto open() -> void {
+    const auto mode = options_.mmap ? O_RDWR : O_WRONLY;
+    fd_ = ::open(options_.path.c_str(), mode | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+      fail("open");
+      return;
+    }
+    struct stat info {};
+    size_ = ::fstat(fd_, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+    if (!options_.mmap) ::lseek(fd_, 0, SEEK_END);
+    opened_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+  }
+
+  /// @brief Writes out pending lines and closes the file.
+  auto close() -> void {
+    if (fd_ < 0) return;
+    write_buffer();
+    if (map_ != nullptr) {
+      ::munmap(map_, config::LOG_MMAP_CHUNK_SIZE);
+      map_ = nullptr;
+      // Drop the unused end of the last chunk
+      if (::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+        fail("truncate");
+        return;
+      }
+    }
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+  /// @brief Moves the file to `<path>.1` (shifting older files up and
+  /// deleting the oldest) and starts a new one.
+  auto rotate() -> void {
+    close();
+    const auto& path = options_.path;
+    if (options_.max_files == 0) {
+      std::remove(path.c_str());
+    } else {
+      for (auto i = options_.max_files - 1; i > 0; i--) {
+        const auto from = fmt::format("{}.{}", path, i);
+        const auto to = fmt::format("{}.{}", path, i + 1);
+        std::rename(from.c_str(), to.c_str());
+      }
+      std::rename(path.c_str(), (path + ".1").c_str());
+    }
+    rotations_++;
+    open();
+  }
+
+  /// @brief Appends a line to the buffer or the mapping.
+  auto append(string_view data) -> void {
+    size_ += data.size();
+    if (options_.mmap) {
+      append_mapped(data);
+      return;
+    }
+    if (buffer_.size() + data.size() > options_.buffer_size) write_buffer();
+    if (data.size() >= options_.buffer_size) {
+      write_all(data);
+    } else {
+      buffer_.append(data);
+    }
+  }
+
+  /// @brief Copies data into the mapped end of the file, mapping the next
+  /// chunk whenever the current one is full.
+  auto append_mapped(string_view data) -> void {
+    const auto chunk = config::LOG_MMAP_CHUNK_SIZE;
+    // `size_` already includes `data`
+    auto offset = size_ - data.size();
+    while (!data.empty()) {
+      const auto chunk_start = offset - offset % chunk;
+      if (map_ == nullptr || map_offset_ != chunk_start) {
+        if (!map_chunk(chunk_start)) {
+          // Fall back to plain writes from here on
+          options_.mmap = false;
+          size_ = offset;
+          if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0) {
+            fail("truncate");
+            return;
+          }
+          ::lseek(fd_, static_cast<off_t>(offset), SEEK_SET);
+          append(data);
+          return;
+        }
+      }
+      const auto used = offset - chunk_start;
+      const auto count = std::min(data.size(), chunk - used);
+      std::memcpy(map_ + used, data.data(), count);
+      data.remove_prefix(count);
+      offset += count;
+    }
+  }
+
+  /// @brief Maps the chunk of the file starting at `offset` (growing the
+  /// file to hold it).
+  auto map_chunk(size_t offset) -> bool {
+    const auto chunk = config::LOG_MMAP_CHUNK_SIZE;
+    if (map_ != nullptr) ::munmap(map_, chunk);
+    map_ = nullptr;
+    if (::ftruncate(fd_, static_cast<off_t>(offset + chunk)) != 0) {
+      return false;
+    }
+    auto* map = ::mmap(nullptr, chunk, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd_, static_cast<off_t>(offset));
+    if (map == MAP_FAILED) return false;
+    map_ = static_cast<char*>(map);
+    map_offset_ = offset;
+    return true;
+  }
+
+  /// @brief Writes out the buffered lines.
+  auto write_buffer() -> void {
+    if (buffer_.empty()) return;
+    write_all(buffer_);
+    buffer_.clear();
+  }
+
+  /// @brief Writes data to the file, retrying short writes.
+  auto write_all(string_view data) -> void {
+    while (fd_ >= 0 && !data.empty()) {
+      const auto written = ::write(fd_, data.data(), data.size());
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        fail("write");
+        return;
+      }
+      data.remove_prefix(static_cast<size_t>(written));
+    }
+  }
+
+  /// @brief Reports an error and disables the sink.
+  auto fail(const char* operation) -> void {
+    std::fprintf(stderr, "Failed to %s log file %s: %s\n", operation,
+                 options_.path.c_str(), std::strerror(errno));
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+  }
+
+  FileSinkOptions options_;
+  /// @brief The open file (-1 if closed or failed).
+  int fd_ = -1;
+  /// @brief The size of the file, including buffered lines (in bytes).
+  size_t size_ = 0;
+  /// @brief When the file was opened (in nanoseconds since the Unix epoch).
+  int64_t opened_ns_ = 0;
+  /// @brief The number of times the file has been rotated.
+  size_t rotations_ = 0;
+  /// @brief Lines waiting to be written.
+  string buffer_;
+  /// @brief Reused to format each line.
+  string line_;
+  /// @brief The formatted date and time of `timestamp_seconds_`.
+  string timestamp_;
+  int64_t timestamp_seconds_ = -1;
+  /// @brief The mapped chunk of the file (memory-mapped mode only).
+  char* map_ = nullptr;
+  /// @brief The file offset `map_` starts at.
+  size_t map_offset_ = 0;
+};
+
+}  // namespace tracing
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils/config.h"
+#include "utils/tracing.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace tracing {
+
+/// @brief The number of shards each counter is split into. Threads are
+/// spread over the shards so that concurrent increments rarely contend.
+static constexpr size_t COUNTER_SHARDS = 16;
+
+/// @brief The assumed size of a cache line (shards are padded to it).
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+/// @brief The shard used by the calling thread (assigned round-robin on the
+/// thread's first increment).
+inline auto shard_index() -> size_t {
+  static std::atomic<size_t> next{0};
+  thread_local const size_t index =
+      next.fetch_add(1, std::memory_order_relaxed) % COUNTER_SHARDS;
+  return index;
+}
+
+/// @brief A monotonically increasing count (e.g. nodes expanded).
+///
+/// Each thread increments its own cache-line-sized shard with a relaxed
+/// add, so recording never contends with other threads; reading sums the
+/// shards.
+class Counter {
+ public:
+  /// @brief Adds to the counter (any thread).
+  inline auto add(uint64_t amount = 1) -> void {
+    shards_[shard_index()].value.fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  /// @brief The current value.
+  auto value() const -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto& shard : shards_) {
+      sum += shard.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    std::atomic<uint64_t> value{0};
+  };
+  std::array<Shard, COUNTER_SHARDS> shards_;
+};
+
+/// @brief A value that can go up and down (e.g. bytes in use).
+class Gauge {
+ public:
+  /// @brief Sets the gauge (any thread).
+  auto set(double value) -> void {
+    value_.store(value, std::memory_order_relaxed);
+  }
+
+  /// @brief Adds to the gauge (any thread).
+  auto add(double amount) -> void {
+    auto value = value_.load(std::memory_order_relaxed);
+    while (!value_.compare_exchange_weak(value, value + amount,
+                                         std::memory_order_relaxed)) {
+    }
+  }
+
+  /// @brief The current value.
+  auto value() const -> double {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<double> value_{0.0};
+};
+
+/// @brief Summary statistics of a histogram.
+struct HistogramStats {
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t max = 0;
+  uint64_t p50 = 0;
+  uint64_t p90 = 0;
+  uint64_t p99 = 0;
+};
+
+/// @brief A histogram of non-negative integer values (e.g. latencies in
+/// microseconds) with HDR-style log-linear buckets.
+///
+/// Every power of two is split into `SUB_BUCKETS` equal buckets, so any
+/// recorded value is reported within 1/`SUB_BUCKETS` (~6%) of its true value
+/// across the whole 64-bit range, in a fixed ~8KB. Recording is a few bit
+/// operations and relaxed atomic adds.
+class Histogram {
+ public:
+  /// @brief The number of buckets per power of two (a power of two itself).
+  static constexpr uint64_t SUB_BUCKETS = 16;
+  static constexpr int SUB_BUCKET_BITS = std::countr_zero(SUB_BUCKETS);
+  /// @brief Values below `SUB_BUCKETS` get a bucket each, then every power
+  /// of two from `SUB_BUCKETS` to 2^63 gets `SUB_BUCKETS` buckets.
+  static constexpr size_t NUM_BUCKETS =
+      (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  /// @brief Records a value (any thread).
+  inline auto record(uint64_t value) -> void {
+    buckets_[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    auto max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(
+                              max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  /// @brief The bucket a value falls into.
+  static constexpr auto bucket(uint64_t value) -> size_t {
+    if (value < SUB_BUCKETS) return value;
+    const auto exponent = std::bit_width(value) - 1;
+    const auto shift = exponent - SUB_BUCKET_BITS;
+    const auto sub_bucket = (value >> shift) & (SUB_BUCKETS - 1);
+    return (shift + 1) * SUB_BUCKETS + sub_bucket;
+  }
+
+  /// @brief The largest value that falls into a bucket.
+  static constexpr auto bucket_upper_bound(size_t bucket) -> uint64_t {
+    if (bucket < SUB_BUCKETS) return bucket;
+    const auto shift = bucket / SUB_BUCKETS - 1;
+    const auto sub_bucket = bucket % SUB_BUCKETS;
+    const auto lower = (SUB_BUCKETS + sub_bucket) << shift;
+    return lower + ((uint64_t{1} << shift) - 1);
+  }
+
+  /// @brief Summarizes the values recorded so far. Percentiles are reported
+  /// as the upper bound of their bucket (capped at the maximum).
+  auto stats() const -> HistogramStats {
+    HistogramStats stats;
+    std::array<uint64_t, NUM_BUCKETS> counts;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      counts[i] = buckets_[i].load(std::memory_order_relaxed);
+      stats.count += counts[i];
+    }
+    stats.sum = sum_.load(std::memory_order_relaxed);
+    stats.max = max_.load(std::memory_order_relaxed);
+    if (stats.count == 0) return stats;
+
+    auto percentile = [&](double p) {
+      const auto rank = static_cast<uint64_t>(p * (stats.count - 1)) + 1;
+      uint64_t seen = 0;
+      for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(bucket_upper_bound(i), stats.max);
+      }
+      return stats.max;
+    };
+    stats.p50 = percentile(0.50);
+    stats.p90 = percentile(0.90);
+    stats.p99 = percentile(0.99);
+    return stats;
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets_{};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+/// @brief The value of every metric at one point in time.
+struct MetricsSnapshot {
+  template <typename Value>
+  struct Sample {
+    string name;
+    string help;
+    Value value;
+  };
+
+  vector<Sample<uint64_t>> counters;
+  vector<Sample<double>> gauges;
+  vector<Sample<HistogramStats>> histograms;
+};
+
+/// @brief Owns every metric by name.
+///
+/// Looking a metric up takes a lock, so call sites look theirs up once and
+/// keep the reference (metrics are never removed):
+///
+/// ```cpp
+/// static auto& expanded = tracing::metrics().counter(
+///     "search_nodes_expanded_total", "Nodes expanded by all searches");
+/// expanded.add();
+/// ```
+class MetricsRegistry {
+ public:
+  /// @brief The counter with the given name (created on first use).
+  auto counter(const string& name, const string& help = "") -> Counter& {
+    return get(counters_, name, help);
+  }
+
+  /// @brief The gauge with the given name (created on first use).
+  auto gauge(const string& name, const string& help = "") -> Gauge& {
+    return get(gauges_, name, help);
+  }
+
+  /// @brief The histogram with the given name (created on first use).
+  auto histogram(const string& name, const string& help = "") -> Histogram& {
+    return get(histograms_, name, help);
+  }
+
+  /// @brief Reads every metric (sorted by name).
+  auto snapshot() -> MetricsSnapshot {
+    std::lock_guard lock(mutex_);
+    MetricsSnapshot snapshot;
+    for (const auto& [name, entry] : counters_) {
+      snapshot.counters.push_back({name, entry.help, entry.metric->value()});
+    }
+    for (const auto& [name, entry] : gauges_) {
+      snapshot.gauges.push_back({name, entry.help, entry.metric->value()});
+    }
+    for (const auto& [name, entry] : histograms_) {
+      snapshot.histograms.push_back({name, entry.help, entry.metric->stats()});
+    }
+    return snapshot;
+  }
+
+  /// @brief Formats every metric as human-readable text, one per line.
+  auto dump_text() -> string {
+    const auto snapshot = this->snapshot();
+    string text;
+    for (const auto& counter : snapshot.counters) {
+      text += format("{} {}\n", counter.name, counter.value);
+    }
+    for (const auto& gauge : snapshot.gauges) {
+      text += format("{} {}\n", gauge.name, gauge.value);
+    }
+    for (const auto& histogram : snapshot.histograms) {
+      const auto& stats = histogram.value;
+      text += format("{} count={} p50={} p90={} p99={} max={}\n",
+                     histogram.name, stats.count, stats.p50, stats.p90,
+                     stats.p99, stats.max);
+    }
+    return text;
+  }
+
+  /// @brief Writes every metric in the Prometheus text exposition format
+  /// (histograms are exposed as summaries), e.g. for node_exporter's textfile
+  /// collector.
+  /// @param path The file to write.
+  /// @return Whether the file was written.
+  auto write_prometheus(const string& path) -> bool {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    const auto snapshot = this->snapshot();
+    const auto prefix = config::METRICS_PREFIX;
+    auto header = [&](const auto& sample, const char* type) {
+      if (!sample.help.empty()) {
+        out << format("# HELP {}{} {}\n", prefix, sample.name, sample.help);
+      }
+      out << format("# TYPE {}{} {}\n", prefix, sample.name, type);
+    };
+
+    for (const auto& counter : snapshot.counters) {
+      header(counter, "counter");
+      out << format("{}{} {}\n", prefix, counter.name, counter.value);
+    }
+    for (const auto& gauge : snapshot.gauges) {
+      header(gauge, "gauge");
+      out << format("{}{} {}\n", prefix, gauge.name, gauge.value);
+    }
+    for (const auto& histogram : snapshot.histograms) {
+      const auto& stats = histogram.value;
+      const auto name = prefix + histogram.name;
+      header(histogram, "summary");
+      out << format("{}{{quantile=\"0.5\"}} {}\n", name, stats.p50)
+          << format("{}{{quantile=\"0.9\"}} {}\n", name, stats.p90)
+          << format("{}{{quantile=\"0.99\"}} {}\n", name, stats.p99)
+          << format("{}_sum {}\n", name, stats.sum)
+          << format("{}_count {}\n", name, stats.count);
+    }
+    return static_cast<bool>(out);
+  }
+
+ private:
+  template <typename Metric>
+  struct Entry {
+    string help;
+    unique_ptr<Metric> metric;
+  };
+
+  template <typename Metric>
+  auto get(std::map<string, Entry<Metric>>& metrics, const string& name,
+           const string& help) -> Metric& {
+    std::lock_guard lock(mutex_);
+    auto& entry = metrics[name];
+    if (!entry.metric) {
+      entry.help = help;
+      entry.metric = std::make_unique<Metric>();
+    }
+    return *entry.metric;
+  }
+
+  /// @brief Guards the maps (not the metrics, which are atomic).
+  std::mutex mutex_;
+  std::map<string, Entry<Counter>> counters_;
+  std::map<string, Entry<Gauge>> gauges_;
+  std::map<string, Entry<Histogram>> histograms_;
+};
+
+/// @brief The process-wide metrics registry.
+inline auto metrics() -> MetricsRegistry& {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+}  // namespace tracing
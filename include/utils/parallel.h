@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// @brief Data-parallel helpers for CPU-bound loops.
+namespace parallel {
+
+/// @brief The number of threads parallel loops use by default.
+inline auto num_threads() -> size_t {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// @brief A set of threads that stay alive between parallel loops, so that
+/// loops run once per level of a traversal or per round of an algorithm
+/// don't start (and tear down) threads every time, and the workers'
+/// `thread_local` scratch space survives from one loop to the next.
+///
+/// The thread running a job always takes part in it, and idle workers join
+/// it as helpers; nothing waits for a helper to become available. A job
+/// whose caller finished before any helper joined simply ran on one thread,
+/// so jobs started from inside other jobs (nested loops) can't deadlock.
+class ThreadPool {
+ public:
+  ThreadPool() = default;
+  ThreadPool(const ThreadPool&) = delete;
+  auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    posted_.notify_all();
+    for (auto& worker : workers_) worker.join();
+  }
+
+  /// @brief Calls `work()` on the calling thread and on up to `helpers` idle
+  /// workers at once, and returns once every call has returned. `work`
+  /// should claim its share of a common pool of work until none is left, as
+  /// it can't know how many threads will end up running it.
+  ///
+  /// Workers are started on demand: the pool grows to the largest number of
+  /// helpers asked for, and keeps them.
+  auto run(size_t helpers, const std::function<void()>& work) -> void {
+    Job job{&work, helpers, 0, {}};
+    {
+      std::lock_guard lock(mutex_);
+      while (workers_.size() < helpers) {
+        workers_.emplace_back([this] { serve(); });
+      }
+      jobs_.push_back(&job);
+    }
+    posted_.notify_all();
+
+    work();
+
+    std::unique_lock lock(mutex_);
+    // No helper may join once the caller is done (the job lives on its
+    // stack), then wait for those that did
+    std::erase(jobs_, &job);
+    job.done.wait(lock, [&] { return job.running == 0; });
+  }
+
+  /// @brief The number of worker threads started so far.
+  auto size() const -> size_t {
+    std::lock_guard lock(mutex_);
+    return workers_.size();
+  }
+
+ private:
+  struct Job {
+    const std::function<void()>* work;
+    /// @brief The number of helpers that may still join.
+    size_t open;
+    /// @brief The number of helpers running `work`.
+    size_t running = 0;
+    std::condition_variable done;
+  };
+
+  /// @brief Worker body: helps with posted jobs until the pool is destroyed.
+  auto serve() -> void {
+    std::unique_lock lock(mutex_);
+    while (true) {
+      posted_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+      if (stopping_) return;
+      auto* job = jobs_.front();
+      if (--job->open == 0) jobs_.pop_front();
+      job->running++;
+      lock.unlock();
+      (*job->work)();
+      lock.lock();
+      // Everything has been claimed once a call returns, so later helpers
+      // would find nothing to do
+      if (job->open > 0) {
+        job->open = 0;
+        std::erase(jobs_, job);
+      }
+      if (--job->running == 0) job->done.notify_one();
+    }
+  }
+
+  /// @brief Guards every other member (and every job's counts).
+  mutable std::mutex mutex_;
+  /// @brief Signalled when a job is posted (or on destruction).
+  std::condition_variable posted_;
+  /// @brief The jobs that helpers may still join, oldest first.
+  std::deque<Job*> jobs_;
+  std::vector<std::thread> workers_;
+  bool stopping_ = false;
+};
+
+/// @brief The process-wide pool parallel loops run on.
+inline auto thread_pool() -> ThreadPool& {
+  static ThreadPool pool;
+  return pool;
+}
+
+/// @brief Calls `body(i)` for every `i` in `[0, count)`, spread over up to
+/// `threads` threads (the calling thread included), on `thread_pool()`.
+///
+/// Indices are handed out dynamically in chunks of `grain`, so iterations of
+/// uneven cost still balance. Iterations must be independent. The first
+/// exception thrown by `body` is rethrown once every thread has stopped.
+///
+/// @param count The number of iterations.
+/// @param body Called once per index, from any of the threads.
+/// @param grain The number of consecutive indices a thread claims at once.
+/// @param threads The maximum number of threads (defaults to one per core).
+template <typename Body>
+auto parallel_for(size_t count, Body&& body, size_t grain = 1,
+                  size_t threads = num_threads()) -> void {
+  grain = std::max<size_t>(grain, 1);
+  const auto chunks = (count + grain - 1) / grain;
+  threads = std::min(threads, chunks);
+  if (threads <= 1) {
+    for (size_t i = 0; i < count; i++) body(i);
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto work = [&] {
+    try {
+      for (;;) {
+        const auto first = next.fetch_add(grain, std::memory_order_relaxed);
+        if (first >= count) return;
+        const auto last = std::min(first + grain, count);
+        for (auto i = first; i < last; i++) body(i);
+      }
+    } catch (...) {
+      std::lock_guard lock(error_mutex);
+      if (!error) error = std::current_exception();
+      // Stop handing out work
+      next.store(count, std::memory_order_relaxed);
+    }
+  };
+
+  thread_pool().run(threads - 1, work);
+  if (error) std::rethrow_exception(error);
+}
+
+/// @brief Replaces every element of `[first, last)` with the sum of the
+/// elements before it (an exclusive prefix sum), with up to `threads`
+/// threads: each thread sums a block, the block sums are scanned, then each
+/// thread scans its block from its block's offset.
+///
+/// @return The sum of all the elements.
+template <typename Iterator>
+auto exclusive_scan(Iterator first, Iterator last,
+                    size_t threads = num_threads()) ->
+    typename std::iterator_traits<Iterator>::value_type {
+  using Value = typename std::iterator_traits<Iterator>::value_type;
+  // Below this many elements per block, threads cost more than they save
+  constexpr size_t kMinBlock = 1 << 16;
+  const auto count = static_cast<size_t>(std::distance(first, last));
+  const auto blocks =
+      std::max<size_t>(1, std::min(threads, count / kMinBlock));
+  auto block_begin = [&](size_t block) {
+    return first + count * block / blocks;
+  };
+
+  std::vector<Value> sums(blocks, Value{});
+  parallel_for(
+      blocks,
+      [&](size_t block) {
+        for (auto it = block_begin(block); it != block_begin(block + 1); ++it) {
+          sums[block] += *it;
+        }
+      },
+      1, blocks);
+  Value total{};
+  for (auto& sum : sums) total += std::exchange(sum, total);
+  parallel_for(
+      blocks,
+      [&](size_t block) {
+        auto running = sums[block];
+        for (auto it = block_begin(block); it != block_begin(block + 1); ++it) {
+          running += std::exchange(*it, running);
+        }
+      },
+      1, blocks);
+  return total;
+}
+
+/// @brief Sorts `[first, last)` with up to `threads` threads: the range is
+/// split into one run per thread, the runs are sorted in parallel, then
+/// merged pairwise (in parallel within each round of merges).
+///
+/// Not stable. Ranges too small to be worth splitting are sorted on the
+/// calling thread.
+template <typename Iterator, typename Compare = std::less<>>
+auto parallel_sort(Iterator first, Iterator last, Compare compare = {},
+                   size_t threads = num_threads()) -> void {
+  // Below this many elements per run, threads cost more than they save
+  constexpr size_t kMinRun = 1 << 14;
+  const auto count = static_cast<size_t>(std::distance(first, last));
+  const auto runs = std::min(threads, count / kMinRun);
+  if (runs <= 1) {
+    std::sort(first, last, compare);
+    return;
+  }
+
+  // Run `i` is `[bounds[i], bounds[i + 1])`
+  std::vector<size_t> bounds(runs + 1);
+  for (size_t i = 0; i <= runs; i++) bounds[i] = count * i / runs;
+  parallel_for(
+      runs,
+      [&](size_t run) {
+        std::sort(first + bounds[run], first + bounds[run + 1], compare);
+      },
+      1, runs);
+
+  while (bounds.size() > 2) {
+    const auto pairs = (bounds.size() - 1) / 2;
+    parallel_for(
+        pairs,
+        [&](size_t pair) {
+          std::inplace_merge(first + bounds[2 * pair],
+                             first + bounds[2 * pair + 1],
+                             first + bounds[2 * pair + 2], compare);
+        },
+        1, pairs);
+    // Every other bound disappears (an odd run out carries over)
+    std::vector<size_t> merged;
+    for (size_t i = 0; i < bounds.size(); i += 2) merged.push_back(bounds[i]);
+    if (merged.back() != count) merged.push_back(count);
+    bounds = std::move(merged);
+  }
+}
+
+}  // namespace parallel
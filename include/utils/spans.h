@@ -0,0 +1,339 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/config.h"
+#include "utils/tracing.h"
+
+using std::string;
+using std::string_view;
+using std::unique_ptr;
+using std::vector;
+
+namespace tracing {
+
+/// @brief The maximum number of numeric arguments attached to a span.
+static constexpr size_t MAX_SPAN_ARGS = 3;
+
+/// @brief A named numeric value attached to a span (e.g. the number of nodes
+/// a search expanded).
+struct SpanArg {
+  const char* key = nullptr;
+  double value = 0.0;
+};
+
+/// @brief A finished span, as stored in a thread's buffer. Names, categories
+/// and argument keys are not copied, so they must be string literals.
+struct SpanRecord {
+  const char* name = nullptr;
+  const char* category = nullptr;
+  /// @brief When the span began / ended (in nanoseconds since the registry
+  /// was created).
+  int64_t begin_ns = 0;
+  int64_t end_ns = 0;
+  std::array<SpanArg, MAX_SPAN_ARGS> args{};
+  uint8_t num_args = 0;
+};
+
+/// @brief The spans recorded by a single thread.
+///
+/// Only the owning thread appends; any thread may read the records published
+/// so far (the size is stored with release semantics after each record is
+/// written). Storage is allocated on the first record, and once
+/// `config::SPAN_BUFFER_CAPACITY` spans have been recorded further spans are
+/// counted as dropped rather than growing the buffer.
+///
+/// A buffer holds the spans of a single recording session: the first span
+/// its thread records in a new session empties it (see
+/// `SpanRegistry::record()`).
+class SpanBuffer {
+ public:
+  explicit SpanBuffer(uint32_t thread) : thread_(thread) {}
+
+  /// @brief Appends a finished span (owning thread only).
+  auto push(const SpanRecord& record) -> void {
+    const auto size = size_.load(std::memory_order_relaxed);
+    if (size == config::SPAN_BUFFER_CAPACITY) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    if (!records_) {
+      records_ = std::make_unique<SpanRecord[]>(config::SPAN_BUFFER_CAPACITY);
+    }
+    records_[size] = record;
+    size_.store(size + 1, std::memory_order_release);
+  }
+
+  /// @brief Empties the buffer for a new recording session (owning thread
+  /// only, while holding the registry's lock so no export is reading it).
+  auto reset(uint64_t session) -> void {
+    session_ = session;
+    size_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+  }
+
+  /// @brief The recording session the buffer's spans belong to.
+  auto session() const { return session_; }
+
+  /// @brief The number of spans published so far.
+  auto size() const { return size_.load(std::memory_order_acquire); }
+
+  /// @brief A published span (`index < size()`).
+  auto operator[](size_t index) const -> const SpanRecord& {
+    return records_[index];
+  }
+
+  /// @brief The number of spans that didn't fit the buffer.
+  auto dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /// @brief The id of the owning thread (small and dense, in registration
+  /// order).
+  auto thread() const { return thread_; }
+
+  /// @brief The name of the owning thread (`nullptr` if unnamed).
+  auto name() const { return name_.load(std::memory_order_acquire); }
+
+  /// @brief Names the owning thread (a string literal).
+  auto set_name(const char* name) -> void {
+    name_.store(name, std::memory_order_release);
+  }
+
+ private:
+  uint32_t thread_;
+  uint64_t session_ = 0;
+  std::atomic<const char*> name_{nullptr};
+  unique_ptr<SpanRecord[]> records_;
+  std::atomic<size_t> size_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+/// @brief Owns every thread's `SpanBuffer` and exports them as a Chrome trace.
+///
+/// Buffers are owned by the registry rather than by their threads, so spans
+/// recorded by threads that have since exited are still exported.
+class SpanRegistry {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  SpanRegistry() : epoch_(Clock::now()) {}
+
+  SpanRegistry(const SpanRegistry&) = delete;
+  auto operator=(const SpanRegistry&) -> SpanRegistry& = delete;
+
+  /// @brief Starts a new recording session: spans recorded in earlier
+  /// sessions are discarded (and every thread can record
+  /// `config::SPAN_BUFFER_CAPACITY` spans again).
+  auto start() -> void {
+    session_.fetch_add(1, std::memory_order_relaxed);
+    recording_.store(true, std::memory_order_release);
+  }
+
+  /// @brief Stops recording spans (spans already open are still recorded).
+  auto stop() -> void { recording_.store(false, std::memory_order_release); }
+
+  /// @brief Whether spans are being recorded.
+  auto recording() const -> bool {
+    return recording_.load(std::memory_order_relaxed);
+  }
+
+  /// @brief The current time (in nanoseconds since the registry was created).
+  auto now() const -> int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                epoch_)
+        .count();
+  }
+
+  /// @brief The calling thread's buffer (registered on first use).
+  auto local() -> SpanBuffer& {
+    thread_local SpanBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+      std::lock_guard lock(mutex_);
+      const auto thread = static_cast<uint32_t>(buffers_.size());
+      buffers_.push_back(std::make_unique<SpanBuffer>(thread));
+      buffer = buffers_.back().get();
+    }
+    return *buffer;
+  }
+
+  /// @brief Appends a finished span to the calling thread's buffer.
+  auto record(const SpanRecord& record) -> void {
+    auto& buffer = local();
+    const auto session = session_.load(std::memory_order_relaxed);
+    if (buffer.session() != session) {
+      // Once per thread and session; the lock keeps the buffer from being
+      // emptied while it is exported
+      std::lock_guard lock(mutex_);
+      buffer.reset(session);
+    }
+    buffer.push(record);
+  }
+
+  /// @brief Writes every span recorded in the current (or last) session in
+  /// the Chrome Trace Event format, which can be opened in Perfetto
+  /// (ui.perfetto.dev) or `chrome://tracing`. Safe to call while other
+  /// threads record spans.
+  /// @param path The file to write.
+  /// @return Whether the file was written.
+  auto write_chrome_trace(const string& path) -> bool {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    std::lock_guard lock(mutex_);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    auto first = true;
+    auto separator = [&] {
+      out << (first ? "\n" : ",\n");
+      first = false;
+    };
+
+    const auto session = session_.load(std::memory_order_relaxed);
+    uint64_t dropped = 0;
+    for (const auto& buffer : buffers_) {
+      // Threads that haven't recorded a span this session still hold spans
+      // of an earlier one
+      const auto current = buffer->session() == session;
+      if (current) dropped += buffer->dropped();
+      if (auto name = buffer->name(); name != nullptr) {
+        separator();
+        out << format(
+            "{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+            "\"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}",
+            buffer->thread(), escape(name));
+      }
+
+      const auto size = current ? buffer->size() : 0;
+      for (size_t i = 0; i < size; i++) {
+        const auto& record = (*buffer)[i];
+        separator();
+        out << format(
+            "{{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"pid\": 1, "
+            "\"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {{",
+            escape(record.name), escape(record.category), buffer->thread(),
+            record.begin_ns / 1e3, (record.end_ns - record.begin_ns) / 1e3);
+        for (uint8_t a = 0; a < record.num_args; a++) {
+          out << format("{}\"{}\": {}", a == 0 ? "" : ", ",
+                        escape(record.args[a].key), record.args[a].value);
+        }
+        out << "}}";
+      }
+    }
+    out << "\n]}\n";
+
+    if (dropped > 0) {
+      warn("{} spans did not fit their thread's buffer", dropped);
+    }
+    return static_cast<bool>(out);
+  }
+
+ private:
+  /// @brief Escapes a string for use in a JSON string literal.
+  static auto escape(string_view str) -> string {
+    string escaped;
+    escaped.reserve(str.size());
+    for (auto c : str) {
+      if (c == '"' || c == '\\') escaped += '\\';
+      escaped += c;
+    }
+    return escaped;
+  }
+
+  /// @brief Where timestamps are measured from.
+  Clock::time_point epoch_;
+  /// @brief Whether spans are being recorded.
+  std::atomic<bool> recording_{false};
+  /// @brief The current recording session (bumped by `start()`).
+  std::atomic<uint64_t> session_{0};
+  /// @brief Guards `buffers_`, and buffers being emptied against exports.
+  std::mutex mutex_;
+  /// @brief Every thread's buffer, indexed by thread id.
+  vector<unique_ptr<SpanBuffer>> buffers_;
+};
+
+/// @brief The process-wide span registry.
+inline auto spans() -> SpanRegistry& {
+  static SpanRegistry registry;
+  return registry;
+}
+
+/// @brief Starts recording spans (discarding those of earlier sessions).
+inline auto start_span_recording() { spans().start(); }
+
+/// @brief Stops recording spans.
+inline auto stop_span_recording() { spans().stop(); }
+
+/// @brief Writes the spans of the current (or last) recording session as a
+/// Chrome trace (see `SpanRegistry::write_chrome_trace()`).
+inline auto write_chrome_trace(const string& path) -> bool {
+  return spans().write_chrome_trace(path);
+}
+
+/// @brief Names the calling thread in exported traces.
+/// @param name The name of the thread (a string literal).
+inline auto set_thread_name(const char* name) {
+  spans().local().set_name(name);
+}
+
+/// @brief Records the time between its construction and destruction (or
+/// `end()`) as a span on the calling thread's timeline.
+///
+/// ```cpp
+/// tracing::Span span("a_star", "search");
+/// ...
+/// span.arg("expanded", expanded);
+/// ```
+///
+/// When spans are not being recorded, constructing a span costs a single
+/// relaxed load and nothing is recorded.
+class Span {
+ public:
+  /// @param name The name of the span (a string literal).
+  /// @param category The category of the span (a string literal), used to
+  ///                 filter spans in the trace viewer.
+  explicit Span(const char* name, const char* category = "app") {
+    auto& registry = spans();
+    if (!registry.recording()) return;
+    active_ = true;
+    record_.name = name;
+    record_.category = category;
+    record_.begin_ns = registry.now();
+  }
+
+  Span(const Span&) = delete;
+  auto operator=(const Span&) -> Span& = delete;
+
+  ~Span() { end(); }
+
+  /// @brief Attaches a numeric argument (at most `MAX_SPAN_ARGS`).
+  /// @param key The name of the argument (a string literal).
+  /// @param value The value of the argument.
+  auto arg(const char* key, double value) -> Span& {
+    if (active_ && record_.num_args < MAX_SPAN_ARGS) {
+      record_.args[record_.num_args++] = SpanArg{key, value};
+    }
+    return *this;
+  }
+
+  /// @brief Ends the span early.
+  auto end() -> void {
+    if (!active_) return;
+    active_ = false;
+    auto& registry = spans();
+    record_.end_ns = registry.now();
+    registry.record(record_);
+  }
+
+ private:
+  SpanRecord record_;
+  bool active_ = false;
+};
+
+}  // namespace tracing
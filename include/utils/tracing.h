@@ -1,11 +1,20 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "utils/config.h"
+#include "utils/data_structures/mpsc_queue.h"
 
 #define FMT_HEADER_ONLY
 #include "fmt/color.h"
@@ -17,6 +26,7 @@ using std::cout;
 using std::endl;
 using std::string;
 using std::string_view;
+using std::unique_ptr;
 using std::vector;
 
 /// @brief Collection of utilities for logging and tracing
@@ -69,8 +79,28 @@ enum LogLevel {
 };
 
 /// @brief The **log level**. This is used to control the **amount of
-/// logging** emitted.
-static LogLevel log_level = LVL_INFO;
+/// logging** emitted. Shared by every translation unit and safe to change
+/// while other threads log.
+inline std::atomic<LogLevel> log_level{LVL_INFO};
+
+#ifndef FICIEL_MIN_LOG_LEVEL
+/// @brief The least important level compiled into the binary (as an `int`,
+/// e.g. `--copt=-DFICIEL_MIN_LOG_LEVEL=2` strips trace and debug messages
+/// from release builds entirely). Defaults to keeping every level.
+#define FICIEL_MIN_LOG_LEVEL 0
+#endif
+
+/// @brief The least important level compiled into the binary (see
+/// `FICIEL_MIN_LOG_LEVEL`). Less important messages cost nothing, not even a
+/// branch.
+inline constexpr LogLevel MIN_LOG_LEVEL =
+    static_cast<LogLevel>(FICIEL_MIN_LOG_LEVEL);
+
+/// @brief Whether messages of a level are compiled in at all.
+/// @param level The log level
+constexpr auto compiled_in(LogLevel level) -> bool {
+  return static_cast<int>(level) >= static_cast<int>(MIN_LOG_LEVEL);
+}
 
 /// Comparison operators for LogLevel
 inline bool operator==(LogLevel a, LogLevel b) { return (int)a == (int)b; }
@@ -107,35 +137,303 @@ class LogPrefix {
   string prefix;
 };
 
-/// @brief Log a message to the console
+/// @brief The colored `[LEVEL]: ` prefix of a log line (formatted once per
+/// level rather than on every call).
 /// @param level The log level
-/// @param strings The strings to log
-inline void log(LogLevel level, vector<string_view> strings) {
-  cout << format(fg(color::black) | emphasis::bold, "[")
-       << LogPrefix{level}.to_string()
-       << format(fg(color::black) | emphasis::bold, "]: ");
-  for (auto s : strings) {
-    cout << s << ", ";
+inline auto level_prefix(LogLevel level) -> const string& {
+  static const auto prefixes = [] {
+    std::array<string, LVL_ERROR + 1> prefixes;
+    for (int i = LVL_TRACE; i <= LVL_ERROR; i++) {
+      prefixes[i] = format(fg(color::black) | emphasis::bold, "[") +
+                    LogPrefix{static_cast<LogLevel>(i)}.to_string() +
+                    format(fg(color::black) | emphasis::bold, "]: ");
+    }
+    return prefixes;
+  }();
+  return prefixes[level];
+}
+
+/// @brief The uncolored name of a level (e.g. `INFO`), for log files.
+/// @param level The log level
+constexpr auto level_name(LogLevel level) -> string_view {
+  constexpr std::array<string_view, LVL_ERROR + 1> names = {
+      "TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+  return names[level];
+}
+
+/// @brief A small id for the calling thread, assigned in the order threads
+/// first log (cheaper to record and easier to read than `std::thread::id`).
+inline auto log_thread_id() -> uint32_t {
+  static std::atomic<uint32_t> next{0};
+  thread_local const uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+  return id;
+}
+
+/// @brief A message waiting to be written to the log sinks.
+struct LogRecord {
+  LogLevel level = LVL_INFO;
+  /// @brief When the message was logged (in nanoseconds since the Unix
+  /// epoch).
+  int64_t time_ns = 0;
+  /// @brief The thread that logged the message (see `log_thread_id()`).
+  uint32_t thread = 0;
+  string message;
+};
+
+/// @brief Builds a record of a message logged now by the calling thread.
+/// @param level The log level
+/// @param message The formatted message
+inline auto make_record(LogLevel level, string message) -> LogRecord {
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  return LogRecord{
+      level, std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(),
+      log_thread_id(), std::move(message)};
+}
+
+/// @brief A destination for log messages (e.g. the console or a file).
+///
+/// Sinks are only ever called by one thread at a time (the log writer, or
+/// the logging thread while messages are written synchronously), so they
+/// need no locking of their own.
+class LogSink {
+ public:
+  virtual ~LogSink() = default;
+
+  /// @brief Writes a batch of messages (possibly only into a buffer).
+  virtual auto write(std::span<const LogRecord> records) -> void = 0;
+
+  /// @brief Hands everything written so far to the operating system.
+  virtual auto flush() -> void {}
+};
+
+/// @brief Writes colored `[LEVEL]: message` lines to a terminal, flushing
+/// after every batch so they show up immediately.
+class ConsoleSink : public LogSink {
+ public:
+  /// @param out The stream to write to (e.g. `stderr` when `stdout` carries
+  ///            data, such as raw frames exported to `-`).
+  explicit ConsoleSink(FILE* out = stdout) : out_(out) {}
+
+  auto write(std::span<const LogRecord> records) -> void override {
+    line_.clear();
+    for (const auto& record : records) {
+      line_ += level_prefix(record.level);
+      line_ += record.message;
+      line_ += '\n';
+    }
+    std::fwrite(line_.data(), 1, line_.size(), out_);
+    std::fflush(out_);
+  }
+
+ private:
+  FILE* out_;
+  /// @brief Reused to format each batch into a single write.
+  string line_;
+};
+
+/// @brief Writes log messages to the log sinks, on a background thread once
+/// started.
+///
+/// Logging threads only move their message into a lock-free MPSC queue (one
+/// compare-and-swap, plus a counter telling `stop()` to wait for them); the
+/// writer thread hands batches of up to `config::LOG_BATCH_SIZE` messages to
+/// every sink and flushes the sinks whenever it catches up with the queue,
+/// rather than once per line. If the queue is full, logging threads wait for
+/// the writer to catch up rather than dropping messages.
+class AsyncWriter {
+ public:
+  AsyncWriter() : queue_(config::LOG_QUEUE_CAPACITY) {
+    // Build the prefixes first so they outlive the writer at exit
+    level_prefix(LVL_INFO);
+    sinks_.push_back(std::make_unique<ConsoleSink>());
+  }
+
+  AsyncWriter(const AsyncWriter&) = delete;
+  auto operator=(const AsyncWriter&) -> AsyncWriter& = delete;
+
+  ~AsyncWriter() { stop(); }
+
+  /// @brief Replaces the sinks messages are written to (flushing the old
+  /// ones first).
+  auto set_sinks(vector<unique_ptr<LogSink>> sinks) -> void {
+    flush();
+    std::lock_guard lock(sinks_mutex_);
+    for (auto& sink : sinks_) sink->flush();
+    sinks_ = std::move(sinks);
   }
-  cout << endl;
+
+  /// @brief Starts the writer thread.
+  auto start() -> void {
+    if (running()) return;
+    stopping_.store(false, std::memory_order_relaxed);
+    running_.store(true, std::memory_order_seq_cst);
+    thread_ = std::thread([this] { write_records(); });
+  }
+
+  /// @brief Writes out every queued message and stops the writer thread.
+  /// Messages logged afterwards are written synchronously again.
+  auto stop() -> void {
+    if (!running()) return;
+    running_.store(false, std::memory_order_seq_cst);
+    // Threads that saw the writer running may not have queued their message
+    // yet: wait for them, so the writer's final drain sees every message
+    while (submitters_.load(std::memory_order_seq_cst) > 0) {
+      std::this_thread::yield();
+    }
+    stopping_.store(true, std::memory_order_release);
+    thread_.join();
+  }
+
+  /// @brief Whether messages are currently handed to the writer thread.
+  auto running() const -> bool {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  /// @brief Writes a message (any thread): queues it while the writer thread
+  /// runs, writes it on the calling thread otherwise.
+  auto write(LogRecord record) -> void {
+    // Announce the submission before checking `running_` (and `stop()`
+    // clears `running_` before checking `submitters_`), so either this
+    // thread sees the writer stopping or `stop()` waits for the push
+    submitters_.fetch_add(1, std::memory_order_seq_cst);
+    if (running_.load(std::memory_order_seq_cst)) {
+      while (!queue_.try_push(std::move(record))) std::this_thread::yield();
+      submitters_.fetch_sub(1, std::memory_order_release);
+      return;
+    }
+    submitters_.fetch_sub(1, std::memory_order_release);
+    write_now(record);
+  }
+
+  /// @brief Writes a message and flushes the sinks on the calling thread
+  /// (used while the writer thread isn't running).
+  auto write_now(const LogRecord& record) -> void {
+    std::lock_guard lock(sinks_mutex_);
+    for (auto& sink : sinks_) {
+      sink->write(std::span(&record, 1));
+      sink->flush();
+    }
+  }
+
+  /// @brief Waits until every message queued so far has been written.
+  auto flush() -> void {
+    const auto target = queue_.pushed();
+    while (written_.load(std::memory_order_acquire) < target) {
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  /// @brief Writer thread body: writes batches of messages until `stop()`.
+  auto write_records() -> void {
+    vector<LogRecord> batch(config::LOG_BATCH_SIZE);
+    while (true) {
+      // Every message is queued before `stopping_` is set, so once it is, an
+      // empty queue stays empty
+      const auto stopping = stopping_.load(std::memory_order_acquire);
+      size_t count = 0;
+      while (count < batch.size() && queue_.try_pop(batch[count])) count++;
+
+      if (count > 0) {
+        std::lock_guard lock(sinks_mutex_);
+        for (auto& sink : sinks_) sink->write(std::span(batch.data(), count));
+        // Buffering sinks only write out once the writer has caught up (or
+        // their buffer is full)
+        if (queue_.empty()) {
+          for (auto& sink : sinks_) sink->flush();
+        }
+        written_.fetch_add(count, std::memory_order_release);
+      } else if (stopping) {
+        return;
+      } else {
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(config::LOG_FLUSH_INTERVAL_US));
+      }
+    }
+  }
+
+  /// @brief Messages waiting to be written.
+  data_structures::queue::MpscQueue<LogRecord> queue_;
+  /// @brief The number of messages written so far.
+  std::atomic<size_t> written_{0};
+  /// @brief Whether messages are handed to the writer thread.
+  std::atomic<bool> running_{false};
+  /// @brief The number of threads between checking `running_` and queuing
+  /// their message.
+  std::atomic<size_t> submitters_{0};
+  /// @brief Set by `stop()` once every message is queued: the writer thread
+  /// exits when it has drained the queue.
+  std::atomic<bool> stopping_{false};
+  /// @brief Guards `sinks_`.
+  std::mutex sinks_mutex_;
+  /// @brief Where messages are written.
+  vector<unique_ptr<LogSink>> sinks_;
+  /// @brief Writes queued messages.
+  std::thread thread_;
+};
+
+/// @brief The process-wide background log writer (stopped, and thereby
+/// flushed, on exit).
+inline auto async_writer() -> AsyncWriter& {
+  static AsyncWriter writer;
+  return writer;
+}
+
+/// @brief Moves writing log messages to a background thread.
+inline auto start_async_logging() { async_writer().start(); }
+
+/// @brief Writes out pending messages and goes back to writing synchronously.
+inline auto stop_async_logging() { async_writer().stop(); }
+
+/// @brief Waits until every message logged so far has been written.
+inline auto flush_logs() {
+  if (async_writer().running()) async_writer().flush();
+}
+
+/// @brief Replaces the sinks log messages are written to (the console only,
+/// by default).
+inline auto set_log_sinks(vector<unique_ptr<LogSink>> sinks) {
+  async_writer().set_sinks(std::move(sinks));
+}
+
+/// @brief Log an already formatted message to the console (handed to the
+/// background writer without copying it)
+/// @param level  The log level
+/// @param message The message to log
+inline void log_message(LogLevel level, string message) {
+  async_writer().write(make_record(level, std::move(message)));
 }
 
 /// @brief Log a message to the console
 /// @param level  The log level
 /// @param str   The string to log
 inline void log(LogLevel level, string_view str) {
-  cout << format(fg(color::black) | emphasis::bold, "[")
-       << LogPrefix{level}.to_string()
-       << format(fg(color::black) | emphasis::bold, "]: ") << str << endl;
+  log_message(level, string(str));
+}
+
+/// @brief Log a message to the console
+/// @param level The log level
+/// @param strings The strings to log
+inline void log(LogLevel level, vector<string_view> strings) {
+  string message;
+  for (auto s : strings) {
+    message += s;
+    message += ", ";
+  }
+  log(level, message);
 }
 
 /// @brief Get the current log level (defaults to `LogLevel::LVL_INFO`)
 /// @return The current log level
-inline auto getLogLevel() { return log_level; }
+inline auto getLogLevel() {
+  return log_level.load(std::memory_order_relaxed);
+}
 
 /// @brief Set the log level
 /// @param level The log level
-inline auto set_log_level(LogLevel level) { log_level = level; }
+inline auto set_log_level(LogLevel level) {
+  log_level.store(level, std::memory_order_relaxed);
+}
 
 /// @brief Initialize the log level
 /// @param level The log level
@@ -143,23 +441,33 @@ inline auto initLogLevel(LogLevel level) { set_log_level(level); }
 
 /// @brief Check if the log level allows for trace messages
 /// @return `true` if the log level allows for trace messages
-inline auto trace_enabled() { return LVL_TRACE >= getLogLevel(); }
+inline auto trace_enabled() -> bool {
+  return compiled_in(LVL_TRACE) && LVL_TRACE >= getLogLevel();
+}
 
 /// @brief Check if the log level allows for debug messages
 /// @return `true` if the log level allows for debug messages
-inline auto debug_enabled() { return LVL_DEBUG >= getLogLevel(); }
+inline auto debug_enabled() -> bool {
+  return compiled_in(LVL_DEBUG) && LVL_DEBUG >= getLogLevel();
+}
 
 /// @brief Check if the log level allows for info messages
 /// @return `true` if the log level allows for info messages
-inline auto info_enabled() { return LVL_INFO >= getLogLevel(); }
+inline auto info_enabled() -> bool {
+  return compiled_in(LVL_INFO) && LVL_INFO >= getLogLevel();
+}
 
 /// @brief Check if the log level allows for warn messages
 /// @return `true` if the log level allows for warn messages
-inline auto warn_enabled() { return LVL_WARN >= getLogLevel(); }
+inline auto warn_enabled() -> bool {
+  return compiled_in(LVL_WARN) && LVL_WARN >= getLogLevel();
+}
 
 /// @brief Check if the log level allows for error messages
 /// @return `true` if the log level allows for error messages
-inline auto error_enabled() { return LVL_ERROR >= getLogLevel(); }
+inline auto error_enabled() -> bool {
+  return compiled_in(LVL_ERROR) && LVL_ERROR >= getLogLevel();
+}
 
 /// @brief Log a trace message to the console
 /// @param str The string to log
@@ -191,6 +499,67 @@ inline auto error(string_view str) {
   if (error_enabled()) log(LVL_ERROR, str);
 }
 
+/// @brief Format and log a message, unless its level is disabled: the level
+/// is checked before any argument is formatted, and levels below
+/// `MIN_LOG_LEVEL` compile to nothing
+/// @tparam level The log level
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <LogLevel level, typename... Args>
+inline void log_lazy(fmt::format_string<Args...> format_str, Args&&... args) {
+  if constexpr (compiled_in(level)) {
+    if (level >= getLogLevel()) [[unlikely]] {
+      log_message(level, fmt::format(format_str, std::forward<Args>(args)...));
+    }
+  }
+}
+
+/// @brief Log a formatted trace message to the console, e.g.
+/// `trace("Mouse moved to ({}, {})", x, y)`. Nothing is formatted unless
+/// trace messages are enabled.
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <typename... Args>
+inline auto trace(fmt::format_string<Args...> format_str, Args&&... args) {
+  log_lazy<LVL_TRACE, Args...>(format_str, std::forward<Args>(args)...);
+}
+
+/// @brief Log a formatted debug message to the console (only formatted if
+/// debug messages are enabled)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <typename... Args>
+inline auto debug(fmt::format_string<Args...> format_str, Args&&... args) {
+  log_lazy<LVL_DEBUG, Args...>(format_str, std::forward<Args>(args)...);
+}
+
+/// @brief Log a formatted info message to the console (only formatted if
+/// info messages are enabled)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <typename... Args>
+inline auto info(fmt::format_string<Args...> format_str, Args&&... args) {
+  log_lazy<LVL_INFO, Args...>(format_str, std::forward<Args>(args)...);
+}
+
+/// @brief Log a formatted warning message to the console (only formatted if
+/// warning messages are enabled)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <typename... Args>
+inline auto warn(fmt::format_string<Args...> format_str, Args&&... args) {
+  log_lazy<LVL_WARN, Args...>(format_str, std::forward<Args>(args)...);
+}
+
+/// @brief Log a formatted error message to the console (only formatted if
+/// error messages are enabled)
+/// @param format_str The format string (checked at compile time)
+/// @param args The arguments to format
+template <typename... Args>
+inline auto error(fmt::format_string<Args...> format_str, Args&&... args) {
+  log_lazy<LVL_ERROR, Args...>(format_str, std::forward<Args>(args)...);
+}
+
 /// @brief Log a debug message to the console
 /// @param strings The strings to log
 inline auto debug(vector<string_view> strings) {
@@ -216,18 +585,21 @@ inline auto error(vector<string_view> strings) {
 }
 
 /// @brief Log system initialization information (window size, map size, etc.)
-auto init() -> void {
+/// @param sinks Where log messages are written (the console if empty), e.g.
+///              a `FileSink` for long runs.
+inline auto init(vector<unique_ptr<LogSink>> sinks = {}) -> void {
   // TODO: move to config / args / env
   set_log_level(tracing::LogLevel::LVL_DEBUG);
+  if (!sinks.empty()) set_log_sinks(std::move(sinks));
+  start_async_logging();
   // set to trace for enhanced debugging
   //   set_log_level(tracing::LogLevel::LVL_TRACE);
 
-  info(format("Initializing {}", config::WINDOW_TITLE));
-  info(format("Window size: {}x{}", config::WINDOW_WIDTH,
-              config::WINDOW_HEIGHT));
-  debug(format("Map size: {}x{}", config::MAP_WIDTH, config::MAP_HEIGHT));
-  debug(format("Max FPS: {}", config::MAX_FPS));
-  debug(format("Debug mode: {}", config::DEBUG_MODE));
+  info("Initializing {}", config::WINDOW_TITLE);
+  info("Window size: {}x{}", config::WINDOW_WIDTH, config::WINDOW_HEIGHT);
+  debug("Map size: {}x{}", config::MAP_WIDTH, config::MAP_HEIGHT);
+  debug("Max FPS: {}", config::MAX_FPS);
+  debug("Debug mode: {}", config::DEBUG_MODE);
 
   trace("Starting main loop...");
 }
@@ -0,0 +1,103 @@
+#include "driver/assets.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+#include "SFML/Graphics.hpp"
+
+using driver::AssetManager;
+using driver::AssetState;
+using driver::ShelfPacker;
+
+// -----------------------------------------------------------------------------
+// Shelf packer
+// -----------------------------------------------------------------------------
+
+TEST(ShelfPacker, FillsAShelfLeftToRight) {
+    constexpr auto pad = config::ATLAS_PADDING;
+    ShelfPacker packer(100, 100);
+
+    const auto first = packer.pack(10, 20);
+    const auto second = packer.pack(30, 5);
+    ASSERT_TRUE(first && second);
+    EXPECT_EQ(*first, sf::Vector2u(0, 0));
+    EXPECT_EQ(*second, sf::Vector2u(10 + pad, 0));
+}
+
+TEST(ShelfPacker, StartsANewShelfBelowTheTallestEntry) {
+    constexpr auto pad = config::ATLAS_PADDING;
+    ShelfPacker packer(100, 100);
+
+    ASSERT_TRUE(packer.pack(40, 10));
+    ASSERT_TRUE(packer.pack(40, 30));
+    // doesn't fit next to the first two, so goes below the taller one
+    const auto wrapped = packer.pack(40, 10);
+    ASSERT_TRUE(wrapped);
+    EXPECT_EQ(*wrapped, sf::Vector2u(0, 30 + pad));
+
+    const auto next = packer.pack(10, 10);
+    ASSERT_TRUE(next);
+    EXPECT_EQ(*next, sf::Vector2u(40 + pad, 30 + pad));
+}
+
+TEST(ShelfPacker, RejectsWhatDoesNotFit) {
+    ShelfPacker packer(64, 64);
+
+    // wider than the whole area (the padding counts)
+    EXPECT_FALSE(packer.pack(64, 1));
+
+    // fill the area with 4 shelves, the fifth doesn't fit
+    for (int shelf = 0; shelf < 4; shelf++) {
+        ASSERT_TRUE(packer.pack(40, 15));
+    }
+    EXPECT_FALSE(packer.pack(40, 15));
+    // nor does anything once the shelves below are used up
+    EXPECT_FALSE(packer.pack(1, 1));
+}
+
+// -----------------------------------------------------------------------------
+// Asset manager
+// -----------------------------------------------------------------------------
+
+TEST(AssetManager, DeduplicatesRequestsByPath) {
+    AssetManager assets;
+
+    const auto ball = assets.request_texture("assets/ball0.png");
+    const auto logo = assets.request_texture("assets/logo.png");
+    EXPECT_NE(ball, logo);
+
+    // the same path (even built at runtime) is only loaded once
+    const auto path = std::string("assets/") + "ball0.png";
+    EXPECT_EQ(assets.request_texture(path), ball);
+    EXPECT_EQ(assets.request_texture("assets/logo.png"), logo);
+}
+
+TEST(AssetManager, RequestsOfADifferentKindOrSizeAreNotShared) {
+    AssetManager assets;
+
+    const auto small = assets.request_texture("assets/ball0.png", 64);
+    const auto large = assets.request_texture("assets/ball0.png", 1024);
+    EXPECT_NE(small, large);
+    EXPECT_EQ(assets.request_texture("assets/ball0.png", 64), small);
+
+    // a font at a texture's path is a font, not the texture
+    const auto font = assets.request_font("assets/ball0.png");
+    EXPECT_NE(font, small);
+    EXPECT_NE(font, large);
+    EXPECT_EQ(assets.request_font("assets/ball0.png"), font);
+}
+
+TEST(AssetManager, MissingFilesFail) {
+    AssetManager assets;
+
+    const auto missing = assets.request_texture("assets/does_not_exist.png");
+    EXPECT_EQ(assets.state(missing), AssetState::Loading);
+    EXPECT_FALSE(assets.idle());
+
+    while (assets.poll() == 0) std::this_thread::yield();
+    EXPECT_EQ(assets.state(missing), AssetState::Failed);
+    EXPECT_EQ(assets.texture(missing), nullptr);
+    EXPECT_TRUE(assets.idle());
+}
@@ -0,0 +1,181 @@
+#include "driver/frame_export.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+using driver::ExportOptions;
+using driver::FrameExporter;
+using driver::FrameFormat;
+
+namespace fs = std::filesystem;
+
+constexpr unsigned kWidth = 64;
+constexpr unsigned kHeight = 128;
+constexpr size_t kFrameBytes = size_t{kWidth} * kHeight * 4;
+
+/// @brief A frame whose pixels encode its index (red = low byte, green =
+/// high byte).
+static auto numbered_frame(uint32_t index) -> sf::Image {
+    sf::Image image;
+    image.create(kWidth, kHeight,
+                 sf::Color(index & 0xff, (index >> 8) & 0xff, 0));
+    return image;
+}
+
+/// @brief Checks that `bytes` holds `count` numbered frames, in order.
+static auto expect_frames_in_order(const std::vector<char>& bytes,
+                                   uint32_t count) -> void {
+    ASSERT_EQ(bytes.size(), count * kFrameBytes);
+    for (uint32_t frame = 0; frame < count; frame++) {
+        const auto* pixels = reinterpret_cast<const uint8_t*>(bytes.data()) +
+                             frame * kFrameBytes;
+        ASSERT_EQ(pixels[0], frame & 0xff) << "frame " << frame;
+        ASSERT_EQ(pixels[1], (frame >> 8) & 0xff) << "frame " << frame;
+        ASSERT_EQ(pixels[kFrameBytes - 4], frame & 0xff) << "frame " << frame;
+    }
+}
+
+static auto raw_options(const fs::path& output) -> ExportOptions {
+    ExportOptions options;
+    options.output = output.string();
+    options.format = FrameFormat::Raw;
+    return options;
+}
+
+// -----------------------------------------------------------------------------
+// Raw export
+// -----------------------------------------------------------------------------
+
+TEST(FrameExporter, LeavesStdoutUsableAfterExportingToIt) {
+    // Log to stderr and send stdout to a file while exporting to `-`
+    std::vector<std::unique_ptr<tracing::LogSink>> sinks;
+    sinks.push_back(std::make_unique<tracing::ConsoleSink>(stderr));
+    tracing::set_log_sinks(std::move(sinks));
+    const auto path = fs::temp_directory_path() /
+                      ("frame_export_" + std::to_string(getpid()) + ".out");
+    std::fflush(stdout);
+    const auto saved = dup(STDOUT_FILENO);
+    const auto file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    ASSERT_GE(file, 0);
+    dup2(file, STDOUT_FILENO);
+    close(file);
+
+    constexpr uint32_t kFrames = 3;
+    {
+        FrameExporter exporter(raw_options("-"));
+        for (uint32_t frame = 0; frame < kFrames; frame++) {
+            exporter.submit(numbered_frame(frame));
+        }
+    }
+    // stdout still writes through a buffer the exporter didn't own
+    std::fputs("after export\n", stdout);
+    std::fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    sinks.clear();
+    sinks.push_back(std::make_unique<tracing::ConsoleSink>());
+    tracing::set_log_sinks(std::move(sinks));
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> bytes{std::istreambuf_iterator<char>(in),
+                            std::istreambuf_iterator<char>()};
+    fs::remove(path);
+    const std::string trailer = "after export\n";
+    ASSERT_GE(bytes.size(), trailer.size());
+    EXPECT_EQ(std::string(bytes.end() - trailer.size(), bytes.end()), trailer);
+    bytes.resize(bytes.size() - trailer.size());
+    expect_frames_in_order(bytes, kFrames);
+}
+
+TEST(FrameExporter, WritesRawFramesInOrder) {
+    const auto path = fs::temp_directory_path() /
+                      ("frame_export_" + std::to_string(getpid()) + ".rgba");
+    constexpr uint32_t kFrames = 300;
+    {
+        FrameExporter exporter(raw_options(path));
+        for (uint32_t frame = 0; frame < kFrames; frame++) {
+            exporter.submit(numbered_frame(frame));
+        }
+        exporter.finish();
+        EXPECT_EQ(exporter.frames_submitted(), kFrames);
+        // finishing again (and on destruction) is a no-op
+        exporter.finish();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> bytes{std::istreambuf_iterator<char>(file),
+                                  std::istreambuf_iterator<char>()};
+    expect_frames_in_order(bytes, kFrames);
+    fs::remove(path);
+}
+
+TEST(FrameExporter, SubmitWaitsForAFullQueueWithoutDroppingFrames) {
+    // A pipe nobody reads from yet stalls the writer once the write buffer
+    // and the pipe are full
+    const auto path = fs::temp_directory_path() /
+                      ("frame_export_" + std::to_string(getpid()) + ".fifo");
+    fs::remove(path);
+    ASSERT_EQ(mkfifo(path.c_str(), 0600), 0);
+    const auto reader = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    ASSERT_GE(reader, 0);
+
+    const auto buffered = config::EXPORT_WRITE_BUFFER_SIZE / kFrameBytes;
+    const auto frames = static_cast<uint32_t>(
+        buffered + 4 * config::EXPORT_QUEUE_DEPTH + 64);
+    FrameExporter exporter(raw_options(path));
+    std::atomic<uint32_t> submitted = 0;
+    std::thread producer([&] {
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            exporter.submit(numbered_frame(frame));
+            submitted++;
+        }
+    });
+
+    // Wait until submitting stalls
+    auto last = submitted.load();
+    for (int quiet = 0; quiet < 5;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        const auto now = submitted.load();
+        quiet = now == last ? quiet + 1 : 0;
+        last = now;
+    }
+    EXPECT_LT(last, frames) << "submit() returned with the writer stalled";
+    // Everything the writer has not taken yet is queued
+    EXPECT_GE(last, config::EXPORT_QUEUE_DEPTH);
+    EXPECT_LE(last, buffered + config::EXPORT_QUEUE_DEPTH + 64);
+
+    // Drain the pipe: every frame arrives, in order
+    fcntl(reader, F_SETFL, fcntl(reader, F_GETFL) & ~O_NONBLOCK);
+    std::vector<char> bytes;
+    std::thread drain([&] {
+        std::vector<char> chunk(1 << 16);
+        ssize_t read_bytes;
+        while ((read_bytes = read(reader, chunk.data(), chunk.size())) > 0) {
+            bytes.insert(bytes.end(), chunk.begin(),
+                         chunk.begin() + read_bytes);
+        }
+    });
+    producer.join();
+    exporter.finish();
+    drain.join();
+    close(reader);
+    fs::remove(path);
+
+    EXPECT_EQ(submitted.load(), frames);
+    expect_frames_in_order(bytes, frames);
+}
@@ -0,0 +1,163 @@
+#include "driver/profiler.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using driver::compute_stats;
+using driver::FrameProfiler;
+using driver::Phase;
+using driver::SampleRing;
+
+// -----------------------------------------------------------------------------
+// Sample ring
+// -----------------------------------------------------------------------------
+
+TEST(SampleRing, SnapshotIsOldestFirst) {
+    SampleRing ring;
+    EXPECT_TRUE(ring.snapshot().empty());
+
+    ring.push(1.0f);
+    ring.push(2.0f);
+    ring.push(3.0f);
+    EXPECT_EQ(ring.written(), 3);
+    EXPECT_EQ(ring.snapshot(), (std::vector<float>{1.0f, 2.0f, 3.0f}));
+}
+
+TEST(SampleRing, OverwritesTheOldestOnceFull) {
+    constexpr auto history = config::PROFILER_HISTORY;
+    SampleRing ring;
+    for (size_t i = 0; i < history + 10; i++) {
+        ring.push(static_cast<float>(i));
+    }
+    EXPECT_EQ(ring.written(), history + 10);
+
+    // only the most recent `history` samples are kept, still oldest first
+    const auto samples = ring.snapshot();
+    ASSERT_EQ(samples.size(), history);
+    for (size_t i = 0; i < history; i++) {
+        EXPECT_EQ(samples[i], static_cast<float>(i + 10));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Percentiles
+// -----------------------------------------------------------------------------
+
+TEST(ComputeStats, EmptySamplesAreZero) {
+    std::vector<float> samples;
+    const auto stats = compute_stats(samples);
+    EXPECT_EQ(stats.p50, 0.0f);
+    EXPECT_EQ(stats.p99, 0.0f);
+    EXPECT_EQ(stats.max, 0.0f);
+}
+
+TEST(ComputeStats, PercentilesOfUnorderedSamples) {
+    // 0..100 in a scrambled order
+    std::vector<float> samples;
+    for (int i = 0; i <= 100; i++) {
+        samples.push_back(static_cast<float>((i * 37) % 101));
+    }
+    const auto stats = compute_stats(samples);
+    EXPECT_EQ(stats.p50, 50.0f);
+    EXPECT_EQ(stats.p95, 95.0f);
+    EXPECT_EQ(stats.p99, 99.0f);
+    EXPECT_EQ(stats.max, 100.0f);
+}
+
+TEST(ComputeStats, SingleSample) {
+    std::vector<float> samples = {7.5f};
+    const auto stats = compute_stats(samples);
+    EXPECT_EQ(stats.p50, 7.5f);
+    EXPECT_EQ(stats.p99, 7.5f);
+    EXPECT_EQ(stats.max, 7.5f);
+}
+
+// -----------------------------------------------------------------------------
+// Frame profiler
+// -----------------------------------------------------------------------------
+
+TEST(FrameProfiler, StatsArePerPhase) {
+    FrameProfiler profiler;
+    for (int i = 1; i <= 100; i++) {
+        profiler.record(Phase::Render, static_cast<float>(i));
+    }
+    profiler.record(Phase::Events, 5.0f);
+
+    const auto render = profiler.stats(Phase::Render);
+    EXPECT_EQ(render.p50, 50.0f);
+    EXPECT_EQ(render.max, 100.0f);
+    EXPECT_EQ(profiler.stats(Phase::Events).max, 5.0f);
+    EXPECT_EQ(profiler.stats(Phase::Display).max, 0.0f);
+}
+
+TEST(FrameProfiler, DiscardedScopesRecordNothing) {
+    FrameProfiler profiler;
+    profiler.record(Phase::Frame, 1000.0f);
+    profiler.record(Phase::Simulation, 1000.0f);
+    {
+        auto kept = profiler.measure(Phase::Simulation);
+        auto skipped = profiler.measure(Phase::Frame);
+        skipped.discard();
+    }
+    // a near-zero second sample would become the median
+    EXPECT_EQ(profiler.stats(Phase::Frame).p50, 1000.0f);
+    EXPECT_LT(profiler.stats(Phase::Simulation).p50, 1000.0f);
+}
+
+TEST(FrameProfiler, SkippedFramesKeepThePhasesAligned) {
+    // Like `GameState::tick()`: every phase of a skipped frame is discarded
+    FrameProfiler profiler;
+    size_t drawn = 0;
+    for (int i = 0; i < 20; i++) {
+        const auto skipped = i % 3 != 0;
+        auto frame = profiler.measure(Phase::Frame);
+        auto events = profiler.measure(Phase::Events);
+        events.stop();
+        auto simulation = profiler.measure(Phase::Simulation);
+        // only drawn frames simulate anything measurable
+        if (!skipped) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        simulation.stop();
+        if (skipped) {
+            frame.discard();
+            events.discard();
+            simulation.discard();
+            continue;
+        }
+        drawn++;
+        auto rendering = profiler.measure(Phase::Render);
+        rendering.stop();
+        auto presenting = profiler.measure(Phase::Display);
+    }
+
+    const auto path = testing::TempDir() + "profiler_aligned.csv";
+    ASSERT_TRUE(profiler.write_csv(path));
+    std::ifstream csv(path);
+    std::string line;
+    std::getline(csv, line);
+    EXPECT_EQ(line, "sample,events_us,simulation_us,render_us,display_us,"
+                    "frame_us");
+    size_t rows = 0;
+    while (std::getline(csv, line)) {
+        std::istringstream row(line);
+        std::vector<std::string> cells;
+        for (std::string cell; std::getline(row, cell, ',');) {
+            cells.push_back(cell);
+        }
+        ASSERT_EQ(cells.size(), 6u) << line;
+        for (const auto& cell : cells) EXPECT_FALSE(cell.empty()) << line;
+        // each row is one drawn frame
+        const auto simulation = std::stof(cells[2]);
+        EXPECT_GE(simulation, 2000.0f) << line;
+        EXPECT_GE(std::stof(cells[5]), simulation) << line;
+        rows++;
+    }
+    EXPECT_EQ(rows, drawn);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,155 @@
+#include "driver/replay.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "SFML/Graphics.hpp"
+
+using std::make_unique;
+
+using sf::Vector2f;
+
+using driver::SearchReplay;
+using graph::DirectedAcyclicGraph;
+using graph::INVALID_NODE;
+using graph::Node;
+using graph::StepKind;
+
+// -----------------------------------------------------------------------------
+// Search replay
+// -----------------------------------------------------------------------------
+
+/// @brief Records `count` push steps (for nodes 0, 1, ...) and polls them.
+static auto record_pushes(SearchReplay& replay, graph::NodeId count) -> void {
+    for (graph::NodeId node = 0; node < count; node++) {
+        replay.recorder().record(StepKind::Push, node, INVALID_NODE, 0.0f);
+    }
+    replay.poll();
+}
+
+TEST(SearchReplay, PollMovesStepsOntoTheTimeline) {
+    SearchReplay replay(16);
+    EXPECT_TRUE(replay.finished());
+
+    replay.recorder().record(StepKind::Push, 0, INVALID_NODE, 0.0f);
+    EXPECT_EQ(replay.size(), 0);
+    EXPECT_FALSE(replay.finished());  // a step is waiting to be polled
+
+    replay.poll();
+    EXPECT_EQ(replay.size(), 1);
+    EXPECT_EQ(replay.position(), 0);
+    EXPECT_FALSE(replay.finished());
+}
+
+TEST(SearchReplay, UpdateAdvancesAtTheSetSpeed) {
+    SearchReplay replay(64);
+    record_pushes(replay, 40);
+
+    replay.set_speed(10.0f);
+    replay.update(0.5f);
+    EXPECT_EQ(replay.position(), 5);
+
+    // slow speeds still advance, a fraction of a step at a time
+    replay.set_speed(1.0f);
+    replay.update(0.5f);
+    EXPECT_EQ(replay.position(), 5);
+    replay.update(0.5f);
+    EXPECT_EQ(replay.position(), 6);
+
+    // the cursor stops at the end of what was recorded
+    replay.set_speed(1000.0f);
+    replay.update(1.0f);
+    EXPECT_EQ(replay.position(), 40);
+    EXPECT_TRUE(replay.finished());
+}
+
+TEST(SearchReplay, PausedPlaybackDoesNotMove) {
+    SearchReplay replay(16);
+    record_pushes(replay, 10);
+
+    replay.toggle_pause();
+    EXPECT_TRUE(replay.paused());
+    replay.update(1.0f);
+    EXPECT_EQ(replay.position(), 0);
+
+    replay.toggle_pause();
+    replay.set_speed(4.0f);
+    replay.update(1.0f);
+    EXPECT_EQ(replay.position(), 4);
+}
+
+TEST(SearchReplay, SpeedIsClamped) {
+    SearchReplay replay(16);
+    replay.set_speed(0.0f);
+    EXPECT_EQ(replay.speed(), config::MIN_REPLAY_SPEED);
+    replay.set_speed(1e9f);
+    EXPECT_EQ(replay.speed(), config::MAX_REPLAY_SPEED);
+}
+
+TEST(SearchReplay, SeekAndScrubStayOnTheTimeline) {
+    SearchReplay replay(16);
+    record_pushes(replay, 10);
+
+    replay.seek(7);
+    EXPECT_EQ(replay.position(), 7);
+    replay.seek(100);
+    EXPECT_EQ(replay.position(), 10);
+
+    replay.scrub(-3);
+    EXPECT_EQ(replay.position(), 7);
+    replay.scrub(-100);
+    EXPECT_EQ(replay.position(), 0);
+    replay.scrub(100);
+    EXPECT_EQ(replay.position(), 10);
+}
+
+TEST(SearchReplay, CountsStepsDroppedByTheRecorder) {
+    SearchReplay replay(4);
+    for (graph::NodeId node = 0; node < 6; node++) {
+        replay.recorder().record(StepKind::Push, node, INVALID_NODE, 0.0f);
+    }
+    EXPECT_EQ(replay.dropped(), 2);
+    replay.poll();
+    EXPECT_EQ(replay.size(), 4);
+}
+
+TEST(SearchReplay, ApplyPaintsTheStateAtTheCursor) {
+    sf::RenderTexture target;
+    DirectedAcyclicGraph graph(
+        &target, nullptr, make_unique<Node>(target, Vector2f(0.0f, 0.0f)),
+        make_unique<Node>(target, Vector2f(10.0f, 0.0f)));
+    for (const auto& node : graph.nodes()) {
+        node->set_color(driver::UNVISITED_COLOR);
+    }
+    const auto source = graph.source()->id();
+    const auto goal = graph.target()->id();
+    auto color_of = [&](graph::NodeId id) {
+        return graph.node(id)->sprite()->getColor();
+    };
+
+    SearchReplay replay(16);
+    auto& recorder = replay.recorder();
+    recorder.record(StepKind::Push, source, INVALID_NODE, 0.0f);
+    recorder.record(StepKind::Pop, source, INVALID_NODE, 0.0f);
+    recorder.record(StepKind::Settle, source, INVALID_NODE, 0.0f);
+    recorder.record(StepKind::Relax, goal, source, 10.0f);
+    recorder.record(StepKind::PathFound, goal, source, 10.0f);
+    replay.poll();
+
+    replay.seek(2);
+    replay.apply(graph);
+    EXPECT_EQ(color_of(source), driver::EXPANDING_COLOR);
+    EXPECT_EQ(color_of(goal), driver::UNVISITED_COLOR);
+
+    replay.seek(5);
+    replay.apply(graph);
+    EXPECT_EQ(color_of(source), driver::SETTLED_COLOR);
+    EXPECT_EQ(color_of(goal), driver::PATH_COLOR);
+
+    // moving backwards repaints from the start of the timeline
+    replay.seek(1);
+    replay.apply(graph);
+    EXPECT_EQ(color_of(source), driver::FRONTIER_COLOR);
+    EXPECT_EQ(color_of(goal), driver::UNVISITED_COLOR);
+}
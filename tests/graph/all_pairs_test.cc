@@ -0,0 +1,116 @@
+#include "graph/all_pairs.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "tests/graph/test_graphs.h"
+
+using graph::CsrGraph;
+using graph::DistanceMatrix;
+using graph::INF;
+using graph::WeightedEdge;
+using test_graphs::random_graph;
+
+/// @brief The textbook triple loop.
+static auto naive_floyd_warshall(DistanceMatrix matrix) -> DistanceMatrix {
+    const auto n = matrix.size();
+    for (size_t k = 0; k < n; k++) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                matrix.at(i, j) =
+                    std::min(matrix(i, j), matrix(i, k) + matrix(k, j));
+            }
+        }
+    }
+    return matrix;
+}
+
+static auto expect_near(const DistanceMatrix& actual,
+                        const DistanceMatrix& expected) -> void {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        for (size_t j = 0; j < expected.size(); j++) {
+            if (expected(i, j) == INF) {
+                ASSERT_EQ(actual(i, j), INF) << i << " -> " << j;
+            } else {
+                ASSERT_NEAR(actual(i, j), expected(i, j), 1e-3f)
+                    << i << " -> " << j;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Adjacency matrix
+//------------------------------------------------------------------------------
+
+TEST(AdjacencyMatrix, KeepsTheCheapestEdge) {
+    const auto graph = CsrGraph::from_edges(
+        3, {{0, 1, 5.0f}, {0, 1, 2.0f}, {1, 2, 1.0f}});
+    const auto matrix = graph::adjacency_matrix(graph);
+    EXPECT_EQ(matrix.size(), 3u);
+    EXPECT_EQ(matrix.stride() % config::APSP_TILE_SIZE, 0u);
+    EXPECT_EQ(matrix(0, 0), 0.0f);
+    EXPECT_EQ(matrix(0, 1), 2.0f);
+    EXPECT_EQ(matrix(1, 2), 1.0f);
+    EXPECT_EQ(matrix(2, 0), INF);
+}
+
+//------------------------------------------------------------------------------
+// All-pairs shortest paths
+//------------------------------------------------------------------------------
+
+TEST(AllPairs, BlockedFloydWarshallMatchesTripleLoop) {
+    // a size that isn't a multiple of the tile size
+    const auto graph = random_graph(150, 600, 3, {0.0f, 10.0f, false});
+    auto matrix = graph::adjacency_matrix(graph);
+    const auto expected = naive_floyd_warshall(matrix);
+
+    graph::floyd_warshall(matrix);
+    expect_near(matrix, expected);
+
+    auto scalar = graph::adjacency_matrix(graph);
+    graph::floyd_warshall(scalar, 1);
+    expect_near(scalar, expected);
+}
+
+TEST(AllPairs, JohnsonMatchesFloydWarshall) {
+    // edges only go to larger ids, so negative ones cannot form a cycle
+    std::vector<WeightedEdge> edges;
+    std::mt19937 rng(5);
+    for (uint32_t to = 1; to < 100; to++) {
+        for (int i = 0; i < 3; i++) {
+            edges.push_back({uint32_t(rng() % to), to, float(rng() % 20) - 5});
+        }
+    }
+    const auto graph = CsrGraph::from_edges(100, edges);
+
+    auto expected = graph::adjacency_matrix(graph);
+    graph::floyd_warshall(expected);
+    const auto distances = graph::johnson(graph);
+    ASSERT_TRUE(distances.has_value());
+    expect_near(*distances, expected);
+}
+
+TEST(AllPairs, JohnsonDetectsNegativeCycles) {
+    const auto graph = CsrGraph::from_edges(
+        3, {{0, 1, 1.0f}, {1, 2, -3.0f}, {2, 0, 1.0f}});
+    EXPECT_FALSE(graph::johnson(graph).has_value());
+}
+
+TEST(AllPairs, JohnsonLeavesTheCallersSearchAlone) {
+    // a search the caller is still reading from its thread's context
+    auto& context = graph::search_context();
+    context.begin(4);
+    context.relax(1, 2.0f, 0);
+    const auto epoch = context.epoch();
+
+    const auto graph = CsrGraph::from_edges(
+        3, {{0, 1, 1.0f}, {1, 2, 2.0f}, {2, 0, 4.0f}});
+    ASSERT_TRUE(graph::johnson(graph, 4).has_value());
+    EXPECT_EQ(context.epoch(), epoch);
+    EXPECT_EQ(context.cost(1), 2.0f);
+    EXPECT_EQ(context.parent(1), 0u);
+}
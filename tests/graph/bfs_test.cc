@@ -0,0 +1,116 @@
+#include "graph/bfs.h"
+
+#include <gtest/gtest.h>
+
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using graph::BitAdjacency;
+using graph::CsrGraph;
+using graph::NodeId;
+using graph::UNREACHABLE;
+using graph::WeightedEdge;
+
+/// @brief A random low-diameter graph (every node has a few random edges).
+static auto random_graph(uint32_t num_nodes, size_t degree) -> CsrGraph {
+    std::mt19937 rng(11);
+    std::vector<WeightedEdge> edges;
+    for (uint32_t from = 0; from < num_nodes; from++) {
+        for (size_t i = 0; i < degree; i++) {
+            edges.push_back({from, uint32_t(rng() % num_nodes), 1.0f});
+        }
+    }
+    return CsrGraph::from_edges(num_nodes, edges);
+}
+
+/// @brief A plain queue-based BFS.
+static auto scalar_bfs(const CsrGraph& graph, NodeId source)
+    -> std::vector<uint32_t> {
+    std::vector<uint32_t> hops(graph.num_nodes(), UNREACHABLE);
+    std::queue<NodeId> queue;
+    hops[source] = 0;
+    queue.push(source);
+    while (!queue.empty()) {
+        const auto node = queue.front();
+        queue.pop();
+        graph.for_each_arc(node, [&](NodeId next, float) {
+            if (hops[next] != UNREACHABLE) return;
+            hops[next] = hops[node] + 1;
+            queue.push(next);
+        });
+    }
+    return hops;
+}
+
+//------------------------------------------------------------------------------
+// Bit-packed adjacency
+//------------------------------------------------------------------------------
+
+TEST(BitAdjacency, PacksEdgesBothWays) {
+    const auto graph = CsrGraph::from_edges(
+        70, {{0, 1, 1.0f}, {0, 69, 1.0f}, {0, 69, 2.0f}, {65, 0, 1.0f}});
+    const auto adjacency = BitAdjacency::from(graph);
+    EXPECT_EQ(adjacency.words(), 2u);
+    EXPECT_TRUE(adjacency.has_edge(0, 69));
+    EXPECT_FALSE(adjacency.has_edge(69, 0));
+    EXPECT_EQ(adjacency.out_degree(0), 2u) << "parallel edges count once";
+    EXPECT_EQ(adjacency.in(0)[1], uint64_t{1} << 1);
+}
+
+//------------------------------------------------------------------------------
+// BFS
+//------------------------------------------------------------------------------
+
+TEST(Bfs, MatchesScalarBfsInBothDirections) {
+    const auto graph = random_graph(2000, 8);
+    const auto adjacency = BitAdjacency::from(graph);
+    for (NodeId source : {0u, 17u, 1999u}) {
+        graph::BfsStats stats;
+        EXPECT_EQ(graph::bfs(adjacency, source, &stats),
+                  scalar_bfs(graph, source));
+        EXPECT_GT(stats.top_down_steps, 0u);
+        EXPECT_GT(stats.bottom_up_steps, 0u);
+    }
+
+    // a long path stays top-down (but for its last few steps, when the
+    // unexplored edges run out)
+    std::vector<WeightedEdge> path;
+    for (uint32_t node = 0; node + 1 < 100; node++) {
+        path.push_back({node, node + 1, 1.0f});
+    }
+    const auto line = CsrGraph::from_edges(100, path);
+    graph::BfsStats stats;
+    EXPECT_EQ(graph::bfs(BitAdjacency::from(line), 0, &stats),
+              scalar_bfs(line, 0));
+    EXPECT_LT(stats.bottom_up_steps * 5, stats.top_down_steps);
+}
+
+TEST(Bfs, MultiSourceMatchesSingleSource) {
+    const auto graph = random_graph(500, 3);
+    const auto adjacency = BitAdjacency::from(graph);
+    std::vector<NodeId> sources;
+    for (NodeId source = 0; source < 64; source++) {
+        sources.push_back(source * 7);
+    }
+    sources[63] = sources[0];  // duplicates are fine
+
+    const auto result = graph::multi_source_bfs(adjacency, sources);
+    ASSERT_EQ(result.num_sources(), 64u);
+    for (size_t i = 0; i < sources.size(); i++) {
+        const auto expected = scalar_bfs(graph, sources[i]);
+        for (NodeId node = 0; node < graph.num_nodes(); node++) {
+            ASSERT_EQ(result.hops(i, node), expected[node]);
+            ASSERT_EQ(result.reached_by(node) >> i & 1,
+                      expected[node] != UNREACHABLE);
+        }
+    }
+}
+
+TEST(Bfs, MultiSourceRejectsMoreThan64Sources) {
+    const auto adjacency = BitAdjacency::from(random_graph(100, 3));
+    std::vector<NodeId> sources(65, 0);
+    EXPECT_THROW(graph::multi_source_bfs(adjacency, sources),
+                 std::invalid_argument);
+}
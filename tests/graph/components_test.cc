@@ -0,0 +1,135 @@
+#include "graph/components.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "tests/graph/test_graphs.h"
+#include "utils/data_structures/union_find.h"
+
+using graph::Components;
+using graph::CsrGraph;
+using graph::INVALID_NODE;
+using graph::NodeId;
+using graph::WeightedEdge;
+using test_graphs::random_graph;
+
+/// @brief Checks that two labelings describe the same partition.
+static auto expect_same_partition(const Components& actual,
+                                  const Components& expected) -> void {
+    ASSERT_EQ(actual.num_components, expected.num_components);
+    ASSERT_EQ(actual.component.size(), expected.component.size());
+    // Each expected component maps to exactly one actual component
+    std::vector<uint32_t> mapping(expected.num_components, UINT32_MAX);
+    for (size_t node = 0; node < expected.component.size(); node++) {
+        auto& mapped = mapping[expected.component[node]];
+        if (mapped == UINT32_MAX) mapped = actual.component[node];
+        ASSERT_EQ(actual.component[node], mapped) << node;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Strongly connected components
+//------------------------------------------------------------------------------
+
+TEST(StronglyConnectedComponents, NumbersComponentsTopologically) {
+    // {0, 1, 2} -> {3, 4} -> 5, and 6 on its own with a self loop
+    const auto graph = CsrGraph::from_edges(
+        7, {{0, 1, 1}, {1, 2, 1}, {2, 0, 1}, {2, 3, 1}, {3, 4, 1},
+            {4, 3, 1}, {4, 5, 1}, {6, 6, 1}});
+    const auto components = graph::strongly_connected_components(graph);
+    ASSERT_EQ(components.num_components, 4u);
+    const auto& of = components.component;
+    EXPECT_EQ(of[0], of[1]);
+    EXPECT_EQ(of[1], of[2]);
+    EXPECT_EQ(of[3], of[4]);
+    EXPECT_LT(of[0], of[3]);
+    EXPECT_LT(of[3], of[5]);
+    EXPECT_FALSE(graph::is_acyclic(graph));
+
+    const auto dag = graph::condensation(graph, components);
+    EXPECT_EQ(dag.num_nodes(), 4u);
+    EXPECT_EQ(dag.num_edges(), 2u);
+    EXPECT_TRUE(graph::is_acyclic(dag));
+}
+
+TEST(StronglyConnectedComponents, HandlesDeepPaths) {
+    // Far deeper than a recursive search could go
+    constexpr uint32_t kLength = 1'000'000;
+    std::vector<WeightedEdge> edges;
+    for (uint32_t i = 0; i + 1 < kLength; i++) edges.push_back({i, i + 1, 1});
+    auto chain = CsrGraph::from_edges(kLength, edges);
+    EXPECT_EQ(graph::strongly_connected_components(chain).num_components,
+              kLength);
+    EXPECT_TRUE(graph::is_acyclic(chain));
+
+    edges.push_back({kLength - 1, 0, 1});
+    const auto cycle = CsrGraph::from_edges(kLength, edges);
+    EXPECT_EQ(graph::strongly_connected_components(cycle).num_components, 1u);
+    EXPECT_EQ(graph::parallel_strongly_connected_components(cycle, 4)
+                  .num_components,
+              1u);
+}
+
+TEST(StronglyConnectedComponents, CondensationIsTopologicallyOrdered) {
+    const auto graph = random_graph(3000, 4000, 1);
+    const auto components = graph::strongly_connected_components(graph);
+    const auto dag = graph::condensation(graph, components);
+    for (NodeId from = 0; from < dag.num_nodes(); from++) {
+        dag.for_each_arc(from, [&](NodeId to, float) { ASSERT_LT(from, to); });
+    }
+}
+
+TEST(ParallelStronglyConnectedComponents, MatchesTarjan) {
+    // From mostly trivial components to one giant component
+    for (size_t num_edges : {1000, 3000, 4000, 20000}) {
+        const auto graph = random_graph(3000, num_edges, 2);
+        const auto expected = graph::strongly_connected_components(graph);
+        for (size_t threads : {1, 4}) {
+            expect_same_partition(
+                graph::parallel_strongly_connected_components(graph, threads),
+                expected);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Weakly connected components
+//------------------------------------------------------------------------------
+
+TEST(WeaklyConnectedComponents, MatchesSequentialUnionFind) {
+    const auto graph = random_graph(5000, 3000, 3);
+    data_structures::sets::UnionFind sets(5000);
+    for (NodeId node = 0; node < 5000; node++) {
+        graph.for_each_arc(node,
+                           [&](NodeId to, float) { sets.unite(node, to); });
+    }
+
+    const auto components = graph::weakly_connected_components(graph, 4);
+    EXPECT_EQ(components.num_components, sets.num_sets());
+    for (NodeId node = 0; node < 5000; node++) {
+        for (auto other : {NodeId{0}, node / 2, sets.find(node)}) {
+            const auto& of = components.component;
+            ASSERT_EQ(of[node] == of[other], sets.same(node, other));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Pruning
+//------------------------------------------------------------------------------
+
+TEST(PruneUnreachable, KeepsNodesBetweenSourceAndTarget) {
+    // 0 -> 1 -> 3 is the only way through, 2 is a dead end, 4 unreachable
+    const auto graph = CsrGraph::from_edges(
+        5, {{0, 1, 1}, {1, 3, 2}, {0, 2, 1}, {4, 3, 1}});
+    const auto subgraph = graph::prune_unreachable(graph, 0, 3);
+    EXPECT_EQ(subgraph.original, (std::vector<NodeId>{0, 1, 3}));
+    EXPECT_EQ(subgraph.index[2], INVALID_NODE);
+    EXPECT_EQ(subgraph.index[4], INVALID_NODE);
+    EXPECT_EQ(subgraph.graph.num_edges(), 2u);
+    subgraph.graph.for_each_arc(subgraph.index[1], [&](NodeId to, float cost) {
+        EXPECT_EQ(to, subgraph.index[3]);
+        EXPECT_EQ(cost, 2.0f);
+    });
+}
@@ -0,0 +1,121 @@
+#include "graph/compressed_graph.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "graph/search.h"
+
+using graph::CompressedGraph;
+using graph::CsrGraph;
+using graph::NodeId;
+using graph::WeightedEdge;
+
+/// @brief A road-like grid: every node connects to its 4 neighbours, with
+/// random costs.
+static auto grid(uint32_t side) -> CsrGraph {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> cost(1.0f, 10.0f);
+    std::vector<WeightedEdge> edges;
+    for (uint32_t y = 0; y < side; y++) {
+        for (uint32_t x = 0; x < side; x++) {
+            const auto node = y * side + x;
+            if (x + 1 < side) edges.push_back({node, node + 1, cost(rng)});
+            if (x > 0) edges.push_back({node, node - 1, cost(rng)});
+            if (y + 1 < side) edges.push_back({node, node + side, cost(rng)});
+            if (y > 0) edges.push_back({node, node - side, cost(rng)});
+        }
+    }
+    return CsrGraph::from_edges(side * side, edges);
+}
+
+using Arcs = std::vector<std::pair<NodeId, float>>;
+
+template <typename Graph>
+static auto arcs(const Graph& graph, NodeId node) -> Arcs {
+    Arcs arcs;
+    graph.for_each_arc(node, [&](NodeId to, float cost) {
+        arcs.emplace_back(to, cost);
+    });
+    return arcs;
+}
+
+//------------------------------------------------------------------------------
+// Varints
+//------------------------------------------------------------------------------
+
+TEST(Varint, RoundTrips) {
+    std::vector<uint32_t> values = {0, 1, 127, 128, 16383, 16384, UINT32_MAX};
+    std::vector<uint8_t> bytes;
+    for (auto value : values) graph::encode_varint(value, bytes);
+    EXPECT_EQ(bytes.size(), 1u + 1 + 1 + 2 + 2 + 3 + 5);
+
+    const uint8_t* in = bytes.data();
+    for (auto value : values) EXPECT_EQ(graph::decode_varint(in), value);
+    EXPECT_EQ(in, bytes.data() + bytes.size());
+
+    for (int32_t value : {0, -1, 1, -1000, 1000, INT32_MIN, INT32_MAX}) {
+        EXPECT_EQ(graph::zigzag_decode(graph::zigzag_encode(value)), value);
+    }
+    EXPECT_EQ(graph::zigzag_encode(-1), 1u);
+}
+
+//------------------------------------------------------------------------------
+// Compressed graph
+//------------------------------------------------------------------------------
+
+TEST(CompressedGraph, DecodesTheSortedArcs) {
+    auto csr = grid(64);
+    const auto compressed = CompressedGraph::from(csr);
+    csr.sort_arcs();
+
+    ASSERT_EQ(compressed.num_nodes(), csr.num_nodes());
+    EXPECT_EQ(compressed.num_edges(), csr.num_edges());
+    for (NodeId node = 0; node < csr.num_nodes(); node++) {
+        ASSERT_EQ(arcs(compressed, node), arcs(csr, node)) << node;
+    }
+    EXPECT_LT(compressed.memory_bytes() * 4, csr.memory_bytes() * 3);
+}
+
+TEST(CompressedGraph, QuantizedCostsStayClose) {
+    const auto csr = grid(64);
+    const auto compressed =
+        CompressedGraph::from(csr, {.quantize_costs = true});
+    EXPECT_TRUE(compressed.quantized());
+    EXPECT_LT(compressed.memory_bytes() * 2, csr.memory_bytes());
+
+    // costs are in [1, 10], so each is off by at most 9 / 131068
+    graph::SearchContext exact;
+    graph::SearchContext approximate;
+    const NodeId target = 64 * 64 - 1;
+    const auto path = graph::dijkstra(csr, exact, 0, target);
+    const auto approximate_path =
+        graph::dijkstra(compressed, approximate, 0, target);
+    ASSERT_FALSE(path.empty());
+    ASSERT_FALSE(approximate_path.empty());
+    EXPECT_NEAR(approximate.cost(target), exact.cost(target),
+                path.size() * 9.0f / 131068.0f + 1e-3f);
+}
+
+TEST(CompressedGraph, QuantizedInfiniteCostsStayInfinite) {
+    // an impassable edge doesn't stretch the range of the others
+    const auto csr = CsrGraph::from_edges(
+        3, {{0, 1, 2.0f}, {0, 2, graph::INF}, {1, 2, 4.0f}});
+    const auto compressed =
+        CompressedGraph::from(csr, {.quantize_costs = true});
+    EXPECT_EQ(arcs(compressed, 0), (Arcs{{1, 2.0f}, {2, graph::INF}}));
+    EXPECT_EQ(arcs(compressed, 1), (Arcs{{2, 4.0f}}));
+
+    graph::SearchContext context;
+    const auto path = graph::dijkstra(compressed, context, 0, 2);
+    EXPECT_EQ(path, (std::vector<NodeId>{0, 1, 2}));
+    EXPECT_EQ(context.cost(2), 6.0f);
+
+    // nor does a graph whose only edges are impassable
+    const auto blocked =
+        CompressedGraph::from(CsrGraph::from_edges(2, {{0, 1, graph::INF}}),
+                              {.quantize_costs = true});
+    EXPECT_EQ(arcs(blocked, 0), (Arcs{{1, graph::INF}}));
+}
@@ -0,0 +1,142 @@
+#include "graph/concurrent_graph.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using graph::ConcurrentGraph;
+using graph::NodeId;
+
+//------------------------------------------------------------------------------
+// Concurrent graph
+//------------------------------------------------------------------------------
+
+TEST(ConcurrentGraph, UpdatesAreVisibleAfterPublish) {
+    ConcurrentGraph graph(2);
+    graph.set_edge(0, 1, 1.0f);
+    EXPECT_EQ(graph.read().num_edges(), 0u);
+
+    auto before = graph.read();
+    EXPECT_EQ(graph.publish(), 1u);
+    EXPECT_EQ(before.num_edges(), 0u) << "readers keep their version";
+
+    const auto node = graph.add_node();
+    graph.set_edge(0, 1, 2.0f);  // updates the existing edge
+    graph.set_edge(1, node, 3.0f);
+    graph.remove_edge(1, 0);  // no such edge
+    graph.publish();
+
+    auto reader = graph.read();
+    EXPECT_EQ(reader.version(), 2u);
+    EXPECT_EQ(reader.num_nodes(), 3u);
+    EXPECT_EQ(reader.num_edges(), 2u);
+    ASSERT_EQ(reader.arcs(0).size(), 1u);
+    EXPECT_EQ(reader.arcs(0)[0].cost, 2.0f);
+    EXPECT_EQ(reader.arcs(1)[0].to, node);
+
+    graph.remove_edge(0, 1);
+    graph.publish();
+    EXPECT_EQ(graph.read().num_edges(), 1u);
+    EXPECT_EQ(reader.num_edges(), 2u);
+}
+
+TEST(ConcurrentGraph, RejectsEdgesToMissingNodes) {
+    ConcurrentGraph graph(2);
+    EXPECT_THROW(graph.set_edge(0, 2, 1.0f), std::out_of_range);
+    EXPECT_THROW(graph.set_edge(5, 1, 1.0f), std::out_of_range);
+
+    graph.set_edge(graph.add_node(), 0, 1.0f);
+    graph.publish();
+    EXPECT_EQ(graph.read().num_nodes(), 3u);
+    EXPECT_EQ(graph.read().num_edges(), 1u);
+}
+
+TEST(ConcurrentGraph, ThreadsForgetDestroyedGraphs) {
+    // A fresh thread, so that no other test's graphs are in its buffers
+    std::thread([] {
+        {
+            ConcurrentGraph first(2);
+            first.set_edge(0, 1, 1.0f);
+            EXPECT_EQ(ConcurrentGraph::thread_buffer_count(), 1u);
+        }
+
+        // the destroyed graph's buffer is dropped once the thread writes to
+        // another graph
+        ConcurrentGraph second(2);
+        second.set_edge(0, 1, 1.0f);
+        EXPECT_EQ(ConcurrentGraph::thread_buffer_count(), 1u);
+    }).join();
+}
+
+TEST(ConcurrentGraph, DropsTheBuffersOfExitedWriters) {
+    ConcurrentGraph graph(2);
+    for (int i = 0; i < 10; i++) {
+        std::thread([&] { graph.set_edge(0, 1, static_cast<float>(i)); })
+            .join();
+    }
+    EXPECT_EQ(graph.writer_buffer_count(), 10u);
+
+    // their updates are still published
+    graph.publish();
+    EXPECT_EQ(graph.writer_buffer_count(), 0u);
+    ASSERT_EQ(graph.read().num_edges(), 1u);
+    EXPECT_EQ(graph.read().arcs(0)[0].cost, 9.0f);
+
+    // live writers keep theirs
+    graph.set_edge(1, 0, 1.0f);
+    graph.publish();
+    EXPECT_EQ(graph.writer_buffer_count(), 1u);
+    EXPECT_EQ(graph.read().num_edges(), 2u);
+}
+
+TEST(ConcurrentGraph, ReadersSeeConsistentVersions) {
+    // writers keep re-weighting edges (cost = from + to + round) while readers
+    // check that every version they see is internally consistent
+    constexpr NodeId kNodes = 200;
+    ConcurrentGraph graph(kNodes);
+    for (NodeId from = 0; from + 1 < kNodes; from++) {
+        graph.set_edge(from, from + 1, float(2 * from + 1));
+    }
+    graph.publish();
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                auto reader = graph.read();
+                ASSERT_GE(reader.version(), last);
+                last = reader.version();
+                ASSERT_EQ(reader.num_edges(), kNodes - 1);
+                for (NodeId from = 0; from + 1 < kNodes; from++) {
+                    const auto& arcs = reader.arcs(from);
+                    ASSERT_EQ(arcs.size(), 1u);
+                    ASSERT_EQ(arcs[0].to, from + 1);
+                    ASSERT_GE(arcs[0].cost, float(2 * from + 1));
+                }
+            }
+        });
+    }
+    for (int writer = 0; writer < 2; writer++) {
+        threads.emplace_back([&, writer] {
+            for (int round = 0; round < 200; round++) {
+                for (NodeId from = writer; from + 1 < kNodes; from += 2) {
+                    graph.set_edge(from, from + 1, float(2 * from + 1 + round));
+                }
+                graph.publish();
+            }
+        });
+    }
+    for (size_t i = 4; i < threads.size(); i++) threads[i].join();
+    done.store(true, std::memory_order_release);
+    for (size_t i = 0; i < 4; i++) threads[i].join();
+
+    auto reader = graph.read();
+    for (NodeId from = 0; from + 1 < kNodes; from++) {
+        EXPECT_EQ(reader.arcs(from)[0].cost, float(2 * from + 1 + 199));
+    }
+}
@@ -0,0 +1,116 @@
+#include "graph/csr.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "tests/graph/test_graphs.h"
+
+using graph::CsrBuildOptions;
+using graph::CsrGraph;
+using graph::NodeId;
+using test_graphs::random_edges;
+
+/// @brief Integer costs below 50, so that parallel edges often tie.
+constexpr test_graphs::CostRange kCosts = {0.0f, 49.0f};
+
+/// @brief Every node's arcs, as (target, cost) pairs.
+static auto arcs_of(const CsrGraph& graph)
+    -> std::vector<std::vector<std::pair<NodeId, float>>> {
+    std::vector<std::vector<std::pair<NodeId, float>>> arcs(graph.num_nodes());
+    for (NodeId node = 0; node < graph.num_nodes(); node++) {
+        graph.for_each_arc(node, [&](NodeId to, float cost) {
+            arcs[node].emplace_back(to, cost);
+        });
+    }
+    return arcs;
+}
+
+//------------------------------------------------------------------------------
+// Bulk construction
+//------------------------------------------------------------------------------
+
+TEST(CsrBuild, MatchesSequentialConstruction) {
+    // Enough nodes for several buckets
+    const auto edges = random_edges(50000, 300000, 13, kCosts);
+    const auto expected = CsrGraph::from_edges(50000, edges);
+    auto sorted = expected;
+    sorted.sort_arcs();
+    // No threads means the calling thread only
+    for (size_t threads : {0, 1, 4}) {
+        // Edges keep their input order unless sorted
+        const auto graph = CsrGraph::build(50000, edges, {}, threads);
+        EXPECT_EQ(graph.offsets(), expected.offsets());
+        EXPECT_EQ(arcs_of(graph), arcs_of(expected));
+
+        CsrBuildOptions options;
+        options.sort_arcs = true;
+        EXPECT_EQ(arcs_of(CsrGraph::build(50000, edges, options, threads)),
+                  arcs_of(sorted));
+    }
+}
+
+TEST(CsrBuild, RemovesSelfLoopsAndDuplicates) {
+    const auto edges = random_edges(300, 50000, 13, kCosts);
+    // The cheapest edge of every pair, self loops left out
+    std::map<std::pair<NodeId, NodeId>, float> cheapest;
+    for (const auto& edge : edges) {
+        if (edge.from == edge.to) continue;
+        auto [it, inserted] = cheapest.try_emplace({edge.from, edge.to},
+                                                   edge.cost);
+        if (!inserted) it->second = std::min(it->second, edge.cost);
+    }
+
+    CsrBuildOptions options;
+    options.remove_self_loops = true;
+    options.deduplicate = true;
+    const auto graph = CsrGraph::build(300, edges, options, 4);
+    ASSERT_EQ(graph.num_edges(), cheapest.size());
+    const auto arcs = arcs_of(graph);
+    for (NodeId node = 0; node < 300; node++) {
+        ASSERT_TRUE(std::is_sorted(arcs[node].begin(), arcs[node].end()));
+        for (auto [to, cost] : arcs[node]) {
+            ASSERT_EQ(cost, cheapest.at({node, to}));
+        }
+    }
+}
+
+TEST(CsrBuild, CollectsEdgesFromProducers) {
+    // Producer `p` emits the edges of nodes `p, p + 8, p + 16, ...`
+    const auto graph = CsrGraph::build_with(
+        1000, 8,
+        [](size_t producer, auto&& emit) {
+            for (auto node = static_cast<NodeId>(producer); node < 1000;
+                 node += 8) {
+                emit(node, (node + 1) % 1000, 1.0f);
+                emit(node, (node + 7) % 1000, 7.0f);
+            }
+        },
+        {}, 4);
+    ASSERT_EQ(graph.num_edges(), 2000u);
+    for (NodeId node = 0; node < 1000; node++) {
+        ASSERT_EQ(graph.degree(node), 2u);
+        float total = 0.0f;
+        graph.for_each_arc(node, [&](NodeId to, float cost) {
+            EXPECT_EQ(to, (node + static_cast<NodeId>(cost)) % 1000);
+            total += cost;
+        });
+        EXPECT_EQ(total, 8.0f);
+    }
+}
+
+TEST(CsrBuild, RejectsEdgesToMissingNodes) {
+    auto edges = random_edges(100, 200000, 13, kCosts);
+    edges[150000].to = 100;
+    EXPECT_THROW(CsrGraph::from_edges(100, edges), std::out_of_range);
+    EXPECT_THROW(CsrGraph::build(100, edges, {}, 4), std::out_of_range);
+
+    edges[150000] = {0, 1, 1.0f};
+    edges[7].from = 1000;
+    EXPECT_THROW(CsrGraph::from_edges(100, edges), std::out_of_range);
+    EXPECT_THROW(CsrGraph::build(100, edges, {}, 4), std::out_of_range);
+}
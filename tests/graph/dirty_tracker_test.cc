@@ -0,0 +1,65 @@
+#include "graph/dirty_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+using graph::DirtyTracker;
+
+using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+static auto flush(DirtyTracker& tracker, uint32_t count) -> Ranges {
+    Ranges ranges;
+    tracker.flush(count, [&](uint32_t first, uint32_t num) {
+        ranges.emplace_back(first, num);
+    });
+    return ranges;
+}
+
+TEST(DirtyTracker, CoalescesContiguousRanges) {
+    DirtyTracker tracker;
+    EXPECT_FALSE(tracker.dirty());
+
+    for (uint32_t index : {7, 2, 3, 9, 4, 3}) tracker.mark(index);
+    EXPECT_TRUE(tracker.dirty());
+
+    EXPECT_EQ(flush(tracker, 10), (Ranges{{2, 3}, {7, 1}, {9, 1}}));
+
+    // flushing resets the tracker
+    EXPECT_FALSE(tracker.dirty());
+    EXPECT_TRUE(flush(tracker, 10).empty());
+}
+
+TEST(DirtyTracker, IgnoresRemovedElements) {
+    DirtyTracker tracker;
+    for (uint32_t index : {3, 4, 5, 6}) tracker.mark(index);
+
+    // elements 5 and 6 were removed in the meantime
+    EXPECT_EQ(flush(tracker, 5), (Ranges{{3, 2}}));
+
+    // ...and can be marked again once re-added
+    tracker.mark(6);
+    EXPECT_EQ(flush(tracker, 7), (Ranges{{6, 1}}));
+}
+
+TEST(DirtyTracker, MarkAllFlushesEverything) {
+    DirtyTracker tracker;
+    tracker.mark(1);
+    tracker.mark_all();
+    EXPECT_TRUE(tracker.all());
+
+    EXPECT_EQ(flush(tracker, 4), (Ranges{{0, 4}}));
+    EXPECT_FALSE(tracker.all());
+    EXPECT_TRUE(flush(tracker, 4).empty());
+}
+
+TEST(DirtyTracker, RemovalsAreDirtyUntilFlushed) {
+    DirtyTracker tracker;
+    tracker.mark_removed();
+    EXPECT_TRUE(tracker.dirty());
+
+    // nothing left to rebuild, but the frame has to be redrawn
+    EXPECT_TRUE(flush(tracker, 3).empty());
+    EXPECT_FALSE(tracker.dirty());
+}
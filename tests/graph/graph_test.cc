@@ -5,6 +5,7 @@
 #include <memory>
 
 #include "SFML/Graphics.hpp"
+#include "utils/metrics.h"
 
 using std::make_unique;
 
@@ -79,3 +80,100 @@ TEST(Graph, DAG) {
     // Add an edge from a given source node to a new node w/ a given
     // position dag->add_edge_to(dag->source(), Vector2f(1.0f, 9.0f));
 }
+
+TEST(Graph, EdgeIndex) {
+    sf::RenderTexture target;
+    graph::DirectedAcyclicGraph dag(
+        &target, nullptr, make_unique<Node>(target, Vector2f(0.0f, 0.0f)),
+        make_unique<Node>(target, Vector2f(10.0f, 0.0f)));
+    auto a = dag.add_node(Vector2f(3.0f, 0.0f));
+    auto b = dag.add_node(Vector2f(6.0f, 0.0f));
+
+    auto direct = dag.add_edge(dag.source(), dag.target());
+    auto to_a = dag.add_edge(dag.source(), a);
+    auto a_to_b = dag.add_edge(a, b);
+    auto b_to_target = dag.add_edge(b, dag.target());
+    ASSERT_NE(direct, nullptr);
+    EXPECT_EQ(dag.num_edges(), 4);
+
+    // duplicates are rejected, the reverse direction is a different edge
+    EXPECT_EQ(dag.add_edge(a, b), nullptr);
+    EXPECT_EQ(dag.num_edges(), 4);
+    EXPECT_EQ(a->num_outgoing_edges(), 1);
+    auto b_to_a = dag.add_edge(b, a);
+    ASSERT_NE(b_to_a, nullptr);
+
+    EXPECT_EQ(dag.find_edge(a, b), a_to_b);
+    EXPECT_EQ(dag.find_edge(b, a), b_to_a);
+    EXPECT_EQ(dag.find_edge(a, dag.target()), nullptr);
+    EXPECT_TRUE(dag.has_edge(dag.source(), a));
+    EXPECT_FALSE(dag.has_edge(a, dag.source()));
+
+    // removing an edge moves the last edge (b -> a) into its id, which the
+    // index has to follow
+    const auto removed_id = to_a->id();
+    dag.remove_edge(to_a);
+    EXPECT_EQ(dag.num_edges(), 4);
+    EXPECT_FALSE(dag.has_edge(dag.source(), a));
+    EXPECT_EQ(b_to_a->id(), removed_id);
+    EXPECT_EQ(dag.find_edge(b, a), b_to_a);
+    EXPECT_EQ(dag.find_edge(b, dag.target()), b_to_target);
+
+    // a removed edge can be added again
+    EXPECT_NE(dag.add_edge(dag.source(), a), nullptr);
+    EXPECT_TRUE(dag.has_edge(dag.source(), a));
+}
+
+TEST(Graph, RemovingTheLastElementsRedraws) {
+    sf::RenderTexture target;
+    graph::DirectedAcyclicGraph dag(
+        &target, nullptr, make_unique<Node>(target, Vector2f(0.0f, 0.0f)),
+        make_unique<Node>(target, Vector2f(10.0f, 0.0f)));
+    auto a = dag.add_node(Vector2f(3.0f, 0.0f));
+    dag.add_edge(dag.source(), dag.target());
+    auto last = dag.add_edge(dag.source(), a);
+    dag.render();
+    EXPECT_FALSE(dag.dirty());
+
+    // no other edge takes over the removed one's id
+    dag.remove_edge(last);
+    EXPECT_TRUE(dag.dirty());
+    dag.render();
+    EXPECT_FALSE(dag.dirty());
+
+    // nor does another node
+    dag.remove_node(a);
+    EXPECT_TRUE(dag.dirty());
+    dag.render();
+    EXPECT_FALSE(dag.dirty());
+}
+
+TEST(Graph, DestroyedScenesGiveBackTheirBufferBytes) {
+    auto& bytes = tracing::metrics().gauge("render_buffer_bytes");
+    const auto before = bytes.value();
+    {
+        sf::RenderTexture target;
+        graph::DirectedAcyclicGraph dag(
+            &target, nullptr, make_unique<Node>(target, Vector2f(0.0f, 0.0f)),
+            make_unique<Node>(target, Vector2f(10.0f, 0.0f)));
+        for (int i = 0; i < 100; i++) {
+            dag.add_node(Vector2f(static_cast<float>(i), 5.0f));
+        }
+        dag.add_edge(dag.source(), dag.target());
+        dag.render();
+        EXPECT_GE(bytes.value(), before);
+    }
+    // a rebuilt graph doesn't count the old one's buffers
+    EXPECT_EQ(bytes.value(), before);
+}
+
+TEST(Graph, AddedNodesAreUntextured) {
+    sf::RenderTexture target;
+    sf::Texture atlas;
+    graph::DirectedAcyclicGraph dag(
+        &target, &atlas, make_unique<Node>(target, Vector2f(0.0f, 0.0f)),
+        make_unique<Node>(target, Vector2f(10.0f, 0.0f)));
+
+    // the graph's texture is what nodes are drawn with, not their image
+    EXPECT_EQ(dag.add_node(Vector2f(3.0f, 0.0f))->texture(), nullptr);
+}
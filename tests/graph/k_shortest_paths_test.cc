@@ -0,0 +1,181 @@
+#include "graph/k_shortest_paths.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "tests/graph/test_graphs.h"
+
+using graph::CsrGraph;
+using graph::KShortestStats;
+using graph::NodeId;
+using graph::Route;
+using graph::WeightedEdge;
+using test_graphs::random_dag;
+
+/// @brief The costs of every loopless path, by exhaustive search.
+static auto all_path_costs(const CsrGraph& graph, NodeId source,
+                           NodeId target) -> std::vector<float> {
+    std::vector<float> costs;
+    std::vector<bool> on_path(graph.num_nodes(), false);
+    auto visit = [&](auto&& self, NodeId node, float cost) -> void {
+        if (node == target) {
+            costs.push_back(cost);
+            return;
+        }
+        on_path[node] = true;
+        graph.for_each_arc(node, [&](NodeId next, float edge_cost) {
+            if (!on_path[next]) self(self, next, cost + edge_cost);
+        });
+        on_path[node] = false;
+    };
+    visit(visit, source, 0.0f);
+    std::sort(costs.begin(), costs.end());
+    return costs;
+}
+
+/// @brief Checks that a route is a connected path with the right cost.
+static auto expect_valid(const CsrGraph& graph, const Route& route) -> void {
+    ASSERT_EQ(route.nodes.size(), route.arcs.size() + 1);
+    float cost = 0.0f;
+    for (size_t i = 0; i < route.arcs.size(); i++) {
+        const auto arc = route.arcs[i];
+        ASSERT_GE(arc, graph.offsets()[route.nodes[i]]);
+        ASSERT_LT(arc, graph.offsets()[route.nodes[i] + 1]);
+        ASSERT_EQ(graph.targets()[arc], route.nodes[i + 1]);
+        cost += graph.costs()[arc];
+    }
+    EXPECT_FLOAT_EQ(route.cost, cost);
+}
+
+//------------------------------------------------------------------------------
+// Yen
+//------------------------------------------------------------------------------
+
+TEST(Yen, FindsTheClassicExample) {
+    // C D E F G H
+    const auto graph = CsrGraph::from_edges(
+        6, {{0, 1, 3}, {0, 2, 2}, {1, 3, 4}, {2, 1, 1}, {2, 3, 2}, {2, 4, 3},
+            {3, 4, 2}, {3, 5, 1}, {4, 5, 2}});
+    const auto routes = graph::yen_k_shortest_paths(graph, 0, 5, 3);
+    ASSERT_EQ(routes.size(), 3u);
+    EXPECT_EQ(routes[0].nodes, (std::vector<NodeId>{0, 2, 3, 5}));
+    EXPECT_EQ(routes[0].cost, 5.0f);
+    EXPECT_EQ(routes[1].nodes, (std::vector<NodeId>{0, 2, 4, 5}));
+    EXPECT_EQ(routes[1].cost, 7.0f);
+    EXPECT_EQ(routes[2].cost, 8.0f);
+    for (const auto& route : routes) expect_valid(graph, route);
+}
+
+TEST(Yen, MatchesExhaustiveSearch) {
+    for (int seed = 0; seed < 5; seed++) {
+        // Cycles included: both directions of random edges
+        std::mt19937 rng(seed);
+        std::vector<WeightedEdge> edges;
+        for (int i = 0; i < 30; i++) {
+            const auto from = static_cast<NodeId>(rng() % 10);
+            const auto to = static_cast<NodeId>(rng() % 10);
+            edges.push_back({from, to, static_cast<float>(1 + rng() % 9)});
+        }
+        const auto graph = CsrGraph::from_edges(10, edges);
+        const auto expected = all_path_costs(graph, 0, 9);
+        for (size_t threads : {1, 4}) {
+            const auto routes =
+                graph::yen_k_shortest_paths(graph, 0, 9, 20, threads);
+            ASSERT_EQ(routes.size(), std::min<size_t>(20, expected.size()));
+            for (size_t i = 0; i < routes.size(); i++) {
+                expect_valid(graph, routes[i]);
+                EXPECT_FLOAT_EQ(routes[i].cost, expected[i]) << seed;
+                auto nodes = routes[i].nodes;
+                std::sort(nodes.begin(), nodes.end());
+                EXPECT_EQ(std::adjacent_find(nodes.begin(), nodes.end()),
+                          nodes.end())
+                    << "routes are loopless";
+            }
+        }
+    }
+}
+
+TEST(Yen, CostsLessThanIndependentSearches) {
+    // A 100 x 100 grid, from one corner to the other
+    constexpr uint32_t kSide = 100;
+    std::vector<WeightedEdge> edges;
+    std::mt19937 rng(1);
+    for (uint32_t y = 0; y < kSide; y++) {
+        for (uint32_t x = 0; x < kSide; x++) {
+            const auto id = y * kSide + x;
+            const auto cost = [&] { return 1.0f + (rng() % 100) / 100.0f; };
+            if (x + 1 < kSide) edges.push_back({id, id + 1, cost()});
+            if (y + 1 < kSide) edges.push_back({id, id + kSide, cost()});
+        }
+    }
+    const auto graph = CsrGraph::from_edges(kSide * kSide, edges);
+    const NodeId target = kSide * kSide - 1;
+
+    auto& context = graph::search_context();
+    graph::dijkstra(graph, context, 0, target);
+    size_t expanded_by_one = 0;
+    for (NodeId node = 0; node <= target; node++) {
+        expanded_by_one += context.closed(node);
+    }
+
+    constexpr size_t k = 10;
+    KShortestStats stats;
+    const auto routes = graph::yen_k_shortest_paths(graph, 0, target, k,
+                                                    parallel::num_threads(),
+                                                    &stats);
+    ASSERT_EQ(routes.size(), k);
+    // The stats include the search for the shortest path tree, which
+    // expands every node
+    EXPECT_GE(stats.expanded, kSide * kSide);
+    EXPECT_LT(stats.expanded, k * expanded_by_one);
+    // Spur searches mostly rejoin the tree within a few steps, so all of
+    // them together expand less than one more full search
+    EXPECT_LT(stats.expanded, 2 * expanded_by_one);
+}
+
+//------------------------------------------------------------------------------
+// K shortest walks
+//------------------------------------------------------------------------------
+
+TEST(KShortestWalks, RepeatsCycles) {
+    const auto graph =
+        CsrGraph::from_edges(3, {{0, 1, 1}, {1, 0, 1}, {1, 2, 1}});
+    const auto walks = graph::k_shortest_walks(graph, 0, 2, 3);
+    ASSERT_EQ(walks.size(), 3u);
+    EXPECT_EQ(walks[0].cost, 2.0f);
+    EXPECT_EQ(walks[1].cost, 4.0f);
+    EXPECT_EQ(walks[2].nodes, (std::vector<NodeId>{0, 1, 0, 1, 0, 1, 2}));
+    for (const auto& walk : walks) expect_valid(graph, walk);
+}
+
+TEST(KShortestWalks, MatchesYenOnAcyclicGraphs) {
+    const auto graph = random_dag(200, 800, 4, {1.0f, 9.0f});
+    const auto paths = graph::yen_k_shortest_paths(graph, 0, 199, 25);
+    const auto walks = graph::k_shortest_walks(graph, 0, 199, 25);
+    ASSERT_EQ(walks.size(), paths.size());
+    for (size_t i = 0; i < walks.size(); i++) {
+        expect_valid(graph, walks[i]);
+        EXPECT_FLOAT_EQ(walks[i].cost, paths[i].cost);
+    }
+}
+
+TEST(KShortestWalks, ExpandsEachNodeAtMostKTimes) {
+    // Parallel arcs reach node 1 by many prefixes, only k of which may be
+    // expanded
+    const auto graph = CsrGraph::from_edges(
+        3, {{0, 1, 1}, {0, 1, 1}, {0, 1, 1}, {0, 1, 1}, {0, 1, 1}, {1, 2, 1}});
+    KShortestStats stats;
+    auto walks = graph::k_shortest_walks(graph, 0, 2, 1, &stats);
+    ASSERT_EQ(walks.size(), 1u);
+    EXPECT_EQ(stats.expanded, 3u);
+
+    // With cycles, at most k expansions of each node
+    walks = graph::k_shortest_walks(
+        CsrGraph::from_edges(3, {{0, 1, 1}, {1, 0, 1}, {1, 0, 1}, {1, 2, 50}}),
+        0, 2, 2, &stats);
+    ASSERT_EQ(walks.size(), 2u);
+    EXPECT_LE(stats.expanded, 2u * 3u);
+}
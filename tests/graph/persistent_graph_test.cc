@@ -0,0 +1,116 @@
+#include "graph/persistent_graph.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using graph::GraphHistory;
+using graph::NodeId;
+using graph::PersistentGraph;
+
+//------------------------------------------------------------------------------
+// Persistent graph
+//------------------------------------------------------------------------------
+
+TEST(PersistentGraph, EditsLeaveCopiesUnchanged) {
+    PersistentGraph graph;
+    const auto a = graph.add_node({0, 0});
+    const auto b = graph.add_node({1, 0});
+    const auto c = graph.add_node({2, 0});
+    const auto ab = graph.add_edge(a, b, 1.0f);
+    graph.add_edge(b, c, 2.0f);
+
+    const auto before = graph;
+    graph.move_node(a, {5, 5});
+    graph.set_edge_cost(ab, 10.0f);
+    graph.remove_node(b);
+
+    EXPECT_EQ(before.num_nodes(), 3u);
+    EXPECT_EQ(before.num_edges(), 2u);
+    EXPECT_EQ(before.node(a).position.x, 0.0f);
+    EXPECT_EQ(before.edge(ab).cost, 1.0f);
+    EXPECT_EQ(before.node(b).outgoing.size(), 1u);
+
+    EXPECT_EQ(graph.num_nodes(), 2u);
+    EXPECT_EQ(graph.num_edges(), 0u);
+    EXPECT_EQ(graph.node(a).position.x, 5.0f);
+    EXPECT_TRUE(graph.node(b).removed);
+    EXPECT_TRUE(graph.edge(ab).removed);
+    EXPECT_TRUE(graph.node(a).outgoing.empty());
+    EXPECT_TRUE(graph.node(c).incoming.empty());
+
+    size_t visited = 0;
+    graph.for_each_node([&](NodeId id, const auto&) {
+        EXPECT_NE(id, b);
+        visited++;
+    });
+    EXPECT_EQ(visited, 2u);
+}
+
+TEST(PersistentGraph, RemovingARemovedNodeChangesNothing) {
+    PersistentGraph graph;
+    const auto a = graph.add_node({0, 0});
+    const auto b = graph.add_node({1, 0});
+    graph.add_edge(a, b, 1.0f);
+    graph.remove_node(b);
+
+    const auto before = graph;
+    graph.remove_node(b);
+    EXPECT_EQ(graph.num_nodes(), 1u);
+    EXPECT_EQ(graph.num_edges(), 0u);
+    // no node was copied: both versions still share the same storage
+    EXPECT_EQ(&graph.node(b), &before.node(b));
+    EXPECT_EQ(&graph.node(a), &before.node(a));
+}
+
+//------------------------------------------------------------------------------
+// History
+//------------------------------------------------------------------------------
+
+TEST(GraphHistory, UndoRedo) {
+    GraphHistory history;
+    EXPECT_FALSE(history.can_undo());
+    EXPECT_FALSE(history.undo());
+
+    history.edit([](auto& graph) { graph.add_node({0, 0}); });
+    history.edit([](auto& graph) { graph.add_node({1, 0}); });
+    EXPECT_EQ(history.current().num_nodes(), 2u);
+
+    EXPECT_TRUE(history.undo());
+    EXPECT_EQ(history.current().num_nodes(), 1u);
+    EXPECT_TRUE(history.can_redo());
+    EXPECT_TRUE(history.redo());
+    EXPECT_EQ(history.current().num_nodes(), 2u);
+    EXPECT_FALSE(history.redo());
+
+    // a new edit discards the versions that could have been redone
+    history.undo();
+    history.edit([](auto& graph) { graph.move_node(0, {3, 3}); });
+    EXPECT_FALSE(history.can_redo());
+    EXPECT_EQ(history.current().num_nodes(), 1u);
+    EXPECT_EQ(history.current().node(0).position.x, 3.0f);
+}
+
+TEST(GraphHistory, SnapshotsAreStableAcrossThreads) {
+    GraphHistory history;
+    history.edit([](auto& graph) {
+        for (int i = 0; i < 100; i++) graph.add_node({float(i), 0});
+    });
+
+    std::thread reader([&] {
+        for (int i = 0; i < 1000; i++) {
+            const auto snapshot = history.snapshot();
+            const auto count = snapshot.num_nodes();
+            float sum = 0.0f;
+            snapshot.for_each_node(
+                [&](NodeId, const auto& node) { sum += node.position.y; });
+            ASSERT_EQ(snapshot.num_nodes(), count);
+            ASSERT_EQ(sum, 0.0f);
+        }
+    });
+    for (int i = 0; i < 1000; i++) {
+        history.edit([](auto& graph) { graph.add_node({0, 0}); });
+        if (i % 3 == 0) history.undo();
+    }
+    reader.join();
+}
@@ -0,0 +1,120 @@
+#include "graph/search.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <utility>
+
+#include "SFML/Graphics.hpp"
+
+using std::make_unique;
+
+using sf::Vector2f;
+
+using graph::DirectedAcyclicGraph;
+using graph::INVALID_NODE;
+using graph::Node;
+using graph::SearchContext;
+using graph::UNREACHED;
+
+//------------------------------------------------------------------------------
+// Search context
+//------------------------------------------------------------------------------
+
+TEST(SearchContext, BeginForgetsThePreviousQuery) {
+    SearchContext context;
+    context.begin(4);
+    context.relax(1, 2.0f, 0);
+    context.close(1);
+    EXPECT_TRUE(context.reached(1));
+    EXPECT_TRUE(context.closed(1));
+    EXPECT_EQ(context.parent(1), 0u);
+    EXPECT_EQ(context.cost(1), 2.0f);
+    EXPECT_EQ(context.cost(2), UNREACHED);
+
+    const auto epoch = context.epoch();
+    context.begin(8);  // grows without touching the existing entries
+    EXPECT_EQ(context.epoch(), epoch + 1);
+    EXPECT_FALSE(context.reached(1));
+    EXPECT_FALSE(context.closed(1));
+    EXPECT_EQ(context.parent(1), INVALID_NODE);
+    EXPECT_EQ(context.cost(1), UNREACHED);
+    EXPECT_EQ(context.cost(7), UNREACHED);
+}
+
+TEST(SearchContext, OpenSetPopsLowestFirst) {
+    SearchContext context;
+    context.begin(4);
+    context.push(3.0f, 0);
+    context.push(1.0f, 1);
+    context.push(2.0f, 2);
+    EXPECT_EQ(context.pop().second, 1u);
+    EXPECT_EQ(context.pop().second, 2u);
+    EXPECT_EQ(context.pop().second, 0u);
+    EXPECT_TRUE(context.open_empty());
+}
+
+//------------------------------------------------------------------------------
+// A*
+//------------------------------------------------------------------------------
+
+TEST(Search, ReusedContextFindsTheSamePath) {
+    sf::RenderTexture target;
+    DirectedAcyclicGraph graph(
+        &target, nullptr, make_unique<Node>(target, Vector2f(0.0f, 0.0f)),
+        make_unique<Node>(target, Vector2f(10.0f, 0.0f)));
+    auto direct = graph.add_edge(graph.source(), graph.target());
+    direct->set_cost(100.0f);
+
+    // source -> a -> b -> target is cheaper than the direct edge
+    auto a = graph.add_node(Vector2f(3.0f, 0.0f));
+    auto b = graph.add_node(Vector2f(6.0f, 0.0f));
+    for (auto [from, to] : {std::pair{graph.source(), a}, std::pair{a, b},
+                            std::pair{b, graph.target()}}) {
+        auto edge = graph.add_edge(from, to);
+        edge->set_cost(edge->len());
+    }
+
+    SearchContext context;
+    graph::NullRecorder recorder;
+    for (int query = 0; query < 3; query++) {
+        auto path = graph::a_star(graph, context, graph.source(),
+                                  graph.target(), graph::euclidean_heuristic,
+                                  recorder);
+        ASSERT_EQ(path.size(), 4u);
+        EXPECT_EQ(path[1], a);
+        EXPECT_EQ(path[2], b);
+        EXPECT_FLOAT_EQ(context.cost(graph.target()->id()), 10.0f);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Edge weights
+//------------------------------------------------------------------------------
+
+TEST(EdgeWeight, GeometricCostsFollowMovedNodes) {
+    sf::RenderTexture target;
+    DirectedAcyclicGraph graph(
+        &target, nullptr, make_unique<Node>(target, Vector2f(0.0f, 0.0f)),
+        make_unique<Node>(target, Vector2f(3.0f, 4.0f)));
+    auto edge = graph.add_edge(graph.source(), graph.target());
+    auto fixed = graph.add_edge(graph.target(), graph.source());
+    fixed->set_cost(1.0f);
+    EXPECT_EQ(edge->weight(), graph::EdgeWeight::Geometric);
+    EXPECT_EQ(edge->cost(), 5.0f);
+
+    graph.target()->set_position(Vector2f(6.0f, 8.0f));
+    EXPECT_TRUE(edge->cost_stale());
+    EXPECT_FALSE(fixed->cost_stale());
+    EXPECT_EQ(edge->cost(), 10.0f) << "stale costs are computed on the fly";
+    EXPECT_EQ(fixed->cost(), 1.0f);
+    // The cached 5 would sort the edge before a fixed cost of 7
+    fixed->set_cost(7.0f);
+    EXPECT_TRUE(*fixed < *edge);
+    fixed->set_cost(1.0f);
+
+    EXPECT_EQ(graph.refresh_costs(), 1u);
+    EXPECT_FALSE(edge->cost_stale());
+    EXPECT_EQ(edge->cost(), 10.0f);
+    EXPECT_EQ(graph.refresh_costs(), 0u);
+}
@@ -0,0 +1,114 @@
+#include "graph/spanning_tree.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "tests/graph/test_graphs.h"
+#include "utils/data_structures/union_find.h"
+
+using graph::DirectedAcyclicGraph;
+using graph::EdgeId;
+using graph::Node;
+using graph::SpanningForest;
+using graph::WeightedEdge;
+using sf::Vector2f;
+using std::make_unique;
+using test_graphs::CostRange;
+using test_graphs::random_edges;
+
+/// @brief Integer costs below 20, so that many edges tie.
+constexpr CostRange kTiedCosts = {0.0f, 19.0f};
+
+/// @brief Checks that a forest is acyclic and spans every component.
+static auto expect_spanning(uint32_t num_nodes,
+                            const std::vector<WeightedEdge>& edges,
+                            const SpanningForest& forest) -> void {
+    data_structures::sets::UnionFind trees(num_nodes);
+    double cost = 0.0;
+    for (auto id : forest.edges) {
+        ASSERT_TRUE(trees.unite(edges[id].from, edges[id].to)) << id;
+        cost += edges[id].cost;
+    }
+    EXPECT_DOUBLE_EQ(forest.cost, cost);
+    EXPECT_EQ(forest.num_trees, trees.num_sets());
+
+    data_structures::sets::UnionFind components(num_nodes);
+    for (const auto& edge : edges) components.unite(edge.from, edge.to);
+    EXPECT_EQ(trees.num_sets(), components.num_sets());
+}
+
+//------------------------------------------------------------------------------
+// Kruskal
+//------------------------------------------------------------------------------
+
+TEST(Kruskal, FindsTheMinimumSpanningTree) {
+    //   0 --1-- 1
+    //   |     / |
+    //   4   2   3
+    //   | /     |
+    //   2 --5-- 3
+    const std::vector<WeightedEdge> edges = {
+        {0, 1, 1.0f}, {0, 2, 4.0f}, {1, 2, 2.0f}, {1, 3, 3.0f}, {2, 3, 5.0f},
+    };
+    const auto forest = graph::kruskal(4, edges);
+    EXPECT_EQ(forest.edges, (std::vector<EdgeId>{0, 2, 3}));
+    EXPECT_DOUBLE_EQ(forest.cost, 6.0);
+    EXPECT_EQ(forest.num_trees, 1u);
+}
+
+TEST(Kruskal, SpansEveryComponent) {
+    // Sparse enough to leave several components and isolated nodes
+    const auto edges = random_edges(2000, 1800, 5, kTiedCosts);
+    const auto forest = graph::kruskal(2000, edges, 4);
+    expect_spanning(2000, edges, forest);
+    EXPECT_GT(forest.num_trees, 1u);
+}
+
+//------------------------------------------------------------------------------
+// Borůvka
+//------------------------------------------------------------------------------
+
+TEST(Boruvka, MatchesKruskal) {
+    // Ties are broken by edge id, so both find the same forest
+    for (size_t num_edges : {0, 1800, 40000}) {
+        const auto edges = random_edges(2000, num_edges, 5, kTiedCosts);
+        const auto expected = graph::kruskal(2000, edges, 1);
+        auto forest = graph::boruvka(2000, edges, 4);
+        expect_spanning(2000, edges, forest);
+        EXPECT_DOUBLE_EQ(forest.cost, expected.cost);
+
+        auto expected_edges = expected.edges;
+        std::sort(expected_edges.begin(), expected_edges.end());
+        std::sort(forest.edges.begin(), forest.edges.end());
+        EXPECT_EQ(forest.edges, expected_edges);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Overlay
+//------------------------------------------------------------------------------
+
+TEST(SpanningForest, ColorsTheOverlay) {
+    sf::RenderTexture target;
+    DirectedAcyclicGraph graph(
+        &target, nullptr, make_unique<Node>(target, Vector2f(0.0f, 0.0f)),
+        make_unique<Node>(target, Vector2f(10.0f, 0.0f)));
+    auto middle = graph.add_node(Vector2f(5.0f, 1.0f));
+    auto direct = graph.add_edge(graph.source(), graph.target());
+    auto first = graph.add_edge(graph.source(), middle);
+    auto second = graph.add_edge(middle, graph.target());
+
+    const auto forest = graph::kruskal(graph);
+    EXPECT_EQ(forest.edges.size(), 2u);
+    graph::show_spanning_forest(graph, forest);
+    EXPECT_EQ(first->color(), graph::SPANNING_TREE_COLOR);
+    EXPECT_EQ(second->color(), graph::SPANNING_TREE_COLOR);
+    EXPECT_EQ(direct->color(), graph::NON_TREE_EDGE_COLOR);
+
+    graph::hide_spanning_forest(graph);
+    EXPECT_EQ(direct->color(), graph::EDGE_COLOR);
+    EXPECT_EQ(first->color(), graph::EDGE_COLOR);
+}
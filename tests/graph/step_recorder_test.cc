@@ -0,0 +1,66 @@
+#include "graph/step_recorder.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using graph::INVALID_NODE;
+using graph::StepEvent;
+using graph::StepKind;
+using graph::StepQueue;
+using graph::StepRecorder;
+
+// -----------------------------------------------------------------------------
+// Step recorder
+// -----------------------------------------------------------------------------
+
+TEST(StepRecorder, EncodesEveryStepKind) {
+    StepQueue queue(8);
+    StepRecorder recorder(queue);
+
+    recorder.record(StepKind::Push, 1, INVALID_NODE, 0.0f);
+    recorder.record(StepKind::Pop, 1, INVALID_NODE, 0.0f);
+    recorder.record(StepKind::Relax, 2, 1, 1.5f);
+    recorder.record(StepKind::Settle, 2, 1, 1.5f);
+    recorder.record(StepKind::PathFound, 3, 2, 4.25f);
+
+    std::vector<StepEvent> events;
+    queue.drain([&](const StepEvent& event) { events.push_back(event); });
+    ASSERT_EQ(events.size(), 5);
+
+    const StepKind kinds[] = {StepKind::Push, StepKind::Pop, StepKind::Relax,
+                              StepKind::Settle, StepKind::PathFound};
+    for (size_t i = 0; i < events.size(); i++) {
+        EXPECT_EQ(events[i].kind, kinds[i]);
+    }
+    EXPECT_EQ(events[0].node, 1u);
+    EXPECT_EQ(events[0].parent, INVALID_NODE);
+    EXPECT_EQ(events[2].node, 2u);
+    EXPECT_EQ(events[2].parent, 1u);
+    EXPECT_EQ(events[2].cost, 1.5f);
+    EXPECT_EQ(events[4].node, 3u);
+    EXPECT_EQ(events[4].parent, 2u);
+    EXPECT_EQ(events[4].cost, 4.25f);
+    EXPECT_EQ(recorder.dropped(), 0);
+}
+
+TEST(StepRecorder, DropsAndCountsWhenTheQueueIsFull) {
+    StepQueue queue(4);
+    StepRecorder recorder(queue);
+
+    // the recorder never blocks: the last two steps don't fit
+    for (graph::NodeId node = 0; node < 6; node++) {
+        recorder.record(StepKind::Push, node, INVALID_NODE, 0.0f);
+    }
+    EXPECT_EQ(recorder.dropped(), 2);
+
+    // the steps that made it are the oldest ones, in order
+    std::vector<graph::NodeId> nodes;
+    queue.drain([&](const StepEvent& event) { nodes.push_back(event.node); });
+    EXPECT_EQ(nodes, (std::vector<graph::NodeId>{0, 1, 2, 3}));
+
+    // once drained, recording works again (the count is kept)
+    recorder.record(StepKind::Pop, 0, INVALID_NODE, 0.0f);
+    EXPECT_EQ(queue.size_approx(), 1);
+    EXPECT_EQ(recorder.dropped(), 2);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "graph/csr.h"
+
+/// @brief Seeded random graphs shared by the graph tests (the same seed and
+/// arguments always give the same graph).
+namespace test_graphs {
+
+/// @brief The costs random edges are drawn from: whole numbers in
+/// `[min, max]`, or any value in `[min, max)` unless `integral`.
+struct CostRange {
+    float min = 1.0f;
+    float max = 1.0f;
+    bool integral = true;
+};
+
+/// @brief Draws a cost from a range (without drawing when every cost is the
+/// same).
+template <typename Rng>
+auto random_cost(Rng& rng, CostRange costs) -> float {
+    if (costs.min == costs.max) return costs.min;
+    if (costs.integral) {
+        std::uniform_int_distribution<int> cost(static_cast<int>(costs.min),
+                                                static_cast<int>(costs.max));
+        return static_cast<float>(cost(rng));
+    }
+    return std::uniform_real_distribution<float>(costs.min, costs.max)(rng);
+}
+
+/// @brief `num_edges` random edges between `num_nodes` nodes, self loops and
+/// parallel edges included.
+inline auto random_edges(uint32_t num_nodes, size_t num_edges, uint32_t seed,
+                         CostRange costs = {})
+    -> std::vector<graph::WeightedEdge> {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint32_t> node(0, num_nodes - 1);
+    std::vector<graph::WeightedEdge> edges;
+    edges.reserve(num_edges);
+    for (size_t i = 0; i < num_edges; i++) {
+        const auto from = node(rng);
+        const auto to = node(rng);
+        edges.push_back({from, to, random_cost(rng, costs)});
+    }
+    return edges;
+}
+
+/// @brief `num_edges` random edges that only go to larger ids (so they
+/// never form a cycle).
+inline auto random_dag_edges(uint32_t num_nodes, size_t num_edges,
+                             uint32_t seed, CostRange costs = {})
+    -> std::vector<graph::WeightedEdge> {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint32_t> node(0, num_nodes - 1);
+    std::vector<graph::WeightedEdge> edges;
+    edges.reserve(num_edges);
+    while (edges.size() < num_edges) {
+        auto from = node(rng);
+        auto to = node(rng);
+        if (from == to) continue;
+        if (from > to) std::swap(from, to);
+        edges.push_back({from, to, random_cost(rng, costs)});
+    }
+    return edges;
+}
+
+/// @brief A graph of `random_edges()`.
+inline auto random_graph(uint32_t num_nodes, size_t num_edges, uint32_t seed,
+                         CostRange costs = {}) -> graph::CsrGraph {
+    return graph::CsrGraph::from_edges(
+        num_nodes, random_edges(num_nodes, num_edges, seed, costs));
+}
+
+/// @brief A graph of `random_dag_edges()`.
+inline auto random_dag(uint32_t num_nodes, size_t num_edges, uint32_t seed,
+                       CostRange costs = {}) -> graph::CsrGraph {
+    return graph::CsrGraph::from_edges(
+        num_nodes, random_dag_edges(num_nodes, num_edges, seed, costs));
+}
+
+}  // namespace test_graphs
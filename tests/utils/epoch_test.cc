@@ -0,0 +1,66 @@
+#include "utils/data_structures/epoch.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using data_structures::reclamation::EpochDomain;
+
+//------------------------------------------------------------------------------
+// Epoch-based reclamation
+//------------------------------------------------------------------------------
+
+TEST(EpochDomain, WaitsForPinnedReaders) {
+    EpochDomain domain;
+    auto object = std::make_shared<int>(0);
+    {
+        auto guard = domain.pin();
+        domain.retire(new std::shared_ptr<int>(object));
+        for (int i = 0; i < 10; i++) domain.collect();
+        EXPECT_EQ(domain.pending(), 1u) << "freed under a pinned reader";
+        EXPECT_EQ(object.use_count(), 2);
+    }
+    domain.collect();
+    domain.collect();
+    EXPECT_EQ(domain.pending(), 0u);
+    EXPECT_EQ(object.use_count(), 1);
+}
+
+TEST(EpochDomain, GuardsNest) {
+    EpochDomain domain;
+    auto outer = domain.pin();
+    {
+        auto inner = domain.pin();
+    }
+    domain.retire(new int(0));
+    for (int i = 0; i < 10; i++) domain.collect();
+    EXPECT_EQ(domain.pending(), 1u) << "the outer guard still pins";
+}
+
+TEST(EpochDomain, ReadersNeverSeeFreedObjects) {
+    // a writer keeps swapping a published object while readers check it
+    EpochDomain domain;
+    std::atomic<const int*> published{new int(42)};
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            while (!done.load(std::memory_order_acquire)) {
+                auto guard = domain.pin();
+                ASSERT_EQ(*published.load(std::memory_order_acquire), 42);
+            }
+        });
+    }
+    for (int i = 0; i < 10000; i++) {
+        auto old = published.exchange(new int(42), std::memory_order_acq_rel);
+        domain.retire(old);
+        domain.collect();
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers) reader.join();
+    delete published.load();
+}
@@ -0,0 +1,92 @@
+#include "utils/data_structures/flat_hash_map.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using data_structures::containers::FlatHashMap;
+using data_structures::containers::FlatHashSet;
+
+//------------------------------------------------------------------------------
+// Flat hash map
+//------------------------------------------------------------------------------
+
+TEST(FlatHashMap, InsertFindErase) {
+    FlatHashMap<int, std::string> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(1), map.end());
+
+    EXPECT_TRUE(map.insert(1, "one").second);
+    EXPECT_FALSE(map.insert(1, "uno").second) << "keys are unique";
+    map[2] = "two";
+
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map.find(1)->second, "one");
+    EXPECT_EQ(map[2], "two");
+    EXPECT_TRUE(map.contains(2));
+
+    EXPECT_TRUE(map.erase(1));
+    EXPECT_FALSE(map.erase(1));
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_EQ(map.size(), 1u);
+
+    size_t visited = 0;
+    for (const auto& [key, value] : map) {
+        EXPECT_EQ(key, 2);
+        EXPECT_EQ(value, "two");
+        visited++;
+    }
+    EXPECT_EQ(visited, 1u);
+}
+
+TEST(FlatHashMap, MatchesUnorderedMap) {
+    // random inserts and erases, with enough churn to grow the table and
+    // rehash away tombstones
+    FlatHashMap<uint64_t, uint64_t> map;
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 rng(42);
+    for (int i = 0; i < 100000; i++) {
+        const auto key = rng() % 5000;
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(map.erase(key), expected.erase(key) == 1);
+        } else {
+            EXPECT_EQ(map.insert(key, i).second,
+                      expected.emplace(key, i).second);
+        }
+    }
+
+    ASSERT_EQ(map.size(), expected.size());
+    for (const auto& [key, value] : expected) {
+        auto it = map.find(key);
+        ASSERT_NE(it, map.end());
+        EXPECT_EQ(it->second, value);
+    }
+    EXPECT_LE(map.size(), map.capacity() * 7 / 8);
+}
+
+TEST(FlatHashMap, CopiesAndDestroysValues) {
+    auto shared = std::make_shared<int>(0);
+    {
+        FlatHashMap<int, std::shared_ptr<int>> map;
+        for (int i = 0; i < 100; i++) map.insert(i, shared);
+        auto copy = map;
+        EXPECT_EQ(shared.use_count(), 201);
+        copy.erase(0);
+        copy.clear();
+        EXPECT_EQ(shared.use_count(), 101);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(FlatHashSet, InsertContains) {
+    FlatHashSet<std::string> set;
+    EXPECT_TRUE(set.insert("a"));
+    EXPECT_FALSE(set.insert("a"));
+    EXPECT_TRUE(set.insert("b"));
+    EXPECT_TRUE(set.contains("a"));
+    EXPECT_FALSE(set.contains("c"));
+    EXPECT_EQ(set.size(), 2u);
+}
@@ -0,0 +1,77 @@
+#include "utils/log_sampling.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using tracing::EveryN;
+using tracing::FirstNThenEvery;
+using tracing::PerSecond;
+
+//------------------------------------------------------------------------------
+// Log sampling
+//------------------------------------------------------------------------------
+
+template <typename Sampler>
+static auto count_sampled(Sampler& sampler, int messages) -> int {
+    int sampled = 0;
+    for (int i = 0; i < messages; i++) sampled += sampler.sample();
+    return sampled;
+}
+
+TEST(LogSampling, EveryN) {
+    EveryN sampler(10);
+    EXPECT_TRUE(sampler.sample());  // the first message is always logged
+    EXPECT_EQ(count_sampled(sampler, 99), 9);
+}
+
+TEST(LogSampling, FirstNThenEvery) {
+    FirstNThenEvery sampler(5, 100);
+    EXPECT_EQ(count_sampled(sampler, 5), 5);
+    EXPECT_EQ(count_sampled(sampler, 1000), 10);
+}
+
+TEST(LogSampling, PerSecondAllowsBurst) {
+    // a burst of messages only gets `rate` through
+    constexpr int64_t kSecond = 1'000'000'000;
+    constexpr int64_t kStart = 100 * kSecond;
+    PerSecond sampler(20);
+    auto sampled_at = [&](int64_t now, int messages) {
+        int sampled = 0;
+        for (int i = 0; i < messages; i++) sampled += sampler.sample(now);
+        return sampled;
+    };
+    EXPECT_EQ(sampled_at(kStart, 1000), 20);
+    EXPECT_EQ(sampled_at(kStart + kSecond / 40, 1000), 0);
+    // one token refills every 50ms, the whole bucket in a second
+    EXPECT_EQ(sampled_at(kStart + kSecond / 20, 1000), 1);
+    EXPECT_EQ(sampled_at(kStart + 3 * kSecond, 1000), 20);
+}
+
+TEST(LogSampling, EveryNIsThreadSafe) {
+    EveryN sampler(4);
+    std::vector<std::thread> threads;
+    std::atomic<int> sampled{0};
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] { sampled += count_sampled(sampler, 1000); });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(sampled, 1000);
+}
+
+TEST(LogSampling, SkipsDisabledLevels) {
+    tracing::set_log_level(tracing::LVL_INFO);
+    EveryN sampler(2);
+
+    testing::internal::CaptureStdout();
+    tracing::trace(sampler, "trace {}", 0);  // disabled, doesn't count
+    for (int i = 0; i < 4; i++) tracing::info(sampler, "info {}", i);
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(output.find("info 0"), std::string::npos);
+    EXPECT_EQ(output.find("info 1"), std::string::npos);
+    EXPECT_NE(output.find("info 2"), std::string::npos);
+    EXPECT_EQ(output.find("info 3"), std::string::npos);
+}
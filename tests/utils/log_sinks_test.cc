@@ -0,0 +1,128 @@
+#include "utils/log_sinks.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using tracing::FileSink;
+using tracing::FileSinkOptions;
+
+//------------------------------------------------------------------------------
+// Log sinks
+//------------------------------------------------------------------------------
+
+static auto read_log(const std::string& path) -> std::string {
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+static auto count_lines(const std::string& text) -> size_t {
+    return std::count(text.begin(), text.end(), '\n');
+}
+
+static auto write_records(FileSink& sink, int count) {
+    std::vector<tracing::LogRecord> records;
+    for (int i = 0; i < count; i++) {
+        records.push_back(tracing::make_record(tracing::LVL_INFO,
+                                               fmt::format("message {}", i)));
+    }
+    sink.write(records);
+}
+
+TEST(LogSinks, WritesStructuredLines) {
+    const std::string path = testing::TempDir() + "log_sinks_test.log";
+    std::remove(path.c_str());
+    {
+        FileSink sink(FileSinkOptions{.path = path});
+        ASSERT_TRUE(sink.ok());
+        sink.write(std::vector{tracing::make_record(tracing::LVL_WARN,
+                                                    "two\nlines")});
+        EXPECT_EQ(read_log(path), "") << "lines should be buffered";
+        sink.flush();
+    }
+    const auto log = read_log(path);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(count_lines(log), 1u);
+    EXPECT_NE(log.find("Z WARN  "), std::string::npos);
+    EXPECT_NE(log.find("two\\nlines\n"), std::string::npos);
+    EXPECT_EQ(log.find('\x1b'), std::string::npos) << "no color codes";
+}
+
+TEST(LogSinks, RotatesBySize) {
+    const std::string path = testing::TempDir() + "log_sinks_rotate.log";
+    {
+        FileSink sink(FileSinkOptions{
+            .path = path, .buffer_size = 256, .max_bytes = 1024,
+            .max_files = 2});
+        write_records(sink, 200);
+        EXPECT_GT(sink.rotations(), 2u);
+    }
+
+    EXPECT_LE(std::filesystem::file_size(path), 1024u);
+    EXPECT_LE(std::filesystem::file_size(path + ".1"), 1024u);
+    EXPECT_TRUE(std::filesystem::exists(path + ".2"));
+    EXPECT_FALSE(std::filesystem::exists(path + ".3"));
+    const auto newest = read_log(path);
+    EXPECT_NE(newest.find("message 199\n"), std::string::npos);
+    for (auto suffix : {"", ".1", ".2"}) {
+        std::remove((path + suffix).c_str());
+    }
+}
+
+TEST(LogSinks, AppendsThroughMemoryMapping) {
+    const std::string path = testing::TempDir() + "log_sinks_mmap.log";
+    std::remove(path.c_str());
+    {
+        FileSink sink(FileSinkOptions{.path = path, .mmap = true});
+        write_records(sink, 100);
+    }
+    {
+        // Reopening appends after the existing lines
+        FileSink sink(FileSinkOptions{.path = path, .mmap = true});
+        write_records(sink, 100);
+    }
+    const auto log = read_log(path);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(count_lines(log), 200u);
+    EXPECT_EQ(log.find('\0'), std::string::npos) << "file should be trimmed";
+    EXPECT_EQ(log.rfind("message 99\n") + 11, log.size());
+}
+
+TEST(LogSinks, SelectedAtRuntime) {
+    const std::string path = testing::TempDir() + "log_sinks_async.log";
+    std::remove(path.c_str());
+    tracing::set_log_level(tracing::LVL_INFO);
+
+    std::vector<std::unique_ptr<tracing::LogSink>> sinks;
+    sinks.push_back(std::make_unique<FileSink>(FileSinkOptions{.path = path}));
+    tracing::set_log_sinks(std::move(sinks));
+
+    tracing::start_async_logging();
+    tracing::info("to the file");
+    tracing::flush_logs();
+    EXPECT_NE(read_log(path).find("to the file"), std::string::npos);
+    tracing::stop_async_logging();
+
+    // Back to the console
+    sinks.clear();
+    sinks.push_back(std::make_unique<tracing::ConsoleSink>());
+    tracing::set_log_sinks(std::move(sinks));
+    std::remove(path.c_str());
+
+    testing::internal::CaptureStdout();
+    tracing::info("to the console");
+    EXPECT_NE(testing::internal::GetCapturedStdout().find("to the console"),
+              std::string::npos);
+}
@@ -0,0 +1,80 @@
+#include "utils/metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using tracing::Counter;
+using tracing::Histogram;
+
+//------------------------------------------------------------------------------
+// Metrics
+//------------------------------------------------------------------------------
+
+TEST(Metrics, CounterSumsShards) {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10'000; i++) counter.add();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(counter.value(), 80'000);
+}
+
+TEST(Metrics, HistogramBucketsAreAccurate) {
+    // small values are exact, larger ones within 1/SUB_BUCKETS
+    for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 1000ull,
+                           123456789ull, ~0ull}) {
+        const auto upper =
+            Histogram::bucket_upper_bound(Histogram::bucket(value));
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper - value, value / Histogram::SUB_BUCKETS);
+        EXPECT_LT(Histogram::bucket(value), Histogram::NUM_BUCKETS);
+    }
+}
+
+TEST(Metrics, HistogramPercentiles) {
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 1000; value++) histogram.record(value);
+
+    const auto stats = histogram.stats();
+    EXPECT_EQ(stats.count, 1000);
+    EXPECT_EQ(stats.sum, 500'500);
+    EXPECT_EQ(stats.max, 1000);
+    EXPECT_NEAR(stats.p50, 500, 500 / Histogram::SUB_BUCKETS);
+    EXPECT_NEAR(stats.p99, 990, 990 / Histogram::SUB_BUCKETS);
+}
+
+TEST(Metrics, RegistryWritesPrometheus) {
+    tracing::MetricsRegistry registry;
+    registry.counter("test_events_total", "Events").add(3);
+    // looking a metric up again returns the same metric
+    registry.counter("test_events_total").add(2);
+    registry.gauge("test_bytes").set(1.5);
+    registry.histogram("test_latency_us").record(7);
+
+    const std::string path = testing::TempDir() + "metrics_test.prom";
+    ASSERT_TRUE(registry.write_prometheus(path));
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    const auto text = contents.str();
+    std::remove(path.c_str());
+
+    EXPECT_NE(text.find("# TYPE ficiel_test_events_total counter\n"
+                        "ficiel_test_events_total 5\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("ficiel_test_bytes 1.5\n"), std::string::npos);
+    EXPECT_NE(text.find("ficiel_test_latency_us{quantile=\"0.5\"} 7\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("ficiel_test_latency_us_count 1\n"),
+              std::string::npos);
+}
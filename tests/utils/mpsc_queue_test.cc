@@ -0,0 +1,68 @@
+#include "utils/data_structures/mpsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using data_structures::queue::MpscQueue;
+
+// -----------------------------------------------------------------------------
+// Multi-producer / single-consumer queue
+// -----------------------------------------------------------------------------
+
+TEST(MpscQueue, PushPopInOrder) {
+    MpscQueue<std::string> queue(4);
+
+    EXPECT_EQ(queue.capacity(), 4);
+    EXPECT_TRUE(queue.empty());
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_push(std::to_string(i)));
+    }
+    // a rejected element is left untouched
+    std::string rejected = "a string too long for the small buffer";
+    EXPECT_FALSE(queue.try_push(std::move(rejected)));
+    EXPECT_EQ(rejected, "a string too long for the small buffer");
+
+    std::string value;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, std::to_string(i));
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_EQ(queue.popped(), 4);
+}
+
+TEST(MpscQueue, ConcurrentProducers) {
+    // every element should arrive exactly once, in order per producer
+    static constexpr int kProducers = 4;
+    static constexpr int kCount = 100'000;
+    MpscQueue<int> queue(256);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < kCount; i++) {
+                while (!queue.try_push(p * kCount + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> next(kProducers, 0);
+    int received = 0;
+    int value = 0;
+    while (received < kProducers * kCount) {
+        if (!queue.try_pop(value)) continue;
+        const auto producer = value / kCount;
+        EXPECT_EQ(value % kCount, next[producer]);
+        next[producer]++;
+        received++;
+    }
+
+    for (auto& producer : producers) producer.join();
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,109 @@
+#include "utils/parallel.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Parallel for
+//------------------------------------------------------------------------------
+
+TEST(ParallelFor, VisitsEveryIndexOnce) {
+    for (size_t grain : {1, 7, 1000}) {
+        std::vector<std::atomic<int>> visits(1000);
+        parallel::parallel_for(
+            visits.size(), [&](size_t i) { visits[i]++; }, grain, 4);
+        for (auto& count : visits) ASSERT_EQ(count.load(), 1);
+    }
+}
+
+TEST(ParallelFor, RethrowsExceptions) {
+    EXPECT_THROW(parallel::parallel_for(
+                     100,
+                     [](size_t i) {
+                         if (i == 42) throw std::runtime_error("42");
+                     },
+                     1, 4),
+                 std::runtime_error);
+}
+
+TEST(ParallelFor, ReusesThePoolsThreads) {
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    for (int loop = 0; loop < 50; loop++) {
+        parallel::parallel_for(
+            64,
+            [&](size_t) {
+                std::lock_guard lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            },
+            1, 4);
+    }
+    // the calling thread plus the pool's workers, not new threads per loop
+    EXPECT_LE(threads.size(), parallel::thread_pool().size() + 1);
+    EXPECT_GE(parallel::thread_pool().size(), 3u);
+}
+
+TEST(ParallelFor, NestedLoopsFinish) {
+    std::vector<std::atomic<int>> visits(16 * 16);
+    parallel::parallel_for(
+        16,
+        [&](size_t outer) {
+            parallel::parallel_for(
+                16, [&](size_t inner) { visits[outer * 16 + inner]++; }, 1,
+                4);
+        },
+        1, 4);
+    for (auto& count : visits) ASSERT_EQ(count.load(), 1);
+}
+
+//------------------------------------------------------------------------------
+// Parallel sort
+//------------------------------------------------------------------------------
+
+TEST(ParallelSort, MatchesStdSort) {
+    std::mt19937 rng(3);
+    // Sizes below, at and well above the run size, with odd run counts
+    for (size_t size : {0, 100, 1 << 14, 100000, 300001}) {
+        for (size_t threads : {1, 3, 8}) {
+            std::vector<uint32_t> values(size);
+            for (auto& value : values) value = rng() % 1000;
+            auto expected = values;
+            std::sort(expected.begin(), expected.end());
+            parallel::parallel_sort(values.begin(), values.end(),
+                                    std::less<>{}, threads);
+            ASSERT_EQ(values, expected) << size << " " << threads;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Exclusive scan
+//------------------------------------------------------------------------------
+
+TEST(ExclusiveScan, MatchesSequentialPrefixSums) {
+    std::mt19937 rng(9);
+    for (size_t size : {0, 1, 1000, 300001}) {
+        for (size_t threads : {1, 3, 8}) {
+            std::vector<uint64_t> values(size);
+            for (auto& value : values) value = rng() % 100;
+            std::vector<uint64_t> expected(size);
+            uint64_t sum = 0;
+            for (size_t i = 0; i < size; i++) {
+                expected[i] = sum;
+                sum += values[i];
+            }
+            EXPECT_EQ(parallel::exclusive_scan(values.begin(), values.end(),
+                                               threads),
+                      sum);
+            ASSERT_EQ(values, expected) << size << " " << threads;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#include "utils/data_structures/persistent_vector.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using data_structures::containers::PersistentVector;
+
+//------------------------------------------------------------------------------
+// Persistent vector
+//------------------------------------------------------------------------------
+
+TEST(PersistentVector, PushBackAcrossLevels) {
+    // 32 * 32 * 5 elements need three levels
+    PersistentVector<int> vector;
+    EXPECT_TRUE(vector.empty());
+    for (int i = 0; i < 5000; i++) vector.push_back(i);
+
+    ASSERT_EQ(vector.size(), 5000u);
+    for (int i = 0; i < 5000; i++) ASSERT_EQ(vector[i], i);
+
+    std::vector<int> visited;
+    vector.for_each([&](int value) { visited.push_back(value); });
+    ASSERT_EQ(visited.size(), 5000u);
+    for (int i = 0; i < 5000; i++) ASSERT_EQ(visited[i], i);
+}
+
+TEST(PersistentVector, CopiesAreUnaffectedByEdits) {
+    PersistentVector<int> original;
+    for (int i = 0; i < 1100; i++) original.push_back(i);
+
+    auto edited = original;
+    edited.set(0, -1);
+    edited.update(1099, [](int& value) { value *= 2; });
+    edited.push_back(1100);
+
+    EXPECT_EQ(original.size(), 1100u);
+    EXPECT_EQ(original[0], 0);
+    EXPECT_EQ(original[1099], 1099);
+
+    EXPECT_EQ(edited.size(), 1101u);
+    EXPECT_EQ(edited[0], -1);
+    EXPECT_EQ(edited[1], 1);
+    EXPECT_EQ(edited[1099], 2198);
+    EXPECT_EQ(edited[1100], 1100);
+}
@@ -0,0 +1,90 @@
+#include "utils/data_structures/small_vector.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+
+using data_structures::containers::SmallVector;
+
+//------------------------------------------------------------------------------
+// Small vector
+//------------------------------------------------------------------------------
+
+TEST(SmallVector, SpillsToHeapPastInlineCapacity) {
+    SmallVector<int, 4> vector;
+    for (int i = 0; i < 4; i++) vector.push_back(i);
+    EXPECT_TRUE(vector.is_small());
+    EXPECT_EQ(vector.capacity(), 4u);
+
+    vector.push_back(4);
+    EXPECT_FALSE(vector.is_small());
+    EXPECT_EQ(vector.size(), 5u);
+    for (int i = 0; i < 5; i++) EXPECT_EQ(vector[i], i);
+
+    vector.clear();
+    EXPECT_TRUE(vector.empty());
+    EXPECT_GE(vector.capacity(), 5u);  // the capacity is kept
+}
+
+TEST(SmallVector, EraseKeepsOrder) {
+    SmallVector<int, 4> vector = {1, 2, 3, 2, 5};
+    vector.erase(std::remove(vector.begin(), vector.end(), 2), vector.end());
+    ASSERT_EQ(vector.size(), 3u);
+    EXPECT_EQ(vector[0], 1);
+    EXPECT_EQ(vector[1], 3);
+    EXPECT_EQ(vector.back(), 5);
+
+    vector.erase(vector.begin());
+    EXPECT_EQ(vector.front(), 3);
+    vector.pop_back();
+    EXPECT_EQ(vector.size(), 1u);
+}
+
+TEST(SmallVector, CopiesAndMovesElements) {
+    // non-trivial elements are constructed and destroyed exactly once
+    auto shared = std::make_shared<std::string>("edge");
+    {
+        SmallVector<std::shared_ptr<std::string>, 2> small;
+        small.push_back(shared);
+
+        SmallVector<std::shared_ptr<std::string>, 2> large;
+        for (int i = 0; i < 3; i++) large.push_back(shared);
+        EXPECT_EQ(shared.use_count(), 5);
+
+        auto small_copy = small;
+        auto large_copy = large;
+        EXPECT_EQ(shared.use_count(), 9);
+
+        auto small_moved = std::move(small_copy);
+        auto large_moved = std::move(large_copy);
+        EXPECT_TRUE(small_moved.is_small());
+        EXPECT_FALSE(large_moved.is_small());
+        EXPECT_EQ(shared.use_count(), 9);
+
+        small = std::move(large_moved);
+        EXPECT_EQ(small.size(), 3u);
+        EXPECT_EQ(shared.use_count(), 8);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(SmallVector, PushesItsOwnElementsWhileGrowing) {
+    const std::string first(40, 'a');  // long enough to live on the heap
+    const std::string last(40, 'z');
+    SmallVector<std::string, 2> vector = {first, last};
+
+    // the vector is full: both copy from storage that is about to move
+    vector.push_back(vector[0]);
+    ASSERT_EQ(vector.size(), 3u);
+    EXPECT_FALSE(vector.is_small());
+    EXPECT_EQ(vector[2], first);
+
+    vector.push_back(vector[1]);  // 4 of 4, no reallocation
+    vector.emplace_back(vector.back());
+    ASSERT_EQ(vector.size(), 5u);
+    EXPECT_EQ(vector[4], last);
+    EXPECT_EQ(vector[0], first);
+}
@@ -0,0 +1,78 @@
+#include "utils/spans.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+//------------------------------------------------------------------------------
+// Spans
+//------------------------------------------------------------------------------
+
+static auto read_file(const std::string& path) -> std::string {
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+TEST(Spans, WritesChromeTrace) {
+    { tracing::Span ignored("not_recorded"); }  // recording is off
+
+    tracing::start_span_recording();
+    {
+        tracing::Span span("outer", "test");
+        span.arg("answer", 42);
+    }
+    std::thread([] {
+        tracing::set_thread_name("worker");
+        tracing::Span span("on_worker", "test");
+    }).join();
+    tracing::stop_span_recording();
+
+    const std::string path = testing::TempDir() + "spans_test.json";
+    ASSERT_TRUE(tracing::write_chrome_trace(path));
+    const auto trace = read_file(path);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(trace.find("not_recorded"), std::string::npos);
+    EXPECT_NE(trace.find("\"name\": \"outer\", \"cat\": \"test\", \"ph\": "
+                         "\"X\""),
+              std::string::npos);
+    EXPECT_NE(trace.find("\"args\": {\"answer\": 42}"), std::string::npos);
+    EXPECT_NE(trace.find("\"name\": \"on_worker\""), std::string::npos);
+    EXPECT_NE(trace.find("\"args\": {\"name\": \"worker\"}"),
+              std::string::npos);
+}
+
+TEST(Spans, EachRecordingSessionStartsEmpty) {
+    const std::string path = testing::TempDir() + "spans_sessions_test.json";
+
+    tracing::start_span_recording();
+    { tracing::Span span("first_session", "test"); }
+    // fill the thread's buffer, later spans of this session are dropped
+    for (size_t i = 0; i < config::SPAN_BUFFER_CAPACITY; i++) {
+        tracing::Span span("filler", "test");
+    }
+    { tracing::Span span("dropped", "test"); }
+    tracing::stop_span_recording();
+    ASSERT_TRUE(tracing::write_chrome_trace(path));
+    auto trace = read_file(path);
+    EXPECT_NE(trace.find("\"name\": \"first_session\""), std::string::npos);
+    EXPECT_EQ(trace.find("\"name\": \"dropped\""), std::string::npos);
+
+    // a new session neither exports the old spans nor inherits the full
+    // buffer
+    tracing::start_span_recording();
+    { tracing::Span span("second_session", "test"); }
+    tracing::stop_span_recording();
+    ASSERT_TRUE(tracing::write_chrome_trace(path));
+    trace = read_file(path);
+    std::remove(path.c_str());
+    EXPECT_EQ(trace.find("\"name\": \"first_session\""), std::string::npos);
+    EXPECT_EQ(trace.find("\"name\": \"filler\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\": \"second_session\""), std::string::npos);
+}
@@ -0,0 +1,74 @@
+#include "utils/data_structures/spsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using data_structures::queue::SpscQueue;
+
+// -----------------------------------------------------------------------------
+// Single-producer / single-consumer queue
+// -----------------------------------------------------------------------------
+
+TEST(SpscQueue, PushPopInOrder) {
+    SpscQueue<int> queue(4);
+
+    EXPECT_EQ(queue.capacity(), 4);
+    EXPECT_TRUE(queue.empty());
+
+    // fill the queue, the fifth push should be rejected (never blocks)
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(4));
+    EXPECT_EQ(queue.size_approx(), 4);
+
+    int value = -1;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+}
+
+TEST(SpscQueue, CapacityRoundsUpToPowerOfTwo) {
+    SpscQueue<int> queue(5);
+    EXPECT_EQ(queue.capacity(), 8);
+}
+
+TEST(SpscQueue, DrainWrapsAround) {
+    SpscQueue<int> queue(4);
+
+    std::vector<int> drained;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 3; i++) queue.try_push(round * 3 + i);
+        queue.drain([&](int v) { drained.push_back(v); });
+    }
+
+    ASSERT_EQ(drained.size(), 9);
+    for (int i = 0; i < 9; i++) EXPECT_EQ(drained[i], i);
+}
+
+TEST(SpscQueue, ConcurrentProducerConsumer) {
+    // the consumer should observe every element exactly once, in order
+    static constexpr int kCount = 1'000'000;
+    SpscQueue<int> queue(1024);
+
+    std::thread producer([&] {
+        for (int i = 0; i < kCount; i++) {
+            while (!queue.try_push(i)) std::this_thread::yield();
+        }
+    });
+
+    int expected = 0;
+    while (expected < kCount) {
+        queue.drain([&](int v) {
+            EXPECT_EQ(v, expected);
+            expected++;
+        });
+    }
+
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
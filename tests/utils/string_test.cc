@@ -1,41 +1,141 @@
-
 #include "utils/data_structures/string.h"
 
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "utils/data_structures/intern.h"
+
+using data_structures::string::kSmallStringSize;
+using data_structures::string::String;
+
 // -----------------------------------------------------------------------------
-// Small string optimization (fbstring newtype)
+// Small string optimization
 // -----------------------------------------------------------------------------
 
-TEST(FbString, SmallStringOptimization) {
-    // fbstring is a newtype wrapper (facade) around std::string that uses small
-    // string optimization (SSO) to avoid heap allocations for small strings.
-    // This test checks that the SSO works as expected.
+TEST(String, SmallStringOptimization) {
+    // strings up to `kSmallStringSize` characters are stored inline
+    auto small_string = String::from("hello world");
+    EXPECT_TRUE(small_string.is_small());
+    EXPECT_EQ(small_string, "hello world");
+    EXPECT_EQ(small_string.size(), 11u);
 
-    // create a string that is small enough to fit in the SSO buffer
-    using String = data_structures::string::String;
+    const std::string exactly_small(kSmallStringSize, 'x');
+    EXPECT_TRUE(String::from(exactly_small).is_small());
 
-    auto small_string = String::from("hello world");
+    // longer ones are allocated on the heap
+    auto big_string =
+        String::from("hello world hello world hello world hello world");
+    EXPECT_FALSE(big_string.is_small());
+    EXPECT_EQ(big_string.size(), 47u);
+    EXPECT_STREQ(big_string.c_str(),
+                 "hello world hello world hello world hello world");
+}
+
+TEST(String, FromRespectsSize) {
+    EXPECT_EQ(String::from("hello world", 5), "hello");
+    EXPECT_EQ(String::from(std::string("hello world"), 5), "hello");
+    EXPECT_EQ(String::from(std::string("hi"), 5), "hi");
+    EXPECT_STREQ(String::from("hello world", 5).c_str(), "hello");
+}
 
-    // // create a fbstring from the small string
-    // fbstring fbstring_from_small_string = small_string;
+TEST(String, CopyMoveAndAppend) {
+    String string = "abc";
+    for (int i = 0; i < 20; i++) string += "def";
+    EXPECT_FALSE(string.is_small());
+    EXPECT_EQ(string.size(), 63u);
 
-    // check that the fbstring is using the SSO buffer
-    // EXPECT_TRUE(fbstring_from_small_string.is_small());
+    String copy = string;
+    EXPECT_EQ(copy, string);
 
-    // // create a string that is too big to fit in the SSO buffer
-    // std::string big_string = "hello world hello world hello world hello
-    // world";
+    String moved = std::move(copy);
+    EXPECT_EQ(moved, string);
+    EXPECT_TRUE(copy.empty());  // NOLINT(bugprone-use-after-move)
+
+    String small = "small";
+    small = moved;
+    EXPECT_EQ(small, string);
+    small = String("small again");
+    EXPECT_EQ(small, "small again");
+
+    std::unordered_set<String> set = {String("a"), String("b"), String("a")};
+    EXPECT_EQ(set.size(), 2u);
+}
 
-    // // create a fbstring from the big string
-    // fbstring fbstring_from_big_string = big_string;
+TEST(String, AppendToItself) {
+    // a small string that outgrows the inline buffer
+    const std::string small_chars = "abcdefghijklmnopqrstuvwxyz";
+    auto small = String::from(small_chars);
+    ASSERT_TRUE(small.is_small());
+    small.append(small);
+    EXPECT_FALSE(small.is_small());
+    EXPECT_EQ(small.view(), small_chars + small_chars);
 
-    // // check that the fbstring is not using the SSO buffer
-    // EXPECT_FALSE(fbstring_from_big_string.is_small());
+    // a heap string that has to reallocate
+    const std::string heap_chars(40, 'h');
+    auto heap = String::from(heap_chars + "!");
+    ASSERT_FALSE(heap.is_small());
+    heap.append(heap);
+    EXPECT_EQ(heap.view(), heap_chars + "!" + heap_chars + "!");
+
+    // part of itself, without reallocating
+    heap.reserve(heap.size() + 10);
+    heap.append(heap.view().substr(heap.size() - 3));
+    EXPECT_EQ(heap.size(), 85u);
+    EXPECT_STREQ(heap.c_str() + heap.size() - 6, "hh!hh!");
+}
+
+TEST(String, RejectsSizesPastMaxSize) {
+    // sizes are 32-bit, so longer strings throw instead of wrapping
+    auto str = String::from("unchanged");
+    EXPECT_THROW(str.reserve(String::max_size() + 1), std::length_error);
+    EXPECT_EQ(str.view(), "unchanged");
+    EXPECT_TRUE(str.is_small());
+}
+
+// -----------------------------------------------------------------------------
+// Interning
+// -----------------------------------------------------------------------------
+
+TEST(Intern, EqualStringsShareSymbols) {
+    data_structures::string::SymbolTable table;
+    const auto a = table.intern("assets/node.png");
+    const auto b = table.intern(std::string("assets/") + "node.png");
+    const auto c = table.intern("assets/edge.png");
+
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(table.str(a), "assets/node.png");
+    EXPECT_EQ(table.intern(""), data_structures::string::Symbol{0});
+    EXPECT_EQ(table.find("assets/edge.png"), c);
+    EXPECT_FALSE(table.find("missing").has_value());
+
+    // strings larger than a block get their own
+    const std::string huge(table.kBlockSize * 2, 'x');
+    EXPECT_EQ(table.str(table.intern(huge)), huge);
+    EXPECT_EQ(table.str(table.intern("after")), "after");
+}
 
-    // drop-in replacement for std::string
-    // (i.e. same api, same behavior, same performance)
+TEST(Intern, ConcurrentInterning) {
+    data_structures::string::SymbolTable table;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<data_structures::string::Symbol>> symbols(4);
+    for (size_t t = 0; t < symbols.size(); t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 1000; i++) {
+                symbols[t].push_back(table.intern(std::to_string(i)));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
 
-    // create a string
-    // std::string string = "hello world";
+    EXPECT_EQ(table.size(), 1001u);  // including the empty string
+    for (const auto& thread_symbols : symbols) {
+        EXPECT_EQ(thread_symbols, symbols[0]);
+    }
 }
@@ -2,6 +2,12 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
 using tracing::debug;
 using tracing::debug_enabled;
 using tracing::error;
@@ -53,3 +59,95 @@ TEST(TracingLevels, Trace) {
     EXPECT_NE(output.find("error"), std::string::npos)
         << "error should be logged";
 }
+
+/// @brief Counts how many times it is formatted.
+struct Counted {
+    int* count;
+};
+
+template <>
+struct fmt::formatter<Counted> : fmt::formatter<int> {
+    auto format(const Counted& counted, format_context& ctx) const {
+        return fmt::formatter<int>::format(++*counted.count, ctx);
+    }
+};
+
+TEST(TracingLevels, FormatsLazily) {
+    set_log_level(tracing::LVL_INFO);
+    int count = 0;
+
+    testing::internal::CaptureStdout();
+    trace("trace {}", Counted{&count});  // should not be formatted
+    debug("debug {}", Counted{&count});  // should not be formatted
+    info("info {}", Counted{&count});
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(count, 1) << "disabled levels should not format arguments";
+    EXPECT_NE(output.find("info 1"), std::string::npos);
+}
+
+TEST(TracingAsync, WritesOnBackgroundThread) {
+    set_log_level(tracing::LVL_INFO);
+
+    testing::internal::CaptureStdout();
+
+    tracing::start_async_logging();
+    trace("async trace");  // should not be logged
+    info("async info");
+    std::thread([] { warn("async warn"); }).join();
+    tracing::flush_logs();
+    tracing::stop_async_logging();
+
+    // messages logged after stopping are written synchronously again
+    error("sync error");
+
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(output.find("async trace"), std::string::npos);
+    EXPECT_NE(output.find("async info"), std::string::npos);
+    EXPECT_NE(output.find("async warn"), std::string::npos);
+    EXPECT_LT(output.find("async warn"), output.find("sync error"));
+}
+
+/// @brief Counts the messages written to it.
+class CountingSink : public tracing::LogSink {
+   public:
+    explicit CountingSink(std::atomic<size_t>& count) : count_(count) {}
+
+    auto write(std::span<const tracing::LogRecord> records) -> void override {
+        count_.fetch_add(records.size(), std::memory_order_relaxed);
+    }
+
+   private:
+    std::atomic<size_t>& count_;
+};
+
+TEST(TracingAsync, StopRacingLoggersLosesNothing) {
+    constexpr size_t kThreads = 4;
+    constexpr size_t kMessages = 200;
+    std::atomic<size_t> written{0};
+    tracing::AsyncWriter writer;
+    std::vector<std::unique_ptr<tracing::LogSink>> sinks;
+    sinks.push_back(std::make_unique<CountingSink>(written));
+    writer.set_sinks(std::move(sinks));
+
+    for (size_t round = 0; round < 50; round++) {
+        written.store(0);
+        writer.start();
+        std::vector<std::thread> loggers;
+        for (size_t t = 0; t < kThreads; t++) {
+            loggers.emplace_back([&] {
+                for (size_t i = 0; i < kMessages; i++) {
+                    writer.write(tracing::make_record(tracing::LVL_INFO, "m"));
+                }
+            });
+        }
+        // stop while the loggers are (likely) still going: messages either
+        // make it into the final drain or are written synchronously
+        writer.stop();
+        for (auto& logger : loggers) logger.join();
+
+        EXPECT_EQ(written.load(), kThreads * kMessages);
+        writer.flush();  // must not wait for a message that was never written
+    }
+}
@@ -0,0 +1,89 @@
+#include "utils/data_structures/union_find.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using data_structures::sets::ConcurrentUnionFind;
+using data_structures::sets::UnionFind;
+
+//------------------------------------------------------------------------------
+// Union-find
+//------------------------------------------------------------------------------
+
+TEST(UnionFind, StartsWithSingletons) {
+    UnionFind sets(5);
+    EXPECT_EQ(sets.size(), 5u);
+    EXPECT_EQ(sets.num_sets(), 5u);
+    for (uint32_t i = 0; i < 5; i++) EXPECT_EQ(sets.find(i), i);
+}
+
+TEST(UnionFind, MatchesNaiveLabels) {
+    // Naive partition: relabel the whole set on every union
+    constexpr uint32_t kSize = 1000;
+    std::vector<uint32_t> labels(kSize);
+    for (uint32_t i = 0; i < kSize; i++) labels[i] = i;
+    UnionFind sets(kSize);
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> element(0, kSize - 1);
+    size_t num_sets = kSize;
+    for (int i = 0; i < 2000; i++) {
+        const auto a = element(rng);
+        const auto b = element(rng);
+        const auto merged = labels[a] != labels[b];
+        ASSERT_EQ(sets.unite(a, b), merged);
+        if (merged) {
+            const auto old_label = labels[b];
+            for (auto& label : labels) {
+                if (label == old_label) label = labels[a];
+            }
+            num_sets--;
+        }
+        const auto c = element(rng);
+        const auto d = element(rng);
+        ASSERT_EQ(sets.same(c, d), labels[c] == labels[d]);
+    }
+    EXPECT_EQ(sets.num_sets(), num_sets);
+}
+
+//------------------------------------------------------------------------------
+// Concurrent union-find
+//------------------------------------------------------------------------------
+
+TEST(ConcurrentUnionFind, MatchesSequentialUnions) {
+    constexpr uint32_t kSize = 20000;
+    std::vector<std::pair<uint32_t, uint32_t>> unions;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint32_t> element(0, kSize - 1);
+    for (int i = 0; i < 15000; i++) {
+        unions.emplace_back(element(rng), element(rng));
+    }
+
+    UnionFind expected(kSize);
+    for (auto [a, b] : unions) expected.unite(a, b);
+
+    ConcurrentUnionFind sets(kSize);
+    std::atomic<size_t> merges{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < unions.size(); i += 4) {
+                if (sets.unite(unions[i].first, unions[i].second)) merges++;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(kSize - merges.load(), expected.num_sets());
+    for (uint32_t i = 0; i < kSize; i++) {
+        const auto root = expected.find(i);
+        ASSERT_TRUE(sets.same(i, root));
+        // The representative is the smallest element of the set
+        ASSERT_LE(sets.find(i), i);
+    }
+}